@@ -0,0 +1,11 @@
+INCLUDE (FindPackageHandleStandardArgs)
+
+FIND_PATH(URING_INCLUDE_DIRS liburing.h)
+FIND_LIBRARY(URING_LIBRARIES NAMES uring)
+
+# handle the QUIETLY and REQUIRED arguments and set URING_FOUND to TRUE
+find_package_handle_standard_args(URING DEFAULT_MSG URING_LIBRARIES URING_INCLUDE_DIRS)
+
+MARK_AS_ADVANCED(
+    URING_LIBRARIES
+    URING_INCLUDE_DIRS )
@@ -29,11 +29,129 @@
 
 /// \file action_request.cc
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+
 #include "action_request.h"
 
 using namespace zmm;
 using namespace mxml;
 
+/// \brief Copies an IXML element into an mxml element, without printing
+/// and parsing the request again.
+static Ref<Element> ixmlToElement(IXML_Node* node)
+{
+    Ref<Element> el(new Element(ixmlNode_getNodeName(node)));
+
+    IXML_NamedNodeMap* attrs = ixmlNode_getAttributes(node);
+    if (attrs != nullptr)
+    {
+        unsigned long len = ixmlNamedNodeMap_getLength(attrs);
+        for (unsigned long i = 0; i < len; i++)
+        {
+            IXML_Node* attr = ixmlNamedNodeMap_item(attrs, i);
+            el->setAttribute(ixmlNode_getNodeName(attr), ixmlNode_getNodeValue(attr));
+        }
+        ixmlNamedNodeMap_free(attrs);
+    }
+
+    for (IXML_Node* child = ixmlNode_getFirstChild(node); child != nullptr;
+         child = ixmlNode_getNextSibling(child))
+    {
+        switch (ixmlNode_getNodeType(child))
+        {
+            case eELEMENT_NODE:
+                el->appendElementChild(ixmlToElement(child));
+                break;
+            case eTEXT_NODE:
+            case eCDATA_SECTION_NODE:
+            {
+                Ref<Text> text(new Text(ixmlNode_getNodeValue(child)));
+                el->appendChild(RefCast(text, Node));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return el;
+}
+
+static inline bool isControlChar(signed char c)
+{
+    return ((c >= 0x00) && (c <= 0x1f) && (c != 0x09) && (c != 0x0d) && (c != 0x0a)) || (c == 0x7f);
+}
+
+/// \brief Replaces control characters like Node::escape() does, the
+/// entities are taken care of by IXML.
+static String ixmlSafeText(String str)
+{
+    if (str == nullptr)
+        return _("");
+
+    const char* data = str.c_str();
+    int len = str.length();
+    int i = 0;
+    while (i < len && ! isControlChar(data[i]))
+        i++;
+    if (i == len)
+        return str;
+
+    std::string safe(data, len);
+    for (; i < len; i++)
+    {
+        if (isControlChar(safe[i]))
+            safe[i] = '.';
+    }
+    return String(safe.data(), safe.size());
+}
+
+/// \brief Copies an mxml element into an IXML document.
+static bool elementToIxml(IXML_Document* doc, IXML_Node* parent, Ref<Element> el)
+{
+    IXML_Element* node;
+    if (ixmlDocument_createElementEx(doc, el->getName().c_str(), &node) != IXML_SUCCESS)
+        return false;
+    if (ixmlNode_appendChild(parent, (IXML_Node*)node) != IXML_SUCCESS)
+    {
+        ixmlElement_free(node);
+        return false;
+    }
+
+    for (int i = 0; i < el->attributeCount(); i++)
+    {
+        Ref<Attribute> attr = el->getAttribute(i);
+        if (ixmlElement_setAttribute(node, attr->name.c_str(),
+                ixmlSafeText(attr->value).c_str()) != IXML_SUCCESS)
+            return false;
+    }
+
+    for (int i = 0; i < el->childCount(); i++)
+    {
+        Ref<Node> child = el->getChild(i);
+        if (child->getType() == mxml_node_element)
+        {
+            if (! elementToIxml(doc, (IXML_Node*)node, RefCast(child, Element)))
+                return false;
+        }
+        else if (child->getType() == mxml_node_text)
+        {
+            IXML_Node* text;
+            String value = ixmlSafeText(RefCast(child, Text)->getText());
+            if (ixmlDocument_createTextNodeEx(doc, value.c_str(), &text) != IXML_SUCCESS)
+                return false;
+            if (ixmlNode_appendChild((IXML_Node*)node, text) != IXML_SUCCESS)
+            {
+                ixmlNode_free(text);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 ActionRequest::ActionRequest(UpnpActionRequest *upnp_request) : Object(),
     upnp_request(upnp_request),
     errCode(UPNP_E_SUCCESS),
@@ -41,13 +159,14 @@ ActionRequest::ActionRequest(UpnpActionRequest *upnp_request) : Object(),
     UDN(UpnpActionRequest_get_DevUDN_cstr(upnp_request)),
     serviceID(UpnpActionRequest_get_ServiceID_cstr(upnp_request))
 {
-    DOMString cxml = ixmlPrintDocument(UpnpActionRequest_get_ActionRequest(upnp_request));
-    String xml = cxml;
-    ixmlFreeDOMString(cxml);
-
-    Ref<Parser> parser(new Parser());
+    auto doc = (IXML_Node *)UpnpActionRequest_get_ActionRequest(upnp_request);
+    IXML_Node* root = ixmlNode_getFirstChild(doc);
+    while (root != nullptr && ixmlNode_getNodeType(root) != eELEMENT_NODE)
+        root = ixmlNode_getNextSibling(root);
+    if (root == nullptr)
+        throw _Exception(_("action request without an action element"));
 
-    request = parser->parseString(xml)->getRoot();
+    request = ixmlToElement(root);
 }
 
 String ActionRequest::getActionName()
@@ -62,6 +181,22 @@ String ActionRequest::getServiceID()
 {
     return serviceID;
 }
+String ActionRequest::getClientAddress()
+{
+    auto addr = UpnpActionRequest_get_CtrlPtIPAddr(upnp_request);
+    if (addr == nullptr)
+        return nullptr;
+
+    char buf[INET6_ADDRSTRLEN];
+    const char* res = nullptr;
+    if (addr->ss_family == AF_INET)
+        res = inet_ntop(AF_INET, &((const struct sockaddr_in*)addr)->sin_addr, buf, sizeof(buf));
+    else if (addr->ss_family == AF_INET6)
+        res = inet_ntop(AF_INET6, &((const struct sockaddr_in6*)addr)->sin6_addr, buf, sizeof(buf));
+    if (res == nullptr)
+        return nullptr;
+    return String(res);
+}
 Ref<Element> ActionRequest::getRequest()
 {
     return request;
@@ -80,19 +215,19 @@ void ActionRequest::update()
 {
     if(response != nullptr)
     {
-        String xml = response->print();
-        int ret;
-
-        log_debug("ActionRequest::update(): \n%s\n\n", xml.c_str());
-
-        IXML_Document *result = ixmlDocument_createDocument();
-        ret = ixmlParseBufferEx(xml.c_str(), &result);
+        // build the result document directly instead of printing the
+        // response and parsing it again
+        IXML_Document *result = nullptr;
+        bool ok = (ixmlDocument_createDocumentEx(&result) == IXML_SUCCESS)
+            && elementToIxml(result, (IXML_Node *)result, response);
 
-        if (ret != IXML_SUCCESS)
+        if (! ok)
         {
             log_error("ActionRequest::update(): could not convert to iXML\n");
-            log_debug("Dump:\n%s\n", xml.c_str());
+            log_debug("Dump:\n%s\n", response->print().c_str());
 
+            if (result != nullptr)
+                ixmlDocument_free(result);
             UpnpActionRequest_set_ErrCode(upnp_request, UPNP_E_ACTION_FAILED);
         } 
         else
@@ -92,6 +92,10 @@ public:
     /// \brief Returns the ID of the service (the action is for this service id)
     zmm::String getServiceID();
 
+    /// \brief Returns the IP address of the control point that sent the
+    /// request, nullptr if unknown
+    zmm::String getClientAddress();
+
     /// \brief Returns the XML representation of the request.
     zmm::Ref<mxml::Element> getRequest();
 
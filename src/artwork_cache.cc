@@ -0,0 +1,381 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    artwork_cache.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file artwork_cache.cc
+/// \brief Implementation of the ArtworkCache class.
+
+#include "artwork_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+#include <vector>
+
+#include "config_manager.h"
+#include "mem_io_handler.h"
+#include "tools.h"
+
+/// \brief "GAC1" - bump when the on-disk entry layout changes
+#define ARTWORK_CACHE_MAGIC 0x31434147
+/// \brief a single entry may use at most this fraction of a tier
+#define ARTWORK_CACHE_ENTRY_FRACTION 4
+#define ARTWORK_CACHE_READ_CHUNK 65536
+
+using namespace zmm;
+using namespace std;
+
+static bool writeUInt64(FILE* f, uint64_t value)
+{
+    return fwrite(&value, sizeof(value), 1, f) == 1;
+}
+
+static bool readUInt64(FILE* f, uint64_t* value)
+{
+    return fread(value, sizeof(*value), 1, f) == 1;
+}
+
+static bool writeBytes(FILE* f, const string& str)
+{
+    if (!writeUInt64(f, str.size()))
+        return false;
+    return str.empty() || (fwrite(str.data(), 1, str.size(), f) == str.size());
+}
+
+static bool readBytes(FILE* f, string& str, uint64_t max)
+{
+    uint64_t len;
+    if (!readUInt64(f, &len) || len > max)
+        return false;
+    str.resize(len);
+    return len == 0 || (fread(&str[0], 1, len, f) == len);
+}
+
+// size of the entry file, used for the disk usage accounting
+static inline size_t getDiskSize(const shared_ptr<string>& data, const string& location)
+{
+    return 5 * sizeof(uint64_t) + location.size() + data->size();
+}
+
+static inline bool sameTime(const struct timespec* a, const struct timespec* b)
+{
+    return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+ArtworkCache::ArtworkCache()
+    : Singleton<ArtworkCache>()
+    , enabled(false)
+    , memoryLimit(0)
+    , memoryUsed(0)
+    , diskLimit(0)
+    , diskUsed(0)
+    , hits(0)
+    , misses(0)
+{
+}
+
+void ArtworkCache::init()
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    enabled = cfg->getBoolOption(CFG_SERVER_ARTWORK_CACHE_ENABLED);
+    if (!enabled)
+        return;
+
+    memoryLimit = (size_t)cfg->getIntOption(CFG_SERVER_ARTWORK_CACHE_MEMORY_SIZE) * 1024 * 1024;
+    diskLimit = (size_t)cfg->getIntOption(CFG_SERVER_ARTWORK_CACHE_DISK_SIZE) * 1024 * 1024;
+
+    if (diskLimit > 0) {
+        cacheDir = cfg->getOption(CFG_SERVER_ARTWORK_CACHE_DIR);
+        if (!string_ok(cacheDir))
+            cacheDir = cfg->getOption(CFG_SERVER_HOME) + DIR_SEPARATOR + DEFAULT_ARTWORK_CACHE_DIR;
+
+        if (mkdir(cacheDir.c_str(), 0777) < 0 && errno != EEXIST) {
+            log_error("Could not create artwork cache directory %s: %s\n",
+                cacheDir.c_str(), mt_strerror(errno).c_str());
+            diskLimit = 0;
+        } else
+            loadDiskIndex();
+    }
+
+    if (memoryLimit == 0 && diskLimit == 0)
+        enabled = false;
+}
+
+void ArtworkCache::shutdown()
+{
+    if (enabled)
+        log_debug("artwork cache hits: %ld, misses: %ld\n", getHits(), getMisses());
+}
+
+Ref<IOHandler> ArtworkCache::serveContent(Ref<MetadataHandler> handler,
+    Ref<CdsItem> item, int resNum, int handlerType, off_t* data_size)
+{
+    struct stat statbuf;
+    if (!enabled || stat(item->getLocation().c_str(), &statbuf) != 0)
+        return handler->serveContent(item, resNum, data_size);
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%d-%d-%d", item->getID(), resNum, handlerType);
+    string key(buf);
+    string location(item->getLocation().c_str());
+    struct timespec* mtime = &statbuf.st_mtim;
+
+    Data data = getMemory(key, mtime, location);
+    if (data == nullptr && diskLimit > 0) {
+        data = getDisk(key, mtime, location);
+        if (data != nullptr)
+            putMemory(key, data, mtime, location);
+    }
+
+    if (data != nullptr) {
+        hits++;
+        *data_size = data->size();
+        return Ref<IOHandler>(new MemIOHandler(data->data(), data->size()));
+    }
+
+    misses++;
+    Ref<IOHandler> h = handler->serveContent(item, resNum, data_size);
+    // unknown length means streamed from a file, nothing to extract
+    size_t maxEntry = max(memoryLimit, diskLimit) / ARTWORK_CACHE_ENTRY_FRACTION;
+    if (h == nullptr || *data_size < 0 || (size_t)*data_size > maxEntry)
+        return h;
+
+    data = make_shared<string>();
+    data->reserve(*data_size);
+    char chunk[ARTWORK_CACHE_READ_CHUNK];
+    h->open(UPNP_READ);
+    int bytes;
+    while ((bytes = h->read(chunk, sizeof(chunk))) > 0)
+        data->append(chunk, bytes);
+    h->close();
+
+    // a failed or short read must not be cached for good, the request
+    // gets a fresh handler and the next one tries again
+    if (bytes < 0 || data->size() != (size_t)*data_size) {
+        log_warning("Could not read artwork of %s (%ld of %ld bytes), not caching it\n",
+            location.c_str(), (long)data->size(), (long)*data_size);
+        return handler->serveContent(item, resNum, data_size);
+    }
+
+    putMemory(key, data, mtime, location);
+    if (diskLimit > 0)
+        putDisk(key, data, mtime, location);
+
+    *data_size = data->size();
+    return Ref<IOHandler>(new MemIOHandler(data->data(), data->size()));
+}
+
+ArtworkCache::Data ArtworkCache::getMemory(const string& key, struct timespec* mtime, const string& location)
+{
+    AutoLock lock(mutex);
+    auto it = memory.find(key);
+    if (it == memory.end())
+        return nullptr;
+
+    if (!sameTime(&it->second.mtime, mtime) || it->second.location != location) {
+        eraseMemory(key);
+        return nullptr;
+    }
+
+    memoryLru.splice(memoryLru.begin(), memoryLru, it->second.lru);
+    return it->second.data;
+}
+
+void ArtworkCache::putMemory(const string& key, Data data, struct timespec* mtime, const string& location)
+{
+    if (data->size() > memoryLimit / ARTWORK_CACHE_ENTRY_FRACTION)
+        return;
+
+    AutoLock lock(mutex);
+    eraseMemory(key);
+
+    memoryLru.push_front(key);
+    MemoryEntry& entry = memory[key];
+    entry.data = data;
+    entry.mtime = *mtime;
+    entry.location = location;
+    entry.lru = memoryLru.begin();
+    memoryUsed += data->size();
+
+    while (memoryUsed > memoryLimit && !memoryLru.empty())
+        eraseMemory(memoryLru.back());
+}
+
+void ArtworkCache::eraseMemory(const string& key)
+{
+    auto it = memory.find(key);
+    if (it == memory.end())
+        return;
+    memoryUsed -= it->second.data->size();
+    memoryLru.erase(it->second.lru);
+    memory.erase(it);
+}
+
+String ArtworkCache::getEntryPath(const string& key)
+{
+    return cacheDir + DIR_SEPARATOR + key.c_str();
+}
+
+ArtworkCache::Data ArtworkCache::getDisk(const string& key, struct timespec* mtime, const string& location)
+{
+    {
+        AutoLock lock(mutex);
+        if (disk.find(key) == disk.end())
+            return nullptr;
+    }
+
+    String path = getEntryPath(key);
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+        return nullptr;
+
+    uint64_t magic, sec, nsec;
+    string storedLocation;
+    Data data = make_shared<string>();
+    bool ok = readUInt64(f, &magic) && magic == ARTWORK_CACHE_MAGIC
+        && readUInt64(f, &sec) && readUInt64(f, &nsec)
+        && readBytes(f, storedLocation, PATH_MAX)
+        && readBytes(f, *data, diskLimit);
+    fclose(f);
+
+    // a stale entry is overwritten by the next store anyway
+    if (!ok || (time_t)sec != mtime->tv_sec || (long)nsec != mtime->tv_nsec
+        || storedLocation != location)
+        return nullptr;
+
+    AutoLock lock(mutex);
+    touchDisk(key, getDiskSize(data, location));
+    return data;
+}
+
+void ArtworkCache::putDisk(const string& key, Data data, struct timespec* mtime, const string& location)
+{
+    if (data->size() > diskLimit / ARTWORK_CACHE_ENTRY_FRACTION)
+        return;
+
+    String path = getEntryPath(key);
+    // concurrent requests may store the same key, each writes its own file
+    String part = path + ".XXXXXX";
+    int fd = mkstemp(const_cast<char*>(part.c_str()));
+    if (fd < 0) {
+        log_debug("could not create %s: %s\n", part.c_str(), mt_strerror(errno).c_str());
+        return;
+    }
+    FILE* f = fdopen(fd, "wb");
+    if (!f) {
+        close(fd);
+        unlink(part.c_str());
+        return;
+    }
+
+    bool ok = writeUInt64(f, ARTWORK_CACHE_MAGIC)
+        && writeUInt64(f, mtime->tv_sec) && writeUInt64(f, mtime->tv_nsec)
+        && writeBytes(f, location)
+        && writeBytes(f, *data);
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(part.c_str(), path.c_str()) != 0) {
+        log_debug("could not write artwork cache entry %s\n", path.c_str());
+        unlink(part.c_str());
+        return;
+    }
+
+    AutoLock lock(mutex);
+    touchDisk(key, getDiskSize(data, location));
+    evictDisk();
+}
+
+void ArtworkCache::evictDisk()
+{
+    while (diskUsed > diskLimit && diskLru.size() > 1) {
+        string victim = diskLru.back();
+        diskUsed -= disk[victim].size;
+        disk.erase(victim);
+        diskLru.pop_back();
+        unlink(getEntryPath(victim).c_str());
+    }
+}
+
+void ArtworkCache::touchDisk(const string& key, size_t size)
+{
+    auto it = disk.find(key);
+    if (it != disk.end()) {
+        diskUsed -= it->second.size;
+        diskLru.splice(diskLru.begin(), diskLru, it->second.lru);
+    } else {
+        diskLru.push_front(key);
+        it = disk.emplace(key, DiskEntry()).first;
+        it->second.lru = diskLru.begin();
+    }
+    it->second.size = size;
+    diskUsed += size;
+}
+
+void ArtworkCache::loadDiskIndex()
+{
+    DIR* dir = opendir(cacheDir.c_str());
+    if (!dir)
+        return;
+
+    // the last access is not recorded on disk, the modification time of
+    // the entry is the best guess for the order after a restart
+    vector<pair<time_t, pair<string, size_t>>> entries;
+    struct dirent* dent;
+    while ((dent = readdir(dir)) != nullptr) {
+        if (dent->d_name[0] == '.')
+            continue;
+        String path = cacheDir + DIR_SEPARATOR + dent->d_name;
+        struct stat statbuf;
+        if (stat(path.c_str(), &statbuf) != 0 || !S_ISREG(statbuf.st_mode))
+            continue;
+        // leftover of an interrupted store
+        if (strchr(dent->d_name, '.')) {
+            unlink(path.c_str());
+            continue;
+        }
+        entries.push_back(make_pair(statbuf.st_mtime, make_pair(string(dent->d_name), (size_t)statbuf.st_size)));
+    }
+    closedir(dir);
+
+    sort(entries.begin(), entries.end(),
+        [](const pair<time_t, pair<string, size_t>>& a, const pair<time_t, pair<string, size_t>>& b) {
+            return a.first > b.first;
+        });
+
+    // called from init(), no other thread can see the cache yet
+    for (auto& entry : entries) {
+        diskLru.push_back(entry.second.first);
+        DiskEntry& de = disk[entry.second.first];
+        de.size = entry.second.second;
+        de.lru = prev(diskLru.end());
+        diskUsed += de.size;
+    }
+    evictDisk();
+    log_debug("artwork cache: %d entries, %ld bytes on disk\n", (int)disk.size(), (long)diskUsed);
+}
@@ -0,0 +1,124 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    artwork_cache.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file artwork_cache.h
+/// \brief Definition of the ArtworkCache class.
+
+#ifndef __ARTWORK_CACHE_H__
+#define __ARTWORK_CACHE_H__
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+
+#include "cds_objects.h"
+#include "common.h"
+#include "io_handler.h"
+#include "metadata_handler.h"
+#include "singleton.h"
+
+/// \brief Two tier cache for the content served by MetadataHandlers.
+///
+/// Album art, exif thumbnails and video thumbnails are extracted from the
+/// media file on every request. The extracted data is kept in a size
+/// bounded in-memory LRU and, below that, in a size bounded directory on
+/// disk with LRU eviction. Entries are keyed by object ID, resource ID
+/// and handler, and validated against the modification time of the
+/// media file.
+class ArtworkCache : public Singleton<ArtworkCache>
+{
+public:
+    ArtworkCache();
+    virtual void init() override;
+    virtual void shutdown() override;
+    zmm::String getName() override { return _("Artwork Cache"); }
+
+    /// \brief Serves a resource through the cache.
+    ///
+    /// On a miss the handler is asked for the content. Content of unknown
+    /// size, like an image file served as is, is passed through uncached.
+    /// \param handler the handler that owns the resource
+    /// \param item the item the resource belongs to
+    /// \param resNum resource ID
+    /// \param handlerType handler ID of the resource
+    /// \param data_size set to the content length, -1 if unknown
+    zmm::Ref<IOHandler> serveContent(zmm::Ref<MetadataHandler> handler,
+        zmm::Ref<CdsItem> item, int resNum, int handlerType, off_t* data_size);
+
+    inline long getHits() { return hits; }
+    inline long getMisses() { return misses; }
+
+protected:
+    typedef std::shared_ptr<std::string> Data;
+
+    struct MemoryEntry {
+        Data data;
+        struct timespec mtime;
+        std::string location;
+        std::list<std::string>::iterator lru;
+    };
+
+    struct DiskEntry {
+        size_t size;
+        std::list<std::string>::iterator lru;
+    };
+
+    bool enabled;
+    zmm::String cacheDir;
+
+    size_t memoryLimit;
+    size_t memoryUsed;
+    /// \brief most recently used key in front
+    std::list<std::string> memoryLru;
+    std::unordered_map<std::string, MemoryEntry> memory;
+
+    size_t diskLimit;
+    size_t diskUsed;
+    std::list<std::string> diskLru;
+    std::unordered_map<std::string, DiskEntry> disk;
+
+    std::atomic<long> hits;
+    std::atomic<long> misses;
+
+    Data getMemory(const std::string& key, struct timespec* mtime, const std::string& location);
+    void putMemory(const std::string& key, Data data, struct timespec* mtime, const std::string& location);
+    void eraseMemory(const std::string& key);
+
+    Data getDisk(const std::string& key, struct timespec* mtime, const std::string& location);
+    void putDisk(const std::string& key, Data data, struct timespec* mtime, const std::string& location);
+    void touchDisk(const std::string& key, size_t size);
+    void evictDisk();
+    void loadDiskIndex();
+
+    zmm::String getEntryPath(const std::string& key);
+};
+
+#endif // __ARTWORK_CACHE_H__
@@ -39,6 +39,7 @@ using namespace std;
 AutoscanDirectory::AutoscanDirectory()
 {
     taskCount = 0;
+    fanotify = false;
     objectID = INVALID_OBJECT_ID;
     storageID = INVALID_OBJECT_ID;
     last_mod_previous_scan = 0;
@@ -54,6 +55,7 @@ AutoscanDirectory::AutoscanDirectory(String location, ScanMode mode,
     , level(level)
     , recursive(recursive)
     , hidden(hidden)
+    , fanotify(false)
     , persistent_flag(persistent)
     , interval(interval)
     , taskCount(0)
@@ -351,6 +353,7 @@ void AutoscanDirectory::copyTo(Ref<AutoscanDirectory> copy)
     copy->level = level;
     copy->recursive = recursive;
     copy->hidden = hidden;
+    copy->fanotify = fanotify;
     copy->persistent_flag = persistent_flag;
     copy->interval = interval;
     copy->taskCount = taskCount;
@@ -171,6 +171,11 @@ public:
 
     void setRecursive(bool recursive) { this->recursive = recursive; }
 
+    /// \brief Monitor the directory with a fanotify filesystem mark instead
+    /// of per-directory inotify watches (inotify scan mode only).
+    void setFanotify(bool fanotify) { this->fanotify = fanotify; }
+    bool getFanotify() { return fanotify; }
+
     unsigned int getInterval() { return interval; }
 
     void setInterval(unsigned int interval) { this->interval = interval; }
@@ -250,6 +255,7 @@ protected:
     ScanLevel level;
     bool recursive;
     bool hidden;
+    bool fanotify;
     bool persistent_flag;
     unsigned int interval;
     int taskCount;
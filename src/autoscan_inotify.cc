@@ -34,15 +34,25 @@
 #include <cassert>
 
 #include "autoscan_inotify.h"
+#include "config_manager.h"
 #include "content_manager.h"
+#include "metadata/fanart_handler.h"
 
 #include <dirent.h>
+#include <vector>
 #include <sys/stat.h>
 
 #define AUTOSCAN_INOTIFY_INITIAL_QUEUE_SIZE 20
 
 #define INOTIFY_MAX_USER_WATCHES_FILE "/proc/sys/fs/inotify/max_user_watches"
 
+// number of due paths in one directory from which on a single rescan of
+// the directory is cheaper than individual add/remove tasks
+#define INOTIFY_BATCH_RESCAN_THRESHOLD 32
+
+// consecutive failed fanotify reads after which inotify takes over
+#define FANOTIFY_MAX_READ_ERRORS 10
+
 using namespace zmm;
 using namespace std;
 
@@ -62,6 +72,20 @@ AutoscanInotify::AutoscanInotify()
     monitorQueue = Ref<ObjectQueue<AutoscanDirectory>>(new ObjectQueue<AutoscanDirectory>(AUTOSCAN_INOTIFY_INITIAL_QUEUE_SIZE));
     unmonitorQueue = Ref<ObjectQueue<AutoscanDirectory>>(new ObjectQueue<AutoscanDirectory>(AUTOSCAN_INOTIFY_INITIAL_QUEUE_SIZE));
     events = IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT;
+
+    quietWindow = ConfigManager::getInstance()->getIntOption(CFG_IMPORT_AUTOSCAN_INOTIFY_QUIET_WINDOW);
+    // writes keep restarting the quiet window of a pending path, so a file
+    // that is still being copied is not imported half way through
+    if (quietWindow > 0)
+        events |= IN_MODIFY;
+    nextDispatch = Clock::time_point::max();
+
+#ifdef HAVE_FANOTIFY
+    // a filesystem mark sees every write on the filesystem, FAN_MODIFY
+    // would wake us up far too often; the quiet window still applies
+    fanotifyEvents = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_CLOSE_WRITE | FAN_ONDIR;
+    fanotifyFailed = false;
+#endif
 }
 
 AutoscanInotify::~AutoscanInotify()
@@ -74,6 +98,13 @@ AutoscanInotify::~AutoscanInotify()
         lock.unlock();
         thread_.join();
         log_debug("inotify thread died.\n");
+#ifdef HAVE_FANOTIFY
+        if (fanotify != nullptr) {
+            fanotify->stop();
+            fanotifyThread_.join();
+            fanotify = nullptr;
+        }
+#endif
         inotify = nullptr;
         watches->clear();
     }
@@ -92,7 +123,6 @@ void AutoscanInotify::run()
 void AutoscanInotify::threadProc()
 {
     Ref<ContentManager> cm;
-    Ref<Storage> st;
 
     inotify_event* event;
 
@@ -100,7 +130,6 @@ void AutoscanInotify::threadProc()
 
     try {
         cm = ContentManager::getInstance();
-        st = Storage::getInstance();
     } catch (const Exception& e) {
         log_error("Inotify thread caught: %s\n", e.getMessage().c_str());
         e.printStackTrace();
@@ -121,6 +150,13 @@ void AutoscanInotify::threadProc()
                     continue;
                 }
 
+#ifdef HAVE_FANOTIFY
+                if (unmonitorFanotify(adir, location)) {
+                    lock.lock();
+                    continue;
+                }
+#endif
+
                 if (adir->getRecursive()) {
                     log_debug("removing recursive watch: %s\n", location.c_str());
                     monitorUnmonitorRecursive(location, true, adir, location, true);
@@ -141,7 +177,15 @@ void AutoscanInotify::threadProc()
                     continue;
                 }
 
-                if (adir->getRecursive()) {
+                bool marked = false;
+#ifdef HAVE_FANOTIFY
+                if (adir->getFanotify())
+                    marked = monitorFanotify(adir, location);
+#endif
+
+                if (marked) {
+                    log_debug("adding fanotify mark: %s\n", location.c_str());
+                } else if (adir->getRecursive()) {
                     log_debug("adding recursive watch: %s\n", location.c_str());
                     monitorUnmonitorRecursive(location, false, adir, location, true);
                 } else {
@@ -155,10 +199,17 @@ void AutoscanInotify::threadProc()
 
             lock.unlock();
 
-            /* --- get event --- (blocking) */
-            event = inotify->nextEvent();
+#ifdef HAVE_FANOTIFY
+            handleFanotifyEvents();
+#endif
+
+            /* --- get event --- (blocking until the next pending event is due) */
+            event = inotify->nextEvent(getDispatchTimeout());
             /* --- */
 
+            // before the event, which may end this pass early
+            dispatchPending();
+
             if (event) {
                 int wd = event->wd;
                 int mask = event->mask;
@@ -218,6 +269,8 @@ void AutoscanInotify::threadProc()
                     else
                         fullPath = path;
 
+                    bool remove = false;
+                    bool add = false;
                     if (!(mask & (IN_MOVED_TO | IN_CREATE))) {
                         log_debug("deleting %s\n", fullPath.c_str());
 
@@ -233,18 +286,18 @@ void AutoscanInotify::threadProc()
                             }
                         }
 
-                        int objectID = st->findObjectIDByPath(fullPath);
-                        if (objectID != INVALID_OBJECT_ID)
-                            cm->removeObject(objectID);
+                        remove = true;
                     }
                     if (mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)) {
                         log_debug("adding %s\n", path.c_str());
-                        // path, recursive, async, hidden, low priority, cancellable
-                        cm->addFile(fullPath, adir->getRecursive(), true, adir->getHidden(), true, false);
+                        add = true;
 
                         if (mask & IN_ISDIR)
                             monitorUnmonitorRecursive(path, false, adir, watchAs->getNormalizedAutoscanPath(), false);
                     }
+                    queueEvent(fullPath, adir, remove, add, (mask & IN_MOVED_TO) != 0);
+                } else if (adir != nullptr && (mask & IN_MODIFY)) {
+                    queueEvent(path, adir, false, false);
                 }
                 if (mask & IN_IGNORED) {
                     removeWatchMoves(wd);
@@ -488,7 +541,7 @@ void AutoscanInotify::monitorUnmonitorRecursive(String startPath, bool unmonitor
 
         String fullPath = startPath + DIR_SEPARATOR + name;
 
-        if (stat(fullPath.c_str(), &statbuf) != 0)
+        if (stat_dir_entry(dir, dent, &statbuf) != 0)
             continue;
 
         if (S_ISDIR(statbuf.st_mode)) {
@@ -774,6 +827,296 @@ void AutoscanInotify::removeDescendants(int wd)
     }
 }
 
+void AutoscanInotify::queueEvent(String fullPath, Ref<AutoscanDirectory> adir, bool remove, bool add, bool movedTo)
+{
+    Clock::time_point deadline = Clock::now() + chrono::milliseconds(quietWindow);
+
+    // the directory content changed, its fan art lookup may be stale;
+    // for directories (trailing separator) this is the directory itself
+    if (remove || add)
+        FanArtHandler::invalidate(fullPath.substring(0, fullPath.rindex(DIR_SEPARATOR)));
+
+    auto it = pending.find(fullPath);
+    if (it == pending.end()) {
+        if (!remove && !add)
+            return;
+        // a move may replace an indexed path, the old object must go even
+        // if a delete of the new file follows within the window
+        if (movedTo && add && !remove
+            && Storage::getInstance()->findObjectIDByPath(fullPath) != INVALID_OBJECT_ID)
+            remove = true;
+        pending.emplace(fullPath, PendingEvent { adir, remove, add, deadline });
+    } else {
+        PendingEvent& ev = it->second;
+        if (remove && !add) {
+            if (ev.add && !ev.remove) {
+                // created and gone again within the window, the database
+                // has never seen this path
+                log_debug("collapsing create+delete of %s\n", fullPath.c_str());
+                pending.erase(it);
+                return;
+            }
+            ev.remove = true;
+            ev.add = false;
+        } else {
+            // a rewrite (IN_CLOSE_WRITE) of a path that is pending as
+            // created stays a plain add, the database has no old entry
+            if (remove && !ev.add)
+                ev.remove = true;
+            if (add)
+                ev.add = true;
+        }
+        ev.adir = adir;
+        ev.deadline = deadline;
+    }
+
+    if (deadline < nextDispatch)
+        nextDispatch = deadline;
+}
+
+void AutoscanInotify::dispatchPending()
+{
+    Clock::time_point now = Clock::now();
+    if (pending.empty() || now < nextDispatch)
+        return;
+
+    Ref<ContentManager> cm = ContentManager::getInstance();
+    Ref<Storage> st = Storage::getInstance();
+
+    // collect the due paths per parent directory
+    unordered_map<String, vector<pair<String, PendingEvent>>> due;
+    nextDispatch = Clock::time_point::max();
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->second.deadline > now) {
+            if (it->second.deadline < nextDispatch)
+                nextDispatch = it->second.deadline;
+            ++it;
+            continue;
+        }
+        String path = it->first;
+        int end = path.length() - 1;
+        if (end > 0 && path.charAt(end) == DIR_SEPARATOR)
+            end--;
+        while (end > 0 && path.charAt(end) != DIR_SEPARATOR)
+            end--;
+        due[path.substring(0, end + 1)].push_back(*it);
+        it = pending.erase(it);
+    }
+
+    for (auto& dir : due) {
+        auto& events = dir.second;
+        if (events.size() >= INOTIFY_BATCH_RESCAN_THRESHOLD) {
+            Ref<AutoscanDirectory> adir = events.front().second.adir;
+            int containerID = st->findObjectIDByPath(dir.first);
+            if (containerID != INVALID_OBJECT_ID && adir->getScanID() != INVALID_SCAN_ID) {
+                log_debug("%d changes in %s, rescanning directory\n", (int)events.size(), dir.first.c_str());
+                cm->rescanDirectory(containerID, adir->getScanID(), adir->getScanMode(), dir.first, false);
+                continue;
+            }
+        }
+
+        for (auto& entry : events) {
+            PendingEvent& ev = entry.second;
+            // the autoscan may have been removed while the event was pending
+            if (ev.adir->getScanID() == INVALID_SCAN_ID)
+                continue;
+
+            if (ev.remove) {
+                int objectID = st->findObjectIDByPath(entry.first);
+                if (objectID != INVALID_OBJECT_ID)
+                    cm->removeObject(objectID);
+            }
+            if (ev.add) {
+                // path, recursive, async, hidden, low priority, cancellable
+                cm->addFile(entry.first, ev.adir->getRecursive(), true, ev.adir->getHidden(), true, false);
+            }
+        }
+    }
+}
+
+int AutoscanInotify::getDispatchTimeout()
+{
+    if (pending.empty())
+        return -1;
+
+    auto timeout = chrono::duration_cast<chrono::milliseconds>(nextDispatch - Clock::now()).count();
+    return (timeout > 0) ? (int)timeout + 1 : 0;
+}
+
+#ifdef HAVE_FANOTIFY
+bool AutoscanInotify::monitorFanotify(Ref<AutoscanDirectory> adir, String location)
+{
+    if (fanotifyFailed)
+        return false;
+
+    if (!Fanotify::supported(location)) {
+        log_warning("fanotify is not usable for %s (requires CAP_SYS_ADMIN and CAP_DAC_READ_SEARCH), using inotify\n",
+            location.c_str());
+        return false;
+    }
+
+    if (fanotify == nullptr) {
+        try {
+            fanotify = Ref<Fanotify>(new Fanotify());
+        } catch (const Exception& e) {
+            log_warning("%s, using inotify for %s\n", e.getMessage().c_str(), location.c_str());
+            return false;
+        }
+        fanotifyThread_ = thread{ &AutoscanInotify::fanotifyThreadProc, this };
+    }
+
+    if (!fanotify->addMark(location, fanotifyEvents)) {
+        log_warning("Using inotify for %s\n", location.c_str());
+        return false;
+    }
+
+    fanotifyDirs.emplace_back(location, adir);
+    return true;
+}
+
+bool AutoscanInotify::unmonitorFanotify(Ref<AutoscanDirectory> adir, String location)
+{
+    for (auto it = fanotifyDirs.begin(); it != fanotifyDirs.end(); ++it) {
+        if (it->second->getLocation() == adir->getLocation()) {
+            log_debug("removing fanotify mark: %s\n", location.c_str());
+            fanotify->removeMark(location, fanotifyEvents);
+            fanotifyDirs.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AutoscanInotify::fanotifyThreadProc()
+{
+    while (!shutdownFlag) {
+        uint64_t mask;
+        bool failed = false;
+        String path = fanotify->nextEvent(&mask);
+        if (path == nullptr) {
+            int errors = fanotify->getReadErrors();
+            if (errors == 0)
+                continue;
+            if (errors < FANOTIFY_MAX_READ_ERRORS) {
+                // back off instead of spinning on a broken descriptor
+                this_thread::sleep_for(chrono::milliseconds(100 * errors));
+                continue;
+            }
+            // let threadProc move the directories over to inotify
+            path = _("");
+            mask = 0;
+            failed = true;
+        }
+
+        AutoLock lock(mutex);
+        // threadProc drains the whole queue once woken up
+        bool wakeup = fanotifyQueue.empty();
+        fanotifyQueue.emplace_back(path, mask);
+        if (wakeup && !shutdownFlag)
+            inotify->stop();
+        if (failed)
+            break;
+    }
+}
+
+void AutoscanInotify::fallbackToInotify()
+{
+    log_warning("fanotify is not usable, using inotify for %d autoscan directories\n",
+        (int)fanotifyDirs.size());
+    fanotifyFailed = true;
+    // the marks are gone below, events still queued must not bring us back
+    fanotify->clearPermissionDenied();
+
+    Ref<ContentManager> cm = ContentManager::getInstance();
+    auto dirs = fanotifyDirs;
+    fanotifyDirs.clear();
+    for (auto& dir : dirs) {
+        String location = dir.first;
+        Ref<AutoscanDirectory> adir = dir.second;
+        fanotify->removeMark(location, fanotifyEvents);
+        if (adir->getRecursive())
+            monitorUnmonitorRecursive(location, false, adir, location, true);
+        else
+            monitorDirectory(location, adir, location, true);
+        // changes since the mark was added went unnoticed
+        cm->rescanDirectory(adir->getObjectID(), adir->getScanID(), adir->getScanMode(), nullptr, false);
+    }
+}
+
+void AutoscanInotify::handleFanotifyEvents()
+{
+    vector<pair<String, uint64_t>> queue;
+    {
+        AutoLock lock(mutex);
+        queue.swap(fanotifyQueue);
+    }
+
+    for (auto& event : queue) {
+        String path = event.first;
+        uint64_t mask = event.second;
+
+        if (mask == 0) {
+            if (!fanotifyFailed)
+                fallbackToInotify();
+            return;
+        }
+
+        if (mask & FAN_Q_OVERFLOW) {
+            log_warning("fanotify event queue overflow, rescanning fanotify autoscan directories\n");
+            Ref<ContentManager> cm = ContentManager::getInstance();
+            for (auto& dir : fanotifyDirs) {
+                Ref<AutoscanDirectory> adir = dir.second;
+                cm->rescanDirectory(adir->getObjectID(), adir->getScanID(), adir->getScanMode(), nullptr, false);
+            }
+            continue;
+        }
+
+        Ref<AutoscanDirectory> adir = getFanotifyAutoscan(path);
+        if (adir == nullptr)
+            continue;
+
+        log_debug("fanotify event: %llx %s\n", (unsigned long long)mask, path.c_str());
+
+        bool isDir = (mask & FAN_ONDIR) != 0;
+        bool remove = (mask & (FAN_DELETE | FAN_MOVED_FROM | FAN_CLOSE_WRITE)) != 0;
+        bool add = (mask & (FAN_CREATE | FAN_MOVED_TO | FAN_CLOSE_WRITE)) != 0;
+
+        // fanotify merges queued events of the same entry, only (re)add
+        // what is still there
+        if (add && (mask & (FAN_DELETE | FAN_MOVED_FROM)))
+            add = check_path(path, isDir);
+
+        queueEvent(isDir ? path + DIR_SEPARATOR : path, adir, remove, add, (mask & FAN_MOVED_TO) != 0);
+    }
+}
+
+Ref<AutoscanDirectory> AutoscanInotify::getFanotifyAutoscan(String path)
+{
+    Ref<AutoscanDirectory> bestMatch = nullptr;
+    int bestLength = -1;
+    for (auto& dir : fanotifyDirs) {
+        String location = dir.first;
+        int len = location.length();
+        if (len > bestLength && path.length() > len + 1
+            && path.charAt(len) == DIR_SEPARATOR && path.startsWith(location)) {
+            bestMatch = dir.second;
+            bestLength = len;
+        }
+    }
+    if (bestMatch == nullptr)
+        return nullptr;
+
+    // the mark covers the whole filesystem, drop what the autoscan
+    // settings would not have seen with inotify
+    String relative = path.substring(bestLength + 1);
+    if (!bestMatch->getRecursive() && relative.index(DIR_SEPARATOR) >= 0)
+        return nullptr;
+    if (!bestMatch->getHidden() && (relative.charAt(0) == '.' || strstr(relative.c_str(), "/.") != nullptr))
+        return nullptr;
+    return bestMatch;
+}
+#endif
+
 String AutoscanInotify::normalizePathNoEx(String path)
 {
     try {
@@ -31,16 +31,22 @@
 #ifndef __AUTOSCAN_INOTIFY_H__
 #define __AUTOSCAN_INOTIFY_H__
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <thread>
+#include <vector>
 
 #include "zmm/zmmf.h"
 #include "autoscan.h"
 #include "mt_inotify.h"
 #include "singleton.h"
 
+#ifdef HAVE_FANOTIFY
+#include "mt_fanotify.h"
+#endif
+
 #define INOTIFY_ROOT -1
 #define INOTIFY_UNKNOWN_PARENT_WD -2
 
@@ -187,6 +193,86 @@ private:
     
     void addDescendant(int startPointWd, int addWd, zmm::Ref<AutoscanDirectory> adir);
     void removeDescendants(int wd);
+
+    using Clock = std::chrono::steady_clock;
+
+    /// \brief Add/remove work for a path that is held back until the path
+    /// has been quiet for quietWindow milliseconds.
+    class PendingEvent
+    {
+    public:
+        zmm::Ref<AutoscanDirectory> adir;
+        /// \brief object must be removed from the database
+        bool remove;
+        /// \brief path must be (re)added after the removal
+        bool add;
+        Clock::time_point deadline;
+    };
+
+    /// \brief pending work keyed by full path (directories end with a separator)
+    std::unordered_map<zmm::String, PendingEvent> pending;
+
+    /// \brief no pending event is due before this point in time
+    Clock::time_point nextDispatch;
+
+    /// \brief quiet window in milliseconds, 0 dispatches events immediately
+    int quietWindow;
+
+    /// \brief Merges an event into the pending queue.
+    ///
+    /// An add following a removal becomes a re-add, a removal following an
+    /// add that the database never saw cancels out, calling it with neither
+    /// remove nor add only restarts the quiet window of a pending path.
+    /// \param movedTo the add comes from a move which may replace a path
+    /// that is already indexed, the removal of the old object is kept then.
+    void queueEvent(zmm::String fullPath, zmm::Ref<AutoscanDirectory> adir, bool remove, bool add, bool movedTo = false);
+
+    /// \brief Dispatches all pending events whose quiet window has expired.
+    ///
+    /// Paths sharing a parent directory are handed to the content manager
+    /// as a single rescan of that directory once there are enough of them.
+    void dispatchPending();
+
+    /// \brief milliseconds until the next pending event is due, -1 if none
+    int getDispatchTimeout();
+
+#ifdef HAVE_FANOTIFY
+    zmm::Ref<Fanotify> fanotify;
+
+    /// \brief reads fanotify events and hands them over to threadProc()
+    std::thread fanotifyThread_;
+
+    // fanotify event mask (set by constructor)
+    uint64_t fanotifyEvents;
+
+    /// \brief resolved (path, mask) events from the fanotify thread, guarded by mutex
+    std::vector<std::pair<zmm::String, uint64_t>> fanotifyQueue;
+
+    /// \brief fanotify monitored autoscans with their normalized location
+    std::vector<std::pair<zmm::String, zmm::Ref<AutoscanDirectory>>> fanotifyDirs;
+
+    void fanotifyThreadProc();
+
+    /// \brief Marks the filesystem of an autoscan directory.
+    /// \return false if fanotify can not be used, the caller falls back to inotify watches
+    bool monitorFanotify(zmm::Ref<AutoscanDirectory> adir, zmm::String location);
+
+    /// \return false if the autoscan directory was not monitored by fanotify
+    bool unmonitorFanotify(zmm::Ref<AutoscanDirectory> adir, zmm::String location);
+
+    void handleFanotifyEvents();
+
+    /// \brief fanotify could not resolve event handles, all autoscans
+    /// use inotify from now on
+    bool fanotifyFailed;
+
+    /// \brief Moves all fanotify monitored autoscans over to inotify watches.
+    void fallbackToInotify();
+
+    /// \brief Finds the autoscan directory a fanotify event belongs to, taking
+    /// the recursive and hidden settings into account.
+    zmm::Ref<AutoscanDirectory> getFanotifyAutoscan(zmm::String path);
+#endif
     
     /// \brief is set to true by shutdown() if the inotify thread should terminate
     bool shutdownFlag;
@@ -0,0 +1,158 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    didl_bench.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file didl_bench.cc
+/// \brief Compares serializing Browse results through an mxml element
+/// tree with the DidlWriter.
+///
+/// Both variants receive the same element calls that
+/// UpnpXML_DIDLRenderObject() makes for a video item, the program fails
+/// if their output differs.
+///
+/// Usage: didl-bench [items] [rounds]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "didl_writer.h"
+#include "dictionary.h"
+#include "upnp_xml.h"
+
+using namespace zmm;
+using namespace mxml;
+
+/// \brief Values of one item, created before timing starts.
+struct BenchItem {
+    String id;
+    String title;
+    String date;
+    String genre;
+    String description;
+    String creator;
+    String url;
+    Ref<Dictionary> resAttributes;
+};
+
+static BenchItem makeItem(int i)
+{
+    BenchItem item;
+    item.id = String::from(i + 100);
+    item.title = _("Episode ") + i + " - Tom & Jerry <remastered>";
+    item.date = _("2010-01-01");
+    item.genre = _("Animation");
+    item.description = _("\"Cat\" chases 'mouse' through the house, part ") + i;
+    item.creator = _("Hanna & Barbera");
+    item.url = _("http://192.168.1.2:49152/content/media/object_id/") + item.id + "/res_id/0/ext/file.mkv";
+    item.resAttributes = Ref<Dictionary>(new Dictionary());
+    item.resAttributes->put(_("protocolInfo"), _("http-get:*:video/x-matroska:*"));
+    item.resAttributes->put(_("size"), String::from(734003200 + i));
+    item.resAttributes->put(_("duration"), _("00:22:41.0"));
+    item.resAttributes->put(_("resolution"), _("1920x1080"));
+    item.resAttributes->put(_("bitrate"), _("1200000"));
+    return item;
+}
+
+static void render(DidlSink& sink, std::vector<BenchItem>& items)
+{
+    sink.startElement(_("DIDL-Lite"));
+    sink.attribute(_(XML_NAMESPACE_ATTR), _(XML_DIDL_LITE_NAMESPACE));
+    sink.attribute(_(XML_DC_NAMESPACE_ATTR), _(XML_DC_NAMESPACE));
+    sink.attribute(_(XML_UPNP_NAMESPACE_ATTR), _(XML_UPNP_NAMESPACE));
+
+    for (auto& item : items) {
+        sink.startElement(_("item"));
+        sink.attribute(_("id"), item.id);
+        sink.attribute(_("parentID"), _("42"));
+        sink.attribute(_("restricted"), _("0"));
+        sink.textElement(_("dc:title"), item.title);
+        sink.textElement(_("upnp:class"), _(UPNP_DEFAULT_CLASS_VIDEO_ITEM));
+        sink.textElement(_("dc:date"), item.date);
+        sink.textElement(_("upnp:genre"), item.genre);
+        sink.textElement(_("dc:description"), item.description);
+        UpnpXML_DIDLRenderCreator(sink, item.creator);
+        UpnpXML_DIDLRenderResource(sink, item.url, item.resAttributes);
+        sink.endElement();
+    }
+    sink.endElement();
+}
+
+static String renderTree(std::vector<BenchItem>& items)
+{
+    DidlElementBuilder builder;
+    render(builder, items);
+    return builder.getRoot()->print();
+}
+
+static String renderWriter(std::vector<BenchItem>& items)
+{
+    DidlWriter& writer = DidlWriter::getThreadWriter();
+    render(writer, items);
+    return writer.toString();
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 500;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+    if (count <= 0 || rounds <= 0) {
+        fprintf(stderr, "Usage: %s [items] [rounds]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<BenchItem> items;
+    for (int i = 0; i < count; i++)
+        items.push_back(makeItem(i));
+
+    String tree = renderTree(items);
+    String direct = renderWriter(items);
+    if (tree != direct) {
+        fprintf(stderr, "output differs\nelement tree:\n%s\nwriter:\n%s\n",
+            tree.c_str(), direct.c_str());
+        return 1;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    size_t length = 0;
+
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < rounds; r++)
+        length += renderTree(items).length();
+    double treeTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rounds;
+
+    start = Clock::now();
+    for (int r = 0; r < rounds; r++)
+        length += renderWriter(items).length();
+    double writerTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rounds;
+
+    printf("%d items, %d bytes, %d rounds\n", count, tree.length(), rounds);
+    printf("element tree: %10.1f us per Browse\n", treeTime);
+    printf("DidlWriter:   %10.1f us per Browse (%.1fx)\n", writerTime, treeTime / writerTime);
+    return length > 0 ? 0 : 1;
+}
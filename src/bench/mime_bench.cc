@@ -0,0 +1,256 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    mime_bench.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file mime_bench.cc
+/// \brief Measures how fast imported files are resolved to mime type and
+/// upnp class.
+///
+/// Extensions are looked up in the MimeTypeMap and, for comparison, in the
+/// mapping dictionaries the way ContentManager did before, the program
+/// fails if both disagree. Files given on the command line are resolved
+/// like ContentManager::createObjectFromFile() does: by extension, and
+/// through the MagicPool from their header if the extension is not mapped,
+/// from one thread and from several threads at once.
+///
+/// Usage: mime-bench [rounds] [file...]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "mime_type_map.h"
+#include "tools.h"
+
+#ifdef HAVE_MAGIC
+#include "magic_pool.h"
+#endif
+
+using namespace zmm;
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* extensionMappings[][2] = {
+    { "mp3", "audio/mpeg" }, { "ogx", "application/ogg" },
+    { "ogv", "video/ogg" }, { "oga", "audio/ogg" },
+    { "ogg", "audio/ogg" }, { "ogm", "video/ogg" },
+    { "asf", "video/x-ms-asf" }, { "asx", "video/x-ms-asf" },
+    { "wma", "audio/x-ms-wma" }, { "wax", "audio/x-ms-wax" },
+    { "wmv", "video/x-ms-wmv" }, { "wvx", "video/x-ms-wvx" },
+    { "wm", "video/x-ms-wm" }, { "wmx", "video/x-ms-wmx" },
+    { "m3u", "audio/x-mpegurl" }, { "pls", "audio/x-scpls" },
+    { "flv", "video/x-flv" }, { "mkv", "video/x-matroska" },
+    { "mka", "audio/x-matroska" }, { "avi", "video/x-msvideo" },
+    { "mp4", "video/mp4" }, { "m4a", "audio/mp4" },
+    { "flac", "audio/x-flac" }, { "jpg", "image/jpeg" },
+    { "jpeg", "image/jpeg" }, { "png", "image/png" },
+};
+
+static const char* upnpClassMappings[][2] = {
+    { "audio/*", UPNP_DEFAULT_CLASS_MUSIC_TRACK },
+    { "video/*", UPNP_DEFAULT_CLASS_VIDEO_ITEM },
+    { "image/*", UPNP_DEFAULT_CLASS_IMAGE_ITEM },
+    { "application/ogg", UPNP_DEFAULT_CLASS_MUSIC_TRACK },
+};
+
+/// \brief The lookup ContentManager did before the MimeTypeMap: a
+/// lowercased copy of the extension, searched linearly in the dictionaries.
+static bool dictionaryLookup(Ref<Dictionary> extMap, Ref<Dictionary> classMap,
+    String extension, String* mimetype, String* upnpClass)
+{
+    *mimetype = extMap->get(extension.toLower());
+    if (*mimetype == nullptr)
+        return false;
+    *upnpClass = classMap->get(*mimetype);
+    if (*upnpClass == nullptr) {
+        Ref<Array<StringBase>> parts = split_string(*mimetype, '/');
+        if (parts->size() == 2)
+            *upnpClass = classMap->get((String)parts->get(0) + "/*");
+    }
+    return true;
+}
+
+static double nsPer(Clock::time_point start, long count)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+#ifdef HAVE_MAGIC
+static String getExtension(String filename)
+{
+    int dotIndex = filename.rindex('.');
+    if (dotIndex > 0)
+        return filename.substring(dotIndex + 1);
+    return nullptr;
+}
+
+/// \brief A file of the command line with its header read in advance,
+/// the import reads it once for all probes anyway.
+struct BenchFile {
+    String extension;
+    std::vector<char> header;
+};
+
+static long resolveFiles(const MimeTypeMap& map, MagicPool& pool,
+    std::vector<BenchFile>& files, int rounds)
+{
+    long resolved = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (auto& file : files) {
+            String mimetype;
+            const MimeTypeMap::MimeMapping* mapping = map.extension2mapping(file.extension);
+            if (mapping != nullptr)
+                mimetype = mapping->mimetype;
+            else
+                mimetype = pool.getMimeTypeFromBuffer(file.header.data(), file.header.size());
+            if (mimetype != nullptr && (mapping != nullptr || map.mimetype2upnpclass(mimetype) != nullptr))
+                resolved++;
+        }
+    }
+    return resolved;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 1000;
+    if (rounds <= 0) {
+        fprintf(stderr, "Usage: %s [rounds] [file...]\n", argv[0]);
+        return 2;
+    }
+
+    Ref<Dictionary> extMap(new Dictionary());
+    for (auto& m : extensionMappings)
+        extMap->put(_(m[0]), _(m[1]));
+    Ref<Dictionary> classMap(new Dictionary());
+    for (auto& m : upnpClassMappings)
+        classMap->put(_(m[0]), _(m[1]));
+    MimeTypeMap map(extMap, classMap, false);
+
+    // every mapped extension in two spellings, plus some that are unknown
+    std::vector<String> extensions;
+    for (auto& m : extensionMappings) {
+        extensions.push_back(_(m[0]));
+        extensions.push_back(String(m[0]).toUpper());
+    }
+    extensions.push_back(_("txt"));
+    extensions.push_back(_("nfo"));
+    extensions.push_back(_("srt"));
+
+    for (auto& ext : extensions) {
+        String mimetype, upnpClass;
+        bool found = dictionaryLookup(extMap, classMap, ext, &mimetype, &upnpClass);
+        const MimeTypeMap::MimeMapping* mapping = map.extension2mapping(ext);
+        if (found != (mapping != nullptr)
+            || (found && (mimetype != mapping->mimetype || upnpClass != mapping->upnpClass))) {
+            fprintf(stderr, "mapping of %s differs\n", ext.c_str());
+            return 1;
+        }
+    }
+
+    long lookups = (long)rounds * extensions.size();
+    long hits = 0;
+
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (auto& ext : extensions) {
+            String mimetype, upnpClass;
+            if (dictionaryLookup(extMap, classMap, ext, &mimetype, &upnpClass))
+                hits++;
+        }
+    }
+    double dictTime = nsPer(start, lookups);
+
+    start = Clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (auto& ext : extensions) {
+            if (map.extension2mapping(ext) != nullptr)
+                hits++;
+        }
+    }
+    double mapTime = nsPer(start, lookups);
+
+    printf("%d extensions, %d rounds\n", (int)extensions.size(), rounds);
+    printf("dictionary:  %10.1f ns per file\n", dictTime);
+    printf("MimeTypeMap: %10.1f ns per file (%.1fx)\n", mapTime, dictTime / mapTime);
+
+    if (argc <= 2)
+        return hits > 0 ? 0 : 1;
+
+#ifdef HAVE_MAGIC
+    Ref<RExp> reMimetype(new RExp());
+    reMimetype->compile(_(MIMETYPE_REGEXP));
+    MagicPool pool(nullptr, reMimetype);
+
+    std::vector<BenchFile> files;
+    for (int i = 2; i < argc; i++) {
+        FILE* f = fopen(argv[i], "rb");
+        if (!f) {
+            fprintf(stderr, "could not open %s\n", argv[i]);
+            return 2;
+        }
+        BenchFile file;
+        file.extension = getExtension(argv[i]);
+        file.header.resize(pool.getBytesMax());
+        file.header.resize(fread(file.header.data(), 1, file.header.size(), f));
+        fclose(f);
+        files.push_back(file);
+    }
+
+    // loads the magic database, not part of the measurement
+    resolveFiles(map, pool, files, 1);
+
+    int fileRounds = rounds / 100 > 0 ? rounds / 100 : 1;
+    long count = (long)fileRounds * files.size();
+
+    start = Clock::now();
+    long resolved = resolveFiles(map, pool, files, fileRounds);
+    double singleTime = nsPer(start, count);
+
+    int threadCount = std::thread::hardware_concurrency();
+    if (threadCount < 2)
+        threadCount = 2;
+    std::vector<std::thread> threads;
+    start = Clock::now();
+    for (int t = 0; t < threadCount; t++)
+        threads.emplace_back([&]() { resolveFiles(map, pool, files, fileRounds); });
+    for (auto& thread : threads)
+        thread.join();
+    double parallelTime = nsPer(start, count * threadCount);
+
+    printf("%d files, %ld resolved per round, %d rounds\n",
+        (int)files.size(), resolved / fileRounds, fileRounds);
+    printf("threads  1:  %10.1f ns per file\n", singleTime);
+    printf("threads %2d:  %10.1f ns per file (%.1fx)\n", threadCount, parallelTime, singleTime / parallelTime);
+#else
+    fprintf(stderr, "built without libmagic, files are not resolved\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,217 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    browse_cache.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file browse_cache.cc
+/// \brief Implementation of the BrowseCache class.
+
+#include "browse_cache.h"
+
+#include "config_manager.h"
+#include "storage.h"
+
+/// \brief a single entry may use at most this fraction of the budget
+#define BROWSE_CACHE_ENTRY_FRACTION 4
+/// \brief rough bookkeeping cost of an entry besides the DIDL
+#define BROWSE_CACHE_ENTRY_OVERHEAD 256
+
+using namespace zmm;
+using namespace std;
+
+static inline string getKey(int objectID, unsigned int flags,
+    int startingIndex, int requestedCount)
+{
+    return to_string(objectID) + ':' + to_string(flags) + ':'
+        + to_string(startingIndex) + ':' + to_string(requestedCount);
+}
+
+BrowseCache::BrowseCache()
+    : Singleton<BrowseCache>()
+    , enabled(false)
+    , memoryLimit(0)
+    , memoryUsed(0)
+    , generation(0)
+    , hits(0)
+    , misses(0)
+{
+}
+
+void BrowseCache::init()
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    enabled = cfg->getBoolOption(CFG_SERVER_BROWSE_CACHE_ENABLED);
+    memoryLimit = (size_t)cfg->getIntOption(CFG_SERVER_BROWSE_CACHE_MEMORY_SIZE) * 1024 * 1024;
+    if (memoryLimit == 0)
+        enabled = false;
+}
+
+void BrowseCache::shutdown()
+{
+    if (!enabled)
+        return;
+
+    log_info("browse cache hits: %ld, misses: %ld, hit rate: %ld%%\n",
+        getHits(), getMisses(),
+        (getHits() + getMisses()) > 0 ? (getHits() * 100) / (getHits() + getMisses()) : 0);
+
+    AutoLock lock(mutex);
+    lru.clear();
+    entries.clear();
+    dependents.clear();
+    memoryUsed = 0;
+}
+
+shared_ptr<const BrowseResult> BrowseCache::get(int objectID, unsigned int flags,
+    int startingIndex, int requestedCount,
+    int updateID, int systemUpdateID, unsigned long* generation)
+{
+    if (!enabled)
+        return nullptr;
+
+    string key = getKey(objectID, flags, startingIndex, requestedCount);
+
+    AutoLock lock(mutex);
+    *generation = this->generation;
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        Entry& entry = it->second;
+        if (entry.updateID == updateID && entry.systemUpdateID == systemUpdateID) {
+            lru.splice(lru.begin(), lru, entry.lru);
+            hits++;
+            return entry.result;
+        }
+        erase(key);
+    }
+
+    misses++;
+    return nullptr;
+}
+
+void BrowseCache::put(int objectID, unsigned int flags,
+    int startingIndex, int requestedCount,
+    int updateID, int systemUpdateID, unsigned long generation,
+    int parentID, shared_ptr<const BrowseResult> result)
+{
+    if (!enabled)
+        return;
+
+    string key = getKey(objectID, flags, startingIndex, requestedCount);
+    size_t size = result->didl.size() + key.size() + BROWSE_CACHE_ENTRY_OVERHEAD;
+    if (size > memoryLimit / BROWSE_CACHE_ENTRY_FRACTION)
+        return;
+
+    AutoLock lock(mutex);
+    if (generation != this->generation)
+        return;
+
+    if (entries.find(key) != entries.end())
+        erase(key);
+
+    while (memoryUsed + size > memoryLimit && !lru.empty()) {
+        string victim = lru.back();
+        erase(victim);
+    }
+
+    lru.push_front(key);
+
+    Entry& entry = entries[key];
+    entry.result = result;
+    entry.updateID = updateID;
+    entry.systemUpdateID = systemUpdateID;
+    entry.size = size;
+    entry.lru = lru.begin();
+
+    entry.containers.push_back(objectID);
+    if (!(flags & BROWSE_DIRECT_CHILDREN) && parentID != INVALID_OBJECT_ID && parentID != objectID)
+        entry.containers.push_back(parentID);
+    for (int id : entry.containers)
+        dependents[id].insert(key);
+
+    memoryUsed += size;
+}
+
+bool BrowseCache::contains(int objectID, unsigned int flags,
+    int startingIndex, int requestedCount,
+    int updateID, int systemUpdateID)
+{
+    if (!enabled)
+        return false;
+
+    string key = getKey(objectID, flags, startingIndex, requestedCount);
+
+    AutoLock lock(mutex);
+    auto it = entries.find(key);
+    return it != entries.end()
+        && it->second.updateID == updateID
+        && it->second.systemUpdateID == systemUpdateID;
+}
+
+unsigned long BrowseCache::getGeneration()
+{
+    AutoLock lock(mutex);
+    return generation;
+}
+
+void BrowseCache::invalidate(int objectID)
+{
+    if (!enabled || objectID == INVALID_OBJECT_ID)
+        return;
+
+    AutoLock lock(mutex);
+    generation++;
+
+    auto it = dependents.find(objectID);
+    if (it == dependents.end())
+        return;
+
+    // erase() modifies the set we are iterating over
+    vector<string> keys(it->second.begin(), it->second.end());
+    for (const auto& key : keys)
+        erase(key);
+}
+
+void BrowseCache::erase(const string& key)
+{
+    auto it = entries.find(key);
+    if (it == entries.end())
+        return;
+
+    for (int id : it->second.containers) {
+        auto dep = dependents.find(id);
+        if (dep == dependents.end())
+            continue;
+        dep->second.erase(key);
+        if (dep->second.empty())
+            dependents.erase(dep);
+    }
+
+    memoryUsed -= it->second.size;
+    lru.erase(it->second.lru);
+    entries.erase(it);
+}
@@ -0,0 +1,136 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    browse_cache.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file browse_cache.h
+
+#ifndef __BROWSE_CACHE_H__
+#define __BROWSE_CACHE_H__
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common.h"
+#include "singleton.h"
+
+/// \brief A rendered Browse result, without the UpdateID.
+struct BrowseResult {
+    std::string didl;
+    int numberReturned;
+    int totalMatches;
+};
+
+/// \brief Size bounded LRU of rendered Browse results.
+///
+/// Entries are keyed by object ID, browse flags, starting index and
+/// requested count. They are validated against the update ID of the
+/// browsed object and the systemUpdateID they were rendered under, and
+/// dropped as soon as the UpdateManager learns that their container
+/// changed.
+class BrowseCache : public Singleton<BrowseCache>
+{
+public:
+    BrowseCache();
+    virtual void init() override;
+    virtual void shutdown() override;
+    zmm::String getName() override { return _("Browse Cache"); }
+
+    inline bool isEnabled() { return enabled; }
+
+    /// \brief Looks up a rendered result.
+    /// \param objectID the browsed object
+    /// \param flags BROWSE_ flags of the request
+    /// \param startingIndex StartingIndex of the request
+    /// \param requestedCount RequestedCount of the request
+    /// \param updateID current update ID of the browsed object
+    /// \param systemUpdateID current systemUpdateID
+    /// \param generation set to the value that has to be passed to put()
+    /// \return the result or nullptr on a miss
+    std::shared_ptr<const BrowseResult> get(int objectID, unsigned int flags,
+        int startingIndex, int requestedCount,
+        int updateID, int systemUpdateID, unsigned long* generation);
+
+    /// \brief Stores a result rendered after a miss.
+    ///
+    /// The result is dropped if anything was invalidated since the
+    /// lookup, as it may have been read before the change.
+    /// \param parentID parent of the browsed object, changes to it also
+    /// drop a BrowseMetadata entry
+    void put(int objectID, unsigned int flags,
+        int startingIndex, int requestedCount,
+        int updateID, int systemUpdateID, unsigned long generation,
+        int parentID, std::shared_ptr<const BrowseResult> result);
+
+    /// \brief Checks for a valid entry without touching the LRU order or
+    /// the hit rate.
+    bool contains(int objectID, unsigned int flags,
+        int startingIndex, int requestedCount,
+        int updateID, int systemUpdateID);
+
+    /// \brief Drops all entries that depend on the given container.
+    void invalidate(int objectID);
+
+    /// \brief changes with every invalidation
+    unsigned long getGeneration();
+
+    inline long getHits() { return hits; }
+    inline long getMisses() { return misses; }
+
+protected:
+    struct Entry {
+        std::shared_ptr<const BrowseResult> result;
+        int updateID;
+        int systemUpdateID;
+        size_t size;
+        std::vector<int> containers;
+        std::list<std::string>::iterator lru;
+    };
+
+    bool enabled;
+    size_t memoryLimit;
+    size_t memoryUsed;
+    unsigned long generation;
+
+    /// \brief most recently used key in front
+    std::list<std::string> lru;
+    std::unordered_map<std::string, Entry> entries;
+    /// \brief keys of the entries depending on a container
+    std::unordered_map<int, std::unordered_set<std::string>> dependents;
+
+    std::atomic<long> hits;
+    std::atomic<long> misses;
+
+    void erase(const std::string& key);
+};
+
+#endif // __BROWSE_CACHE_H__
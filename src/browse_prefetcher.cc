@@ -0,0 +1,164 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    browse_prefetcher.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file browse_prefetcher.cc
+/// \brief Implementation of the BrowsePrefetcher class.
+
+#include "browse_prefetcher.h"
+
+#include "config_manager.h"
+#include "storage.h"
+
+using namespace zmm;
+using namespace std;
+
+BrowsePrefetcher::BrowsePrefetcher()
+    : Singleton<BrowsePrefetcher>()
+    , enabled(false)
+    , budget(0)
+    , shutdownFlag(false)
+    , prefetchThread(0)
+    , rendered(0)
+    , cancelled(0)
+{
+}
+
+void BrowsePrefetcher::init()
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    budget = cfg->getIntOption(CFG_SERVER_BROWSE_CACHE_PREFETCH_BUDGET);
+    enabled = cfg->getBoolOption(CFG_SERVER_BROWSE_CACHE_PREFETCH)
+        && BrowseCache::getInstance()->isEnabled() && (budget > 0);
+    if (!enabled)
+        return;
+
+    if (pthread_create(&prefetchThread, nullptr, BrowsePrefetcher::staticThreadProc, this) != 0) {
+        log_error("Could not start the browse prefetch thread, prefetching disabled\n");
+        prefetchThread = 0;
+        enabled = false;
+    }
+}
+
+void BrowsePrefetcher::shutdown()
+{
+    unique_lock<mutex_type> lock(mutex);
+    shutdownFlag = true;
+    queue.clear();
+    cond.notify_one();
+    lock.unlock();
+
+    if (prefetchThread)
+        pthread_join(prefetchThread, nullptr);
+    prefetchThread = 0;
+
+    if (enabled)
+        log_debug("browse prefetch rendered: %ld, cancelled: %ld\n", (long)rendered, (long)cancelled);
+}
+
+void BrowsePrefetcher::schedule(String client, int objectID, unsigned int flags,
+    int startingIndex, int requestedCount,
+    int updateID, int systemUpdateID, int parentID, RenderFunction render)
+{
+    if (!enabled)
+        return;
+
+    Ref<BrowseCache> cache = BrowseCache::getInstance();
+    if (cache->contains(objectID, flags, startingIndex, requestedCount, updateID, systemUpdateID))
+        return;
+
+    Task task;
+    task.client = string_ok(client) ? client.c_str() : "";
+    task.objectID = objectID;
+    task.flags = flags;
+    task.startingIndex = startingIndex;
+    task.requestedCount = requestedCount;
+    task.updateID = updateID;
+    task.systemUpdateID = systemUpdateID;
+    task.parentID = parentID;
+    task.generation = cache->getGeneration();
+    task.render = render;
+
+    AutoLock lock(mutex);
+    if (shutdownFlag)
+        return;
+    int& clientPending = pending[task.client];
+    if (clientPending >= budget)
+        return;
+    clientPending++;
+    queue.push_back(std::move(task));
+    cond.notify_one();
+}
+
+void BrowsePrefetcher::threadProc()
+{
+    Ref<BrowseCache> cache = BrowseCache::getInstance();
+
+    unique_lock<mutex_type> lock(mutex);
+    while (!shutdownFlag) {
+        if (queue.empty()) {
+            cond.wait(lock);
+            continue;
+        }
+
+        Task task = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        // cancelled by an invalidation, or the client asked for the page
+        // in the meantime
+        if (cache->getGeneration() != task.generation)
+            cancelled++;
+        else if (!cache->contains(task.objectID, task.flags, task.startingIndex,
+                     task.requestedCount, task.updateID, task.systemUpdateID)) {
+            try {
+                cache->put(task.objectID, task.flags, task.startingIndex, task.requestedCount,
+                    task.updateID, task.systemUpdateID, task.generation, task.parentID, task.render());
+                rendered++;
+            } catch (const Exception& e) {
+                log_debug("prefetching %d failed: %s\n", task.objectID, e.getMessage().c_str());
+            }
+        }
+
+        lock.lock();
+        auto it = pending.find(task.client);
+        if (it != pending.end() && --it->second <= 0)
+            pending.erase(it);
+    }
+}
+
+void* BrowsePrefetcher::staticThreadProc(void* arg)
+{
+    log_debug("starting browse prefetch thread... thread: %d\n", pthread_self());
+    auto* inst = (BrowsePrefetcher*)arg;
+    inst->threadProc();
+    Storage::getInstance()->threadCleanup();
+
+    log_debug("browse prefetch thread shut down. thread: %d\n", pthread_self());
+    return nullptr;
+}
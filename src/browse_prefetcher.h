@@ -0,0 +1,108 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    browse_prefetcher.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file browse_prefetcher.h
+
+#ifndef __BROWSE_PREFETCHER_H__
+#define __BROWSE_PREFETCHER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+
+#include "browse_cache.h"
+#include "common.h"
+#include "singleton.h"
+
+/// \brief Renders the next page of a container into the BrowseCache
+/// while the client is busy with the page it just got.
+///
+/// Renderers page through containers sequentially, so after a page has
+/// been served the next one is queued for a background thread. Each
+/// client may only have a bounded number of pages queued. A page is
+/// dropped if the BrowseCache was invalidated after it was queued.
+class BrowsePrefetcher : public Singleton<BrowsePrefetcher>
+{
+public:
+    typedef std::function<std::shared_ptr<const BrowseResult>()> RenderFunction;
+
+    BrowsePrefetcher();
+    virtual void init() override;
+    virtual void shutdown() override;
+    zmm::String getName() override { return _("Browse Prefetcher"); }
+
+    inline bool isEnabled() { return enabled; }
+
+    /// \brief Queues a page.
+    /// \param client address of the client, the budget is kept per client
+    /// \param updateID update ID of the browsed container the page has to
+    /// be cached under
+    /// \param systemUpdateID systemUpdateID the page has to be cached under
+    /// \param render renders the page
+    void schedule(zmm::String client, int objectID, unsigned int flags,
+        int startingIndex, int requestedCount,
+        int updateID, int systemUpdateID, int parentID, RenderFunction render);
+
+protected:
+    struct Task {
+        std::string client;
+        int objectID;
+        unsigned int flags;
+        int startingIndex;
+        int requestedCount;
+        int updateID;
+        int systemUpdateID;
+        int parentID;
+        unsigned long generation;
+        RenderFunction render;
+    };
+
+    bool enabled;
+    int budget;
+    bool shutdownFlag;
+
+    pthread_t prefetchThread;
+    std::condition_variable cond;
+    std::deque<Task> queue;
+    /// \brief queued and running tasks per client
+    std::unordered_map<std::string, int> pending;
+
+    std::atomic<long> rendered;
+    std::atomic<long> cancelled;
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+};
+
+#endif // __BROWSE_PREFETCHER_H__
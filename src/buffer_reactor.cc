@@ -0,0 +1,244 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    buffer_reactor.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file buffer_reactor.cc
+
+#ifdef HAVE_EPOLL
+
+#include "buffer_reactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "config_manager.h"
+
+/// \brief maximum number of events fetched by one epoll_wait()
+#define BUFFER_REACTOR_MAX_EVENTS 64
+
+using namespace zmm;
+using namespace std;
+
+BufferReactor::BufferReactor()
+    : Singleton<BufferReactor>()
+    , threadCount(0)
+    , shutdownFlag(false)
+    , nextLoop(0)
+{
+    threadCount = ConfigManager::getInstance()->getIntOption(CFG_TRANSCODING_BUFFER_THREADS);
+}
+
+void BufferReactor::init()
+{
+    for (int i = 0; i < threadCount; i++) {
+        auto loop = new Loop();
+        loop->reactor = this;
+        loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        if (loop->epollFd < 0 || loop->wakeFd < 0
+            || epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &ev) != 0
+            || pthread_create(&loop->thread, nullptr, BufferReactor::staticThreadProc, loop) != 0) {
+            log_error("Could not start buffer reactor thread: %s\n", strerror(errno));
+            if (loop->epollFd >= 0)
+                close(loop->epollFd);
+            if (loop->wakeFd >= 0)
+                close(loop->wakeFd);
+            delete loop;
+            break;
+        }
+        loops.push_back(loop);
+    }
+    threadCount = loops.size();
+    if (threadCount > 0)
+        log_debug("Started %d buffer reactor threads\n", threadCount);
+}
+
+void BufferReactor::shutdown()
+{
+    unique_lock<mutex_type> lock(mutex);
+    shutdownFlag = true;
+    lock.unlock();
+
+    uint64_t one = 1;
+    for (auto loop : loops) {
+        if (write(loop->wakeFd, &one, sizeof(one)) < 0)
+            log_debug("could not wake buffer reactor: %s\n", strerror(errno));
+    }
+    for (auto loop : loops) {
+        pthread_join(loop->thread, nullptr);
+        close(loop->epollFd);
+        close(loop->wakeFd);
+        delete loop;
+    }
+    loops.clear();
+    streams.clear();
+}
+
+bool BufferReactor::add(ReactorStream* stream, int fd)
+{
+    AutoLock lock(mutex);
+    if (shutdownFlag || loops.empty())
+        return false;
+
+    Loop* loop = loops[nextLoop++ % loops.size()];
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = stream;
+    if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        log_warning("Could not add stream to the buffer reactor: %s\n", strerror(errno));
+        return false;
+    }
+    streams[stream] = { loop, fd };
+    return true;
+}
+
+void BufferReactor::remove(ReactorStream* stream)
+{
+    unique_lock<mutex_type> lock(mutex);
+    auto it = streams.find(stream);
+    if (it == streams.end())
+        return;
+    Loop* loop = it->second.loop;
+    epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    streams.erase(it);
+    lock.unlock();
+
+    {
+        lock_guard<std::mutex> kickLock(loop->kickMutex);
+        for (auto k = loop->kicked.begin(); k != loop->kicked.end();) {
+            if (*k == stream)
+                k = loop->kicked.erase(k);
+            else
+                ++k;
+        }
+    }
+
+    // wait for a callback of the stream that may be running right now,
+    // later rounds no longer find it in the registry
+    lock_guard<std::mutex> dispatchLock(loop->dispatchMutex);
+}
+
+void BufferReactor::kick(ReactorStream* stream)
+{
+    Loop* loop;
+    {
+        AutoLock lock(mutex);
+        auto it = streams.find(stream);
+        if (it == streams.end())
+            return;
+        loop = it->second.loop;
+    }
+
+    lock_guard<std::mutex> kickLock(loop->kickMutex);
+    loop->kicked.push_back(stream);
+    uint64_t one = 1;
+    if (write(loop->wakeFd, &one, sizeof(one)) < 0)
+        log_debug("could not wake buffer reactor: %s\n", strerror(errno));
+}
+
+bool BufferReactor::lookup(ReactorStream* stream, Loop* loop, int* fd)
+{
+    AutoLock lock(mutex);
+    auto it = streams.find(stream);
+    if (it == streams.end() || it->second.loop != loop)
+        return false;
+    *fd = it->second.fd;
+    return true;
+}
+
+void BufferReactor::dispatch(Loop* loop, ReactorStream* stream)
+{
+    int fd;
+    if (!lookup(stream, loop, &fd))
+        return;
+
+    if (stream->onReadable()) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = stream;
+        epoll_ctl(loop->epollFd, EPOLL_CTL_MOD, fd, &ev);
+    }
+}
+
+void BufferReactor::threadProc(Loop* loop)
+{
+    struct epoll_event events[BUFFER_REACTOR_MAX_EVENTS];
+
+    while (true) {
+        int count = epoll_wait(loop->epollFd, events, BUFFER_REACTOR_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            log_error("buffer reactor: epoll_wait failed: %s\n", strerror(errno));
+            break;
+        }
+
+        lock_guard<std::mutex> dispatchLock(loop->dispatchMutex);
+        for (int i = 0; i < count; i++) {
+            auto stream = static_cast<ReactorStream*>(events[i].data.ptr);
+            if (stream != nullptr) {
+                dispatch(loop, stream);
+                continue;
+            }
+
+            uint64_t value;
+            if (read(loop->wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+                log_debug("could not reset buffer reactor wakeup: %s\n", strerror(errno));
+
+            {
+                AutoLock lock(mutex);
+                if (shutdownFlag)
+                    return;
+            }
+
+            deque<ReactorStream*> kicked;
+            {
+                lock_guard<std::mutex> kickLock(loop->kickMutex);
+                kicked.swap(loop->kicked);
+            }
+            for (auto k : kicked)
+                dispatch(loop, k);
+        }
+    }
+}
+
+void* BufferReactor::staticThreadProc(void* arg)
+{
+    auto loop = static_cast<Loop*>(arg);
+    log_debug("starting buffer reactor thread... thread: %d\n", pthread_self());
+    loop->reactor->threadProc(loop);
+    log_debug("buffer reactor thread shut down. thread: %d\n", pthread_self());
+    pthread_exit(nullptr);
+    return nullptr;
+}
+
+#endif // HAVE_EPOLL
@@ -0,0 +1,121 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    buffer_reactor.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file buffer_reactor.h
+/// \brief Definition of the BufferReactor class.
+
+#ifdef HAVE_EPOLL
+
+#ifndef __BUFFER_REACTOR_H__
+#define __BUFFER_REACTOR_H__
+
+#include <deque>
+#include <mutex>
+#include <pthread.h>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "singleton.h"
+
+/// \brief A stream that is filled by the BufferReactor.
+class ReactorStream
+{
+public:
+    virtual ~ReactorStream() = default;
+
+    /// \brief Called on a reactor thread when the descriptor of the
+    /// stream is readable or the stream was kicked. Must not block.
+    /// \return true if the stream wants to be woken up again as soon as
+    /// its descriptor is readable, false to stay parked until kicked
+    virtual bool onReadable() = 0;
+};
+
+/// \brief Fills the buffers of all streaming BufferedIOHandlers from a
+/// few epoll threads.
+///
+/// Every stream is assigned to one reactor thread and registered with
+/// EPOLLONESHOT, so at most one chunk read per stream is in flight. A
+/// stream whose buffer is full parks itself and is kicked back by the
+/// reader once there is room again.
+class BufferReactor : public Singleton<BufferReactor>
+{
+public:
+    BufferReactor();
+    virtual void init() override;
+    virtual void shutdown() override;
+    zmm::String getName() override { return _("Buffer Reactor"); }
+
+    /// \brief true if streams are filled by the reactor, false if each
+    /// one still runs its own buffer thread
+    inline bool isEnabled() { return threadCount > 0; }
+
+    /// \brief Registers a stream, filling starts once fd is readable.
+    /// \return false if the stream could not be registered
+    bool add(ReactorStream* stream, int fd);
+
+    /// \brief Unregisters a stream. When this returns no callback of the
+    /// stream runs anymore and none will be started.
+    void remove(ReactorStream* stream);
+
+    /// \brief Runs the callback of a stream as soon as possible,
+    /// regardless of its descriptor.
+    void kick(ReactorStream* stream);
+
+protected:
+    struct Loop {
+        BufferReactor* reactor;
+        pthread_t thread;
+        int epollFd;
+        int wakeFd;
+        /// \brief held while the callbacks of one round are dispatched
+        std::mutex dispatchMutex;
+        std::mutex kickMutex;
+        std::deque<ReactorStream*> kicked;
+    };
+
+    struct Registration {
+        Loop* loop;
+        int fd;
+    };
+
+    int threadCount;
+    bool shutdownFlag;
+    unsigned int nextLoop;
+    std::vector<Loop*> loops;
+    std::unordered_map<ReactorStream*, Registration> streams;
+
+    bool lookup(ReactorStream* stream, Loop* loop, int* fd);
+    void dispatch(Loop* loop, ReactorStream* stream);
+    void threadProc(Loop* loop);
+    static void* staticThreadProc(void* arg);
+};
+
+#endif // __BUFFER_REACTOR_H__
+
+#endif // HAVE_EPOLL
@@ -30,10 +30,17 @@
 /// \file buffered_io_handler.cc
 
 #include <cassert>
+#ifdef HAVE_EPOLL
+#include <poll.h>
+#endif
 
 #include "buffered_io_handler.h"
 #include "tools.h"
 
+/// \brief seconds read() waits for the reactor before it asks libupnp to
+/// check the socket, matches the fifo timeouts of ProcessIOHandler
+#define BUFFER_CHECK_SOCKET_TIMEOUT 6
+
 
 using namespace zmm;
 using namespace std;
@@ -46,11 +53,30 @@ BufferedIOHandler::BufferedIOHandler(Ref<IOHandler> underlyingHandler, size_t bu
         throw _Exception(_("maxChunkSize must be positive"));
     this->underlyingHandler = underlyingHandler;
     this->maxChunkSize = maxChunkSize;
+#ifdef HAVE_EPOLL
+    parked = false;
+#endif
     
     // test it first!
     //seekEnabled = true;
 }
 
+BufferedIOHandler::~BufferedIOHandler()
+{
+    // close here, the base class can not reach our stopBufferThread()
+    if (isOpen)
+    {
+        try
+        {
+            close();
+        }
+        catch (const Exception & ex)
+        {
+            log_error("Could not close buffered stream: %s\n", ex.getMessage().c_str());
+        }
+    }
+}
+
 void BufferedIOHandler::open(IN enum UpnpOpenFileMode mode)
 {
     // do the open here instead of threadProc() because it may throw an exception
@@ -99,63 +125,7 @@ void BufferedIOHandler::threadProc()
         if (empty)
             a = b = 0;
         
-        if (doSeek && ! empty && 
-                (
-                    seekWhence == SEEK_SET ||
-                    (seekWhence == SEEK_CUR && seekOffset > 0)
-                )
-            )
-        {
-            int currentFillSize = b - a;
-            if (currentFillSize <= 0)
-                currentFillSize += bufSize;
-            
-            int relSeek = seekOffset;
-            if (seekWhence == SEEK_SET)
-                relSeek -= posRead;
-            
-            if (relSeek <= currentFillSize)
-            { // we have everything we need in the buffer already
-                a += relSeek;
-                posRead += relSeek;
-                if (a >= bufSize)
-                    a -= bufSize;
-                if (a == b)
-                {
-                    empty = true;
-                    a = b = 0;
-                }
-                
-                /// \todo do we need to wait for initialFillSize again?
-                
-                doSeek = false;
-                cond.notify_one();
-            }
-        }
-        
-        // note: seeking could be optimized some more (backward seeking)
-        // but this should suffice for now
-        
-        if (doSeek)
-        { // seek not been processed yet
-            try
-            {
-                underlyingHandler->seek(seekOffset, seekWhence);
-                empty = true;
-                a = b = 0;
-            }
-            catch (const Exception & e)
-            {
-                log_error("Error while seeking in buffer: %s\n", e.getMessage().c_str());
-                e.printStackTrace();
-            }
-            
-            /// \todo should we do that?
-            waitForInitialFillSize = (initialFillSize > 0);
-            
-            doSeek = false;
-            cond.notify_one();
-        }
+        processSeek();
         
         maxWrite = (empty ? bufSize : (a < b ? bufSize - b : a - b));
         if (maxWrite == 0)
@@ -168,35 +138,7 @@ void BufferedIOHandler::threadProc()
             size_t chunkSize = (maxChunkSize > maxWrite ? maxWrite : maxChunkSize);
             readBytes = underlyingHandler->read(buffer + b, chunkSize);
             lock.lock();
-            if (readBytes > 0)
-            {
-                b += readBytes;
-                assert(b <= bufSize);
-                if (b == bufSize)
-                    b = 0;
-                if (empty)
-                {
-                    empty = false;
-                    cond.notify_one();
-                }
-                if (waitForInitialFillSize)
-                {
-                    int currentFillSize = b - a;
-                    if (currentFillSize <= 0)
-                        currentFillSize += bufSize;
-                    if ((size_t)currentFillSize >= initialFillSize)
-                    {
-                        log_debug("buffer: initial fillsize reached\n");
-                        waitForInitialFillSize = false;
-                        cond.notify_one();
-                    }
-                }
-            }
-            else if (readBytes == CHECK_SOCKET)
-            {
-                checkSocket = true;
-                cond.notify_one();
-            }
+            commitChunk(readBytes);
         }
     }
     while((maxWrite == 0 || readBytes > 0 || readBytes == CHECK_SOCKET) && ! threadShutdown);
@@ -210,3 +152,195 @@ void BufferedIOHandler::threadProc()
     // ensure that read() doesn't wait for me to fill the buffer
     cond.notify_one();
 }
+
+void BufferedIOHandler::processSeek()
+{
+    if (doSeek && ! empty && 
+            (
+                seekWhence == SEEK_SET ||
+                (seekWhence == SEEK_CUR && seekOffset > 0)
+            )
+        )
+    {
+        int currentFillSize = b - a;
+        if (currentFillSize <= 0)
+            currentFillSize += bufSize;
+
+        int relSeek = seekOffset;
+        if (seekWhence == SEEK_SET)
+            relSeek -= posRead;
+
+        if (relSeek <= currentFillSize)
+        { // we have everything we need in the buffer already
+            a += relSeek;
+            posRead += relSeek;
+            if (a >= bufSize)
+                a -= bufSize;
+            if (a == b)
+            {
+                empty = true;
+                a = b = 0;
+            }
+
+            /// \todo do we need to wait for initialFillSize again?
+
+            doSeek = false;
+            cond.notify_one();
+        }
+    }
+
+    // note: seeking could be optimized some more (backward seeking)
+    // but this should suffice for now
+
+    if (doSeek)
+    { // seek not been processed yet
+        try
+        {
+            underlyingHandler->seek(seekOffset, seekWhence);
+            empty = true;
+            a = b = 0;
+        }
+        catch (const Exception & e)
+        {
+            log_error("Error while seeking in buffer: %s\n", e.getMessage().c_str());
+            e.printStackTrace();
+        }
+
+        /// \todo should we do that?
+        waitForInitialFillSize = (initialFillSize > 0);
+
+        doSeek = false;
+        cond.notify_one();
+    }
+}
+
+void BufferedIOHandler::commitChunk(int readBytes)
+{
+    if (readBytes > 0)
+    {
+        b += readBytes;
+        assert(b <= bufSize);
+        if (b == bufSize)
+            b = 0;
+        if (empty)
+        {
+            empty = false;
+            cond.notify_one();
+        }
+        if (waitForInitialFillSize)
+        {
+            int currentFillSize = b - a;
+            if (currentFillSize <= 0)
+                currentFillSize += bufSize;
+            if ((size_t)currentFillSize >= initialFillSize)
+            {
+                log_debug("buffer: initial fillsize reached\n");
+                waitForInitialFillSize = false;
+                cond.notify_one();
+            }
+        }
+    }
+    else if (readBytes == CHECK_SOCKET)
+    {
+        checkSocket = true;
+        cond.notify_one();
+    }
+}
+
+#ifdef HAVE_EPOLL
+
+void BufferedIOHandler::startBufferThread()
+{
+    int fd = underlyingHandler->getPollFd();
+    Ref<BufferReactor> r = BufferReactor::getInstance();
+    if (fd >= 0 && r->isEnabled())
+    {
+        // set before add(), the reactor may call us right away
+        reactor = r;
+        checkSocketTimeout = BUFFER_CHECK_SOCKET_TIMEOUT;
+        underlyingHandler->setShortReads(true);
+        if (r->add(this, fd))
+            return;
+        underlyingHandler->setShortReads(false);
+        reactor = nullptr;
+        checkSocketTimeout = 0;
+    }
+    IOHandlerBufferHelper::startBufferThread();
+}
+
+void BufferedIOHandler::stopBufferThread()
+{
+    if (reactor == nullptr)
+    {
+        IOHandlerBufferHelper::stopBufferThread();
+        return;
+    }
+    
+    unique_lock<std::mutex> lock(mutex);
+    threadShutdown = true;
+    cond.notify_one();
+    lock.unlock();
+    
+    reactor->remove(this);
+    reactor = nullptr;
+}
+
+void BufferedIOHandler::notifyWriter()
+{
+    cond.notify_one();
+    if (reactor != nullptr && (parked || doSeek))
+    {
+        parked = false;
+        reactor->kick(this);
+    }
+}
+
+bool BufferedIOHandler::onReadable()
+{
+    unique_lock<std::mutex> lock(mutex);
+    if (threadShutdown || eof || readError)
+        return false;
+    
+    if (empty)
+        a = b = 0;
+    
+    processSeek();
+    
+    size_t maxWrite = (empty ? bufSize : (a < b ? bufSize - b : a - b));
+    if (maxWrite == 0)
+    {
+        // read() kicks us once there is room again
+        parked = true;
+        return false;
+    }
+    lock.unlock();
+    
+    // kicks arrive regardless of the descriptor, never block the reactor
+    struct pollfd pfd;
+    pfd.fd = underlyingHandler->getPollFd();
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) <= 0)
+        return true;
+    
+    size_t chunkSize = (maxChunkSize > maxWrite ? maxWrite : maxChunkSize);
+    int readBytes = underlyingHandler->read(buffer + b, chunkSize);
+    lock.lock();
+    if (threadShutdown)
+        return false;
+    if (readBytes > 0 || readBytes == CHECK_SOCKET)
+    {
+        commitChunk(readBytes);
+        return true;
+    }
+    
+    if (readBytes == 0)
+        eof = true;
+    else
+        readError = true;
+    // ensure that read() doesn't wait for us to fill the buffer
+    cond.notify_one();
+    return false;
+}
+
+#endif // HAVE_EPOLL
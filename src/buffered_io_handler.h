@@ -36,11 +36,21 @@
 
 #include "common.h"
 #include "io_handler_buffer_helper.h"
+#ifdef HAVE_EPOLL
+#include "buffer_reactor.h"
+#endif
 
 /// \brief a IOHandler with buffer support
 /// the buffer is only for read(). write() is not supported
 /// the public functions of this class are *not* thread safe!
+///
+/// If the underlying handler has a pollable descriptor and the
+/// BufferReactor is enabled, the buffer is filled by the reactor instead
+/// of a thread of its own.
 class BufferedIOHandler : public IOHandlerBufferHelper
+#ifdef HAVE_EPOLL
+    , public ReactorStream
+#endif
 {
 public:
     
@@ -52,6 +62,7 @@ public:
     /// before the first read at the very beginning or after a seek returns;
     /// 0 disables the delay
     BufferedIOHandler(zmm::Ref<IOHandler> underlyingHandler, size_t bufSize, size_t maxChunkSize, size_t initialFillSize);
+    virtual ~BufferedIOHandler();
     
     virtual void open(enum UpnpOpenFileMode mode);
     virtual void close();
@@ -61,6 +72,24 @@ private:
     size_t maxChunkSize;
     
     virtual void threadProc();
+    
+    /// \brief processes a pending seek, called with the mutex held
+    void processSeek();
+    /// \brief accounts a chunk the underlying handler returned, called
+    /// with the mutex held
+    void commitChunk(int readBytes);
+    
+#ifdef HAVE_EPOLL
+    /// \brief set while the buffer is filled by the BufferReactor
+    zmm::Ref<BufferReactor> reactor;
+    /// \brief true while the reactor waits for room in the buffer
+    bool parked;
+    
+    virtual void startBufferThread();
+    virtual void stopBufferThread();
+    virtual void notifyWriter();
+    virtual bool onReadable();
+#endif
 };
 
 #endif // __BUFFERED_IO_HANDLER_H__
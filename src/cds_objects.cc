@@ -288,6 +288,7 @@ CdsContainer::CdsContainer() : CdsObject()
     childCount = -1;
     upnpClass = _(UPNP_DEFAULT_CLASS_CONTAINER);
     autoscanType = OBJECT_AUTOSCAN_NONE;
+    artObjectID = INVALID_OBJECT_ID;
 }
 
 void CdsContainer::copyTo(Ref<CdsObject> obj)
@@ -297,6 +298,7 @@ void CdsContainer::copyTo(Ref<CdsObject> obj)
         return;
     Ref<CdsContainer> cont = RefCast(obj, CdsContainer);
     cont->setUpdateID(updateID);
+    cont->setArtObjectID(artObjectID);
 }
 int CdsContainer::equals(Ref<CdsObject> obj, bool exactly)
 {
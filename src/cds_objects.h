@@ -541,6 +541,9 @@ protected:
     
     /// \brief wheather this container is an autoscan start point.
     int autoscanType;
+
+    /// \brief image item used as album art for this container
+    int artObjectID;
     
 public:
     /// \brief Constructor, initializes default values for the flags and sets the object type.
@@ -569,6 +572,12 @@ public:
     
     /// \brief sets wheather this container is an autoscan start point.
     inline void setAutoscanType(int type) { autoscanType = type; }
+
+    /// \brief Set the ID of the image item representing this container.
+    inline void setArtObjectID(int artObjectID) { this->artObjectID = artObjectID; }
+
+    /// \brief Retrieve the ID of the art image, INVALID_OBJECT_ID if there is none.
+    inline int getArtObjectID() { return artObjectID; }
     
     /// \brief Copies all object properties to another object.
     /// \param obj target object (clone)
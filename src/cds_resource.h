@@ -45,6 +45,9 @@
 
 #define RESOURCE_OPTION_FOURCC      "4cc"
 
+/// \brief file resolved by the FanArtHandler at import time
+#define RESOURCE_OPTION_FANART_PATH "fap"
+
 class CdsResource : public zmm::Object
 {
 protected:
@@ -39,6 +39,10 @@
 
 using namespace zmm;
 using namespace mxml;
+using namespace std;
+
+std::mutex CdsResourceManager::plansMutex;
+shared_ptr<CdsResourceManager::RenderPlans> CdsResourceManager::currentPlans;
 
 CdsResourceManager::CdsResourceManager() : Object()
 {
@@ -74,17 +78,122 @@ String CdsResourceManager::renderExtension(String contentType, String location)
     return nullptr;
 }
 
-void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
+CdsResourceManager::RenderPlans::RenderPlans(Ref<Dictionary> mappings,
+    Ref<TranscodingProfileList> transcoding, String virtualURL)
+{
+    this->mappings = mappings;
+    this->transcoding = transcoding;
+    this->virtualURL = virtualURL;
+    mediaPrefix = virtualURL + _(_URL_PARAM_SEPARATOR) + CONTENT_MEDIA_HANDLER +
+                  _(_URL_PARAM_SEPARATOR) + URL_OBJECT_ID + _(_URL_PARAM_SEPARATOR);
+    onlinePrefix = virtualURL + _(_URL_PARAM_SEPARATOR) + CONTENT_ONLINE_HANDLER +
+                   _(_URL_PARAM_SEPARATOR) + URL_OBJECT_ID + _(_URL_PARAM_SEPARATOR);
+    resIDSuffix = _(_URL_PARAM_SEPARATOR) + URL_RESOURCE_ID + _(_URL_PARAM_SEPARATOR);
+    servePrefix = virtualURL + _(_URL_PARAM_SEPARATOR) + CONTENT_SERVE_HANDLER +
+                  _(_URL_PARAM_SEPARATOR);
+}
+
+shared_ptr<const CdsResourceManager::MimeTypePlan> CdsResourceManager::RenderPlans::get(String mimeType)
+{
+    string key = string_ok(mimeType) ? mimeType.c_str() : "";
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = mimeTypes.find(key);
+    if (it != mimeTypes.end())
+        return it->second;
+
+    auto plan = make_shared<MimeTypePlan>();
+    plan->contentType = mappings->get(mimeType);
+    plan->extension = renderExtension(plan->contentType, nullptr);
+
+    Ref<ObjectDictionary<TranscodingProfile> > tp_mt = transcoding->get(mimeType);
+    if (tp_mt != nullptr)
+    {
+        plan->transcodable = true;
+        Ref<Array<ObjectDictionaryElement<TranscodingProfile> > > profiles = tp_mt->getElements();
+        for (int p = 0; p < profiles->size(); p++)
+        {
+            Ref<TranscodingProfile> tp = profiles->get(p)->getValue();
+
+            if (tp == nullptr)
+                throw _Exception(_("Invalid profile encountered!"));
+
+            ProfilePlan pp;
+            pp.profile = tp;
+
+            Ref<Array<StringBase> > fcc_list = tp->getAVIFourCCList();
+            if (fcc_list != nullptr)
+            {
+                for (int f = 0; f < fcc_list->size(); f++)
+                    pp.fourccs.insert(fcc_list->get(f)->data);
+            }
+
+            String targetMimeType = tp->getTargetMimeType();
+            bool fromSource = false;
+            if (!tp->isThumbnail())
+            {
+                int freq = tp->getSampleFreq();
+                if (freq == SOURCE)
+                    fromSource = true;
+                else if (freq != OFF)
+                {
+                    pp.sampleFrequency = String::from(freq);
+                    targetMimeType = targetMimeType + _(";rate=") + pp.sampleFrequency;
+                }
+
+                int chan = tp->getNumChannels();
+                if (chan == SOURCE)
+                    fromSource = true;
+                else if (chan != OFF)
+                {
+                    pp.nrAudioChannels = String::from(chan);
+                    targetMimeType = targetMimeType + _(";channels=") + pp.nrAudioChannels;
+                }
+            }
+            if (!fromSource)
+                pp.protocolInfo = renderProtocolInfo(targetMimeType);
+
+            plan->profiles.push_back(pp);
+        }
+    }
+
+    mimeTypes[key] = plan;
+    return plan;
+}
+
+shared_ptr<CdsResourceManager::RenderPlans> CdsResourceManager::getPlans()
 {
-    Ref<UrlBase> urlBase = addResources_getUrlBase(item);
+    Ref<ConfigManager> config = ConfigManager::getInstance();
+    Ref<Dictionary> mappings = config->getDictionaryOption(
+                        CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
+    Ref<TranscodingProfileList> tlist = config->getTranscodingProfileListOption(
+            CFG_TRANSCODING_PROFILE_LIST);
+    String virtualURL = Server::getInstance()->getVirtualURL();
+
+    std::lock_guard<std::mutex> lock(plansMutex);
+    if (currentPlans == nullptr || currentPlans->mappings != mappings ||
+        currentPlans->transcoding != tlist || currentPlans->virtualURL != virtualURL)
+    {
+        currentPlans = make_shared<RenderPlans>(mappings, tlist, virtualURL);
+    }
+    return currentPlans;
+}
+
+void CdsResourceManager::addResources(Ref<CdsItem> item, DidlSink& element)
+{
+    shared_ptr<RenderPlans> plans = getPlans();
+    shared_ptr<const MimeTypePlan> plan = plans->get(item->getMimeType());
+    Ref<UrlBase> urlBase = addResources_getUrlBase(item, false, plans);
     Ref<ConfigManager> config = ConfigManager::getInstance();
     bool skipURL = ((IS_CDS_ITEM_INTERNAL_URL(item->getObjectType()) || 
                     IS_CDS_ITEM_EXTERNAL_URL(item->getObjectType())) &&
                     (!item->getFlag(OBJECT_FLAG_PROXY_URL)));
 
     bool isExtThumbnail = false; // this sucks
-    Ref<Dictionary> mappings = config->getDictionaryOption(
-                        CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
+    Ref<Dictionary> mappings = plans->mappings;
+#ifdef EXTEND_PROTOCOLINFO
+    bool extendProtocolInfo = config->getBoolOption(CFG_SERVER_EXTEND_PROTOCOLINFO);
+    bool smHack = config->getBoolOption(CFG_SERVER_EXTEND_PROTOCOLINFO_SM_HACK);
+#endif
 
 #if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
     if (config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED) && 
@@ -132,21 +241,14 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
     //
     // TODO: allow transcoding for URLs
         
-    // now get the profile
-    Ref<TranscodingProfileList> tlist = config->getTranscodingProfileListOption(
-            CFG_TRANSCODING_PROFILE_LIST);
-    Ref<ObjectDictionary<TranscodingProfile> > tp_mt = tlist->get(item->getMimeType());
-    if (tp_mt != nullptr)
+    // now get the profiles, matched against the item below
+    if (plan->transcodable)
     {
-        Ref<Array<ObjectDictionaryElement<TranscodingProfile> > > profiles = tp_mt->getElements();
-        for (int p = 0; p < profiles->size(); p++)
+        for (const auto& pp : plan->profiles)
         {
-            Ref<TranscodingProfile> tp = profiles->get(p)->getValue();
-
-            if (tp == nullptr)
-                throw _Exception(_("Invalid profile encountered!"));
+            Ref<TranscodingProfile> tp = pp.profile;
 
-            String ct = mappings->get(item->getMimeType());
+            String ct = plan->contentType;
             if (ct == CONTENT_TYPE_OGG) 
             {
                 if (((item->getFlag(OBJECT_FLAG_OGG_THEORA)) && 
@@ -162,7 +264,6 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
             {
                 avi_fourcc_listmode_t fcc_mode = tp->getAVIFourCCListMode();
 
-                Ref<Array<StringBase> > fcc_list = tp->getAVIFourCCList();
                 // mode is either process or ignore, so we will have to take a
                 // look at the settings
                 if (fcc_mode != FCC_None)
@@ -182,12 +283,7 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
                     // let's have a look if it matches the list
                     else
                     {
-                        bool fcc_match = false;
-                        for (int f = 0; f < fcc_list->size(); f++)
-                        {
-                            if (current_fcc == fcc_list->get(f)->data)
-                                fcc_match = true;
-                        }
+                        bool fcc_match = (pp.fourccs.find(current_fcc.c_str()) != pp.fourccs.end());
                        
                         if (!fcc_match && (fcc_mode == FCC_Process))
                             continue;
@@ -206,6 +302,7 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
                          item->getResource(0)->getOption(_(CONTENT_TYPE_OGG)));
             t_res->addParameter(_(URL_PARAM_TRANSCODE), _(URL_VALUE_TRANSCODE));
 
+            String protocolInfo = pp.protocolInfo;
             String targetMimeType = tp->getTargetMimeType();
 
             if (!tp->isThumbnail())
@@ -217,8 +314,14 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
                     t_res->addAttribute(MetadataHandler::getResAttrName(R_DURATION),
                             duration);
 
-                int freq = tp->getSampleFreq();
-                if (freq == SOURCE)
+                if (pp.sampleFrequency != nullptr)
+                {
+                    t_res->addAttribute(MetadataHandler::getResAttrName(R_SAMPLEFREQUENCY), pp.sampleFrequency);
+                    if (protocolInfo == nullptr)
+                        targetMimeType = targetMimeType + _(";rate=") +
+                                         pp.sampleFrequency;
+                }
+                else if (tp->getSampleFreq() == SOURCE)
                 {
                     String frequency = item->getResource(0)->getAttribute(MetadataHandler::getResAttrName(R_SAMPLEFREQUENCY));
                     if (string_ok(frequency))
@@ -228,15 +331,15 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
                                          frequency;
                     }
                 }
-                else if (freq != OFF)
+
+                if (pp.nrAudioChannels != nullptr)
                 {
-                    t_res->addAttribute(MetadataHandler::getResAttrName(R_SAMPLEFREQUENCY), String::from(freq));
-                    targetMimeType = targetMimeType + _(";rate=") + 
-                                     String::from(freq);
+                    t_res->addAttribute(MetadataHandler::getResAttrName(R_NRAUDIOCHANNELS), pp.nrAudioChannels);
+                    if (protocolInfo == nullptr)
+                        targetMimeType = targetMimeType + _(";channels=") +
+                                         pp.nrAudioChannels;
                 }
-
-                int chan = tp->getNumChannels();
-                if (chan == SOURCE)
+                else if (tp->getNumChannels() == SOURCE)
                 {
                     String nchannels = item->getResource(0)->getAttribute(MetadataHandler::getResAttrName(R_NRAUDIOCHANNELS));
                     if (string_ok(nchannels))
@@ -246,16 +349,12 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
                                          nchannels;
                     }
                 }
-                else if (chan != OFF)
-                {
-                    t_res->addAttribute(MetadataHandler::getResAttrName(R_NRAUDIOCHANNELS), String::from(chan));
-                    targetMimeType = targetMimeType + _(";channels=") + 
-                                     String::from(chan);
-                }
             }
 
+            if (protocolInfo == nullptr)
+                protocolInfo = renderProtocolInfo(targetMimeType);
             t_res->addAttribute(MetadataHandler::getResAttrName(R_PROTOCOLINFO),
-                    renderProtocolInfo(targetMimeType));
+                    protocolInfo);
 
             if (tp->isThumbnail())
                 t_res->addOption(_(RESOURCE_CONTENT_TYPE), _(EXIF_THUMBNAIL));
@@ -275,7 +374,7 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
         }
 
         if (skipURL)
-            urlBase_tr = addResources_getUrlBase(item, true);
+            urlBase_tr = addResources_getUrlBase(item, true, plans);
     }
 
     int resCount = item->getResourceCount();
@@ -298,7 +397,8 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
         }
 
         assert(string_ok(mimeType));
-        String contentType = mappings->get(mimeType);
+        shared_ptr<const MimeTypePlan> resPlan = plans->get(mimeType);
+        String contentType = resPlan->contentType;
         String url;
 
         /// \todo who will sync mimetype that is part of the protocol info and
@@ -372,18 +472,18 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
                 else
                     rct = res->getParameter(_(RESOURCE_CONTENT_TYPE));
                 if (rct == ID3_ALBUM_ART) {
-                    Ref<Element> aa(new Element(MetadataHandler::getMetaFieldName(M_ALBUMARTURI)));
-                    aa->setText(url);
+                    element.startElement(MetadataHandler::getMetaFieldName(M_ALBUMARTURI));
 #ifdef EXTEND_PROTOCOLINFO
-                    if (config->getBoolOption(CFG_SERVER_EXTEND_PROTOCOLINFO)) {
+                    if (extendProtocolInfo) {
                         /// \todo clean this up, make sure to check the mimetype and
                         /// provide the profile correctly
-                        aa->setAttribute(_("xmlns:dlna"),
+                        element.attribute(_("xmlns:dlna"),
                                          _("urn:schemas-dlna-org:metadata-1-0"));
-                        aa->setAttribute(_("dlna:profileID"), _("JPEG_TN"));
+                        element.attribute(_("dlna:profileID"), _("JPEG_TN"));
                     }
 #endif
-                    element->appendElementChild(aa);
+                    element.text(url);
+                    element.endElement();
                     continue;
                 }
             }
@@ -397,14 +497,14 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
             // first resource
             if (!skipURL)
             {
-                if (transcoded)
-                    url = url + renderExtension(contentType, nullptr);
+                if (transcoded || resPlan->extension != nullptr)
+                    url = url + resPlan->extension;
                 else
-                    url = url + renderExtension(contentType, item->getLocation()); 
+                    url = url + renderExtension(contentType, item->getLocation());
             }
         }
 #ifdef EXTEND_PROTOCOLINFO
-        if (config->getBoolOption(CFG_SERVER_EXTEND_PROTOCOLINFO))
+        if (extendProtocolInfo)
         {
             String extend;
             if (contentType == CONTENT_TYPE_MP3)
@@ -430,7 +530,7 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
                                               == THUMBNAIL)) &&
               (x <= 160) && (y <= 160))
                         extend = _(D_PROFILE) + "=" + D_JPEG_TN+";";
-                    else if ((x <= 640) && (y <= 420))
+                    else if ((x <= 640) && (y <= 480))
                         extend = _(D_PROFILE) + "=" + D_JPEG_SM+";";
                     else if ((x <= 1024) && (y <=768))
                         extend = _(D_PROFILE) + "=" + D_JPEG_MED+";";
@@ -459,11 +559,11 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
         res_attrs->put(MetadataHandler::getResAttrName(R_PROTOCOLINFO),
                        protocolInfo);
 
-        if (config->getBoolOption(CFG_SERVER_EXTEND_PROTOCOLINFO_SM_HACK))
+        if (smHack)
         {
             if (mimeType.startsWith(_("video")))
             {
-                element->appendElementChild(UpnpXML_DIDLRenderCaptionInfo(url));
+                UpnpXML_DIDLRenderCaptionInfo(element, url);
             }
         }
 
@@ -472,30 +572,25 @@ void CdsResourceManager::addResources(Ref<CdsItem> item, Ref<Element> element)
 #endif
         if (!hide_original_resource || transcoded || 
            (hide_original_resource && (original_resource != i)))
-            element->appendElementChild(UpnpXML_DIDLRenderResource(url, res_attrs));
+            UpnpXML_DIDLRenderResource(element, url, res_attrs);
     }
 }
 
-Ref<CdsResourceManager::UrlBase> CdsResourceManager::addResources_getUrlBase(Ref<CdsItem> item, bool forceLocal)
+Ref<CdsResourceManager::UrlBase> CdsResourceManager::addResources_getUrlBase(Ref<CdsItem> item, bool forceLocal, shared_ptr<RenderPlans> plans)
 {
-    Ref<Element> res;
+    if (plans == nullptr)
+        plans = getPlans();
 
     Ref<UrlBase> urlBase(new UrlBase);
     /// \todo resource options must be read from configuration files
 
-    Ref<Dictionary> dict(new Dictionary());
-    dict->put(_(URL_OBJECT_ID), String::from(item->getID()));
-
     urlBase->addResID = false;
     /// \todo move this down into the "for" loop and create different urls 
     /// for each resource once the io handlers are ready
     int objectType = item->getObjectType();
     if (IS_CDS_ITEM_INTERNAL_URL(objectType))
     {
-        urlBase->urlBase = Server::getInstance()->getVirtualURL() + 
-                           _(_URL_PARAM_SEPARATOR) + 
-                           CONTENT_SERVE_HANDLER + 
-                           _(_URL_PARAM_SEPARATOR) + item->getLocation();
+        urlBase->urlBase = plans->servePrefix + item->getLocation();
         return urlBase;
     }
 
@@ -510,21 +605,14 @@ Ref<CdsResourceManager::UrlBase> CdsResourceManager::addResources_getUrlBase(Ref
         if ((item->getFlag(OBJECT_FLAG_ONLINE_SERVICE) && 
                 item->getFlag(OBJECT_FLAG_PROXY_URL)) || forceLocal)
         {
-            urlBase->urlBase = Server::getInstance()->getVirtualURL() + 
-                _(_URL_PARAM_SEPARATOR) +
-                CONTENT_ONLINE_HANDLER + _(_URL_PARAM_SEPARATOR) +
-                dict->encodeSimple() + _(_URL_PARAM_SEPARATOR) +
-                _(URL_RESOURCE_ID) + _(_URL_PARAM_SEPARATOR);
+            urlBase->urlBase = plans->onlinePrefix + item->getID() +
+                               plans->resIDSuffix;
             urlBase->addResID = true;
             return urlBase;
         }
     }
 
-    urlBase->urlBase = Server::getInstance()->getVirtualURL() +
-                       _(_URL_PARAM_SEPARATOR) +
-                       CONTENT_MEDIA_HANDLER + _(_URL_PARAM_SEPARATOR) + 
-                       dict->encodeSimple() + _(_URL_PARAM_SEPARATOR) + 
-                       _(URL_RESOURCE_ID) + _(_URL_PARAM_SEPARATOR);
+    urlBase->urlBase = plans->mediaPrefix + item->getID() + plans->resIDSuffix;
     urlBase->addResID = true;
     return urlBase;
 }
@@ -549,4 +637,9 @@ String CdsResourceManager::getArtworkUrl(zmm::Ref<CdsItem> item) {
         return urlBase->urlBase + 1 + "/rct/aa";
     else
         return urlBase->urlBase;
+}
+
+String CdsResourceManager::getArtworkUrl(int objectID) {
+    shared_ptr<RenderPlans> plans = getPlans();
+    return plans->mediaPrefix + objectID + plans->resIDSuffix + 1 + "/rct/aa";
 }
\ No newline at end of file
@@ -36,7 +36,16 @@
 #include "mxml/mxml.h"
 #include "common.h"
 #include "cds_objects.h"
+#include "didl_writer.h"
 #include "strings.h"
+#include "dictionary.h"
+#include "transcoding/transcoding.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 /// \brief This class is responsible for handling the DIDL-Lite res tags.
 class CdsResourceManager : public zmm::Object
@@ -47,14 +56,14 @@ public:
 
     /// \brief Adds a resource tag to the item.
     /// \param item Item for which the resources should be added.
-    /// \param element Element in the XML to which the resource should be appended.
+    /// \param element receives the resource tags of the item.
     ///
     /// This function figures out what resources should be added to what files.
     /// It looks at the server configuration to find out what it needs. For example,
     /// if you want to add another mime/type alias for an existing mime/type, this
     /// function would do it. Also, when transcoding will be implemented, the
     /// various transcoded streams will be identified here.
-    static void addResources(zmm::Ref<CdsItem> item, zmm::Ref<mxml::Element> element);
+    static void addResources(zmm::Ref<CdsItem> item, DidlSink& element);
     
     /// \brief Gets the URL of the first resource of the CfsItem.
     /// \param item Item for which the resources should be built.
@@ -66,6 +75,12 @@ public:
     /// \return The URL
     static zmm::String getArtworkUrl(zmm::Ref<CdsItem> item);
 
+    /// \brief Gets the URL of the artwork of a local media item without
+    /// loading the item.
+    /// \param objectID ID of the item
+    /// \return The URL
+    static zmm::String getArtworkUrl(int objectID);
+
 protected:
     class UrlBase : public zmm::Object
     {
@@ -74,13 +89,73 @@ protected:
         bool addResID;
     };
 
+    /// \brief A transcoding profile with everything that does not depend
+    /// on the item worked out.
+    class ProfilePlan
+    {
+        public:
+        zmm::Ref<TranscodingProfile> profile;
+        std::unordered_set<std::string> fourccs;
+        /// \brief fixed values, nullptr if off or taken from the source
+        zmm::String sampleFrequency;
+        zmm::String nrAudioChannels;
+        /// \brief nullptr if the target mime type depends on the source
+        zmm::String protocolInfo;
+    };
+
+    /// \brief The part of the resource rendering that only depends on
+    /// the mime type.
+    class MimeTypePlan
+    {
+        public:
+        zmm::String contentType;
+        /// \brief ext parameter of the content type, nullptr if it has to
+        /// be taken from the location
+        zmm::String extension;
+        /// \brief the mime type has a transcoding profile list
+        bool transcodable = false;
+        std::vector<ProfilePlan> profiles;
+    };
+
+    /// \brief Render plans and URL templates of one configuration,
+    /// mime type plans are added on first use.
+    class RenderPlans
+    {
+        public:
+        RenderPlans(zmm::Ref<Dictionary> mappings,
+                zmm::Ref<TranscodingProfileList> transcoding,
+                zmm::String virtualURL);
+        std::shared_ptr<const MimeTypePlan> get(zmm::String mimeType);
+
+        zmm::Ref<Dictionary> mappings;
+        zmm::Ref<TranscodingProfileList> transcoding;
+        zmm::String virtualURL;
+        /// \brief URL up to the object ID / after the object ID
+        zmm::String mediaPrefix;
+        zmm::String onlinePrefix;
+        zmm::String resIDSuffix;
+        /// \brief URL up to the location of internal URL items
+        zmm::String servePrefix;
+
+        protected:
+        std::unordered_map<std::string, std::shared_ptr<const MimeTypePlan> > mimeTypes;
+        std::mutex mutex;
+    };
+
+    /// \brief Gets the render plans, replaced when the configuration
+    /// or the virtual URL changed.
+    static std::shared_ptr<RenderPlans> getPlans();
+    static std::shared_ptr<RenderPlans> currentPlans;
+    static std::mutex plansMutex;
+
     /// \brief Gets the baseUrl for a CdsItem.
     /// \param item Item for which the baseUrl should be built.
     ///
     /// This function gets the baseUrl for the CdsItem and sets addResID
     /// to true if the resource id needs to be added to the URL.
     static zmm::Ref<UrlBase> addResources_getUrlBase(zmm::Ref<CdsItem> item,
-            bool forceLocal = false);
+            bool forceLocal = false,
+            std::shared_ptr<RenderPlans> plans = nullptr);
    
     /// \brief renders an ext=.extension string, where the extension is 
     /// determined either from content type or from the filename
@@ -221,6 +221,42 @@
 #define DEFAULT_WEB_DIR                 "web"
 #define DEFAULT_JS_DIR                  "js"
 #define DEFAULT_HIDDEN_FILES_VALUE      NO
+#define DEFAULT_INOTIFY_QUIET_WINDOW    1000 // milliseconds
+#define DEFAULT_METADATA_CACHE_ENABLED  NO
+#define DEFAULT_METADATA_CACHE_DIR      "metadata-cache"
+#define DEFAULT_METADATA_CACHE_MAX_ENTRIES 100000 // 0 is unbounded
+#define DEFAULT_ARTWORK_CACHE_ENABLED   YES
+#define DEFAULT_ARTWORK_CACHE_DIR       "artwork-cache"
+#define DEFAULT_ARTWORK_CACHE_MEMORY_SIZE 16 // megabytes
+#define DEFAULT_ARTWORK_CACHE_DISK_SIZE 256 // megabytes, 0 disables the disk tier
+#define DEFAULT_BROWSE_CACHE_ENABLED    YES
+#define DEFAULT_BROWSE_CACHE_MEMORY_SIZE 4 // megabytes
+#define DEFAULT_BROWSE_CACHE_FRAGMENT_SIZE 16 // megabytes, 0 disables the fragment store
+#define DEFAULT_BROWSE_CACHE_PREFETCH   NO
+#define DEFAULT_BROWSE_CACHE_PREFETCH_BUDGET 2 // pages queued per client
+#define DEFAULT_EVENTING_MIN_INTERVAL   2000 // milliseconds
+#define DEFAULT_EVENTING_MAX_INTERVAL   30000 // milliseconds
+#define DEFAULT_EVENTING_COMPACT_THRESHOLD 500 // containers, 0 never compacts
+#ifdef HAVE_LIBJPEG
+#define DEFAULT_IMAGE_SCALING_ENABLED   YES
+#define DEFAULT_IMAGE_SCALING_CACHE_DIR "rendition-cache"
+#define DEFAULT_IMAGE_SCALING_QUALITY   85
+#endif
+#define DEFAULT_PROBE_WINDOW            65536 // bytes
+#define MIN_PROBE_WINDOW                256 // AVI fourcc is at 0xbc
+#ifdef HAVE_IOURING
+#define DEFAULT_IOURING_QUEUE_DEPTH     64 // 0 disables io_uring
+#endif
+#ifdef HAVE_FFMPEG
+#define DEFAULT_FFMPEG_PROBE_SIZE       1048576 // bytes
+#define MIN_FFMPEG_PROBE_SIZE           32 // libavformat minimum
+#define DEFAULT_FFMPEG_ANALYZE_DURATION 2000 // milliseconds
+#define DEFAULT_FFMPEG_TIMEOUT          15 // seconds, 0 disables the budget
+#define DEFAULT_FFMPEG_QUARANTINE_AFTER 2 // strikes, 0 disables the quarantine
+#define FFMPEG_QUARANTINE_FILE          "ffmpeg-quarantine"
+#define FFMPEG_QUARANTINE_JOURNAL       "ffmpeg-quarantine.journal"
+#define FFMPEG_QUARANTINE_COMPACT       1000 // journal lines
+#endif
 #define DEFAULT_UPNP_STRING_LIMIT       (-1)
 #define DEFAULT_SESSION_TIMEOUT         30
 #define SESSION_TIMEOUT_CHECK_INTERVAL  (5 * 60)
@@ -286,6 +322,7 @@
 
     #define URL_VALUE_TRANSCODE              "1"
 #define DEFAULT_STORAGE_CACHING_ENABLED YES
+#define DEFAULT_STORAGE_UPDATE_ID_FLUSH_INTERVAL 10 // seconds
 #ifdef HAVE_SQLITE3
     #define MT_SQLITE_SYNC_FULL            2
     #define MT_SQLITE_SYNC_NORMAL          1 
@@ -338,6 +375,10 @@
 #define XML_XMLNS_XSI                     "http://www.w3.org/2001/XMLSchema-instance"
 #define XML_XMLNS                         "http://mediatomb.cc/config/"
 
+#ifdef HAVE_EPOLL
+    #define DEFAULT_TRANSCODING_BUFFER_THREADS  1
+#endif
+
 #ifdef HAVE_CURL
     #define DEFAULT_CURL_BUFFER_SIZE        262144
     #define DEFAULT_CURL_INITIAL_FILL_SIZE  0 
@@ -352,6 +393,8 @@
     #define DEFAULT_FFMPEGTHUMBNAILER_IMAGE_QUALITY     8
     #define DEFAULT_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED YES
     #define DEFAULT_FFMPEGTHUMBNAILER_CACHE_DIR         ""
+    #define DEFAULT_FFMPEGTHUMBNAILER_WORKERS           2 // 0 generates inside the request
+    #define DEFAULT_FFMPEGTHUMBNAILER_WORKER_TIMEOUT    60 // seconds
 #endif
 
 #if defined(HAVE_LASTFMLIB)
@@ -279,6 +279,8 @@ Ref<Element> ConfigManager::renderExtendedRuntimeSection()
         _(DEFAULT_FFMPEGTHUMBNAILER_WORKAROUND_BUGS));
     ffth->appendTextChild(_("image-quality"),
         String::from(DEFAULT_FFMPEGTHUMBNAILER_IMAGE_QUALITY));
+    ffth->appendTextChild(_("workers"),
+        String::from(DEFAULT_FFMPEGTHUMBNAILER_WORKERS));
 
     extended->appendElementChild(ffth);
 #endif
@@ -919,6 +921,14 @@ void ConfigManager::validate(String serverhome)
     NEW_BOOL_OPTION(temp == "yes" ? true : false);
     SET_BOOL_OPTION(CFG_SERVER_STORAGE_CACHING_ENABLED);
 
+    temp_int = getIntOption(_("/server/storage/attribute::update-id-flush-interval"),
+        DEFAULT_STORAGE_UPDATE_ID_FLUSH_INTERVAL);
+    if (temp_int < 1)
+        throw _Exception(_("Error in config file: incorrect parameter "
+                           "for <storage update-id-flush-interval=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_STORAGE_UPDATE_ID_FLUSH_INTERVAL);
+
     tmpEl = getElement(_("/server/storage/mysql"));
     if (tmpEl != nullptr) {
         mysql_en = getOption(_("/server/storage/mysql/attribute::enabled"),
@@ -1190,6 +1200,80 @@ void ConfigManager::validate(String serverhome)
     NEW_BOOL_OPTION(temp == "yes" ? true : false);
     SET_BOOL_OPTION(CFG_IMPORT_HIDDEN_FILES);
 
+    temp = getOption(_("/import/metadata-cache/attribute::enabled"),
+        _(DEFAULT_METADATA_CACHE_ENABLED));
+    if (!validateYesNo(temp))
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<metadata-cache enabled=\"\" /> attribute"));
+    NEW_BOOL_OPTION(temp == "yes" ? true : false);
+    SET_BOOL_OPTION(CFG_IMPORT_METADATA_CACHE_ENABLED);
+
+    // empty means <home>/metadata-cache, resolved by the MetadataCache
+    NEW_OPTION(getOption(_("/import/metadata-cache"), _("")));
+    SET_OPTION(CFG_IMPORT_METADATA_CACHE_DIR);
+
+    temp_int = getIntOption(_("/import/metadata-cache/attribute::max-entries"),
+        DEFAULT_METADATA_CACHE_MAX_ENTRIES);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<metadata-cache max-entries=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_METADATA_CACHE_MAX_ENTRIES);
+
+    temp_int = getIntOption(_("/import/attribute::probe-window"),
+        DEFAULT_PROBE_WINDOW);
+    if (temp_int < MIN_PROBE_WINDOW)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<import probe-window=\"\" /> attribute, "
+                           "minimum is ") + MIN_PROBE_WINDOW);
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_PROBE_WINDOW);
+
+#ifdef HAVE_IOURING
+    temp_int = getIntOption(_("/import/attribute::io-uring-queue-depth"),
+        DEFAULT_IOURING_QUEUE_DEPTH);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<import io-uring-queue-depth=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_IOURING_QUEUE_DEPTH);
+#endif
+
+#ifdef HAVE_FFMPEG
+    temp_int = getIntOption(_("/import/ffmpeg/attribute::probe-size"),
+        DEFAULT_FFMPEG_PROBE_SIZE);
+    if (temp_int < MIN_FFMPEG_PROBE_SIZE)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<ffmpeg probe-size=\"\" /> attribute, "
+                           "minimum is ") + MIN_FFMPEG_PROBE_SIZE);
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_FFMPEG_PROBE_SIZE);
+
+    temp_int = getIntOption(_("/import/ffmpeg/attribute::analyze-duration"),
+        DEFAULT_FFMPEG_ANALYZE_DURATION);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<ffmpeg analyze-duration=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_FFMPEG_ANALYZE_DURATION);
+
+    temp_int = getIntOption(_("/import/ffmpeg/attribute::timeout"),
+        DEFAULT_FFMPEG_TIMEOUT);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<ffmpeg timeout=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_FFMPEG_TIMEOUT);
+
+    temp_int = getIntOption(_("/import/ffmpeg/attribute::quarantine-after"),
+        DEFAULT_FFMPEG_QUARANTINE_AFTER);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<ffmpeg quarantine-after=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_FFMPEG_QUARANTINE_AFTER);
+#endif
+
     temp = getOption(
         _("/import/mappings/extension-mimetype/attribute::ignore-unknown"),
         _(DEFAULT_IGNORE_UNKNOWN_EXTENSIONS));
@@ -1347,6 +1431,121 @@ void ConfigManager::validate(String serverhome)
     NEW_BOOL_OPTION(temp == "yes" ? true : false);
     SET_BOOL_OPTION(CFG_SERVER_HIDE_PC_DIRECTORY);
 
+    temp = getOption(_("/server/artwork-cache/attribute::enabled"),
+        _(DEFAULT_ARTWORK_CACHE_ENABLED));
+    if (!validateYesNo(temp))
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<artwork-cache enabled=\"\" /> attribute"));
+    NEW_BOOL_OPTION(temp == "yes" ? true : false);
+    SET_BOOL_OPTION(CFG_SERVER_ARTWORK_CACHE_ENABLED);
+
+    // empty means <home>/artwork-cache, resolved by the ArtworkCache
+    NEW_OPTION(getOption(_("/server/artwork-cache"), _("")));
+    SET_OPTION(CFG_SERVER_ARTWORK_CACHE_DIR);
+
+    temp_int = getIntOption(_("/server/artwork-cache/attribute::memory-size"),
+        DEFAULT_ARTWORK_CACHE_MEMORY_SIZE);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<artwork-cache memory-size=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_ARTWORK_CACHE_MEMORY_SIZE);
+
+    temp_int = getIntOption(_("/server/artwork-cache/attribute::disk-size"),
+        DEFAULT_ARTWORK_CACHE_DISK_SIZE);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<artwork-cache disk-size=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_ARTWORK_CACHE_DISK_SIZE);
+
+    temp = getOption(_("/server/browse-cache/attribute::enabled"),
+        _(DEFAULT_BROWSE_CACHE_ENABLED));
+    if (!validateYesNo(temp))
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<browse-cache enabled=\"\" /> attribute"));
+    NEW_BOOL_OPTION(temp == "yes" ? true : false);
+    SET_BOOL_OPTION(CFG_SERVER_BROWSE_CACHE_ENABLED);
+
+    temp_int = getIntOption(_("/server/browse-cache/attribute::memory-size"),
+        DEFAULT_BROWSE_CACHE_MEMORY_SIZE);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<browse-cache memory-size=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_BROWSE_CACHE_MEMORY_SIZE);
+
+    temp_int = getIntOption(_("/server/browse-cache/attribute::fragment-size"),
+        DEFAULT_BROWSE_CACHE_FRAGMENT_SIZE);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<browse-cache fragment-size=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_BROWSE_CACHE_FRAGMENT_SIZE);
+
+    temp = getOption(_("/server/browse-cache/attribute::prefetch"),
+        _(DEFAULT_BROWSE_CACHE_PREFETCH));
+    if (!validateYesNo(temp))
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<browse-cache prefetch=\"\" /> attribute"));
+    NEW_BOOL_OPTION(temp == "yes" ? true : false);
+    SET_BOOL_OPTION(CFG_SERVER_BROWSE_CACHE_PREFETCH);
+
+    temp_int = getIntOption(_("/server/browse-cache/attribute::prefetch-budget"),
+        DEFAULT_BROWSE_CACHE_PREFETCH_BUDGET);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<browse-cache prefetch-budget=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_BROWSE_CACHE_PREFETCH_BUDGET);
+
+    temp_int = getIntOption(_("/server/eventing/attribute::min-interval"),
+        DEFAULT_EVENTING_MIN_INTERVAL);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<eventing min-interval=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_EVENTING_MIN_INTERVAL);
+
+    temp_int = getIntOption(_("/server/eventing/attribute::max-interval"),
+        DEFAULT_EVENTING_MAX_INTERVAL);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<eventing max-interval=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_EVENTING_MAX_INTERVAL);
+
+    temp_int = getIntOption(_("/server/eventing/attribute::compact-threshold"),
+        DEFAULT_EVENTING_COMPACT_THRESHOLD);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<eventing compact-threshold=\"\" /> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_EVENTING_COMPACT_THRESHOLD);
+
+#ifdef HAVE_LIBJPEG
+    temp = getOption(_("/server/image-scaling/attribute::enabled"),
+        _(DEFAULT_IMAGE_SCALING_ENABLED));
+    if (!validateYesNo(temp))
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<image-scaling enabled=\"\" /> attribute"));
+    NEW_BOOL_OPTION(temp == "yes" ? true : false);
+    SET_BOOL_OPTION(CFG_SERVER_IMAGE_SCALING_ENABLED);
+
+    // empty means <home>/rendition-cache
+    NEW_OPTION(getOption(_("/server/image-scaling"), _("")));
+    SET_OPTION(CFG_SERVER_IMAGE_SCALING_CACHE_DIR);
+
+    temp_int = getIntOption(_("/server/image-scaling/attribute::quality"),
+        DEFAULT_IMAGE_SCALING_QUALITY);
+    if ((temp_int < 1) || (temp_int > 100))
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "<image-scaling quality=\"\" /> attribute, "
+                           "allowed values: 1-100"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_SERVER_IMAGE_SCALING_QUALITY);
+#endif
+
     if (!string_ok(interface)) {
         temp = getOption(_("/server/interface"), _(""));
     } else {
@@ -1572,6 +1771,14 @@ void ConfigManager::validate(String serverhome)
         NEW_BOOL_OPTION(false);
         SET_BOOL_OPTION(CFG_IMPORT_AUTOSCAN_USE_INOTIFY);
     }
+
+    temp_int = getIntOption(_("/import/autoscan/attribute::inotify-quiet-window"),
+        DEFAULT_INOTIFY_QUIET_WINDOW);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter for "
+                           "\"<autoscan inotify-quiet-window=\" attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_IMPORT_AUTOSCAN_INOTIFY_QUIET_WINDOW);
 #endif
 
     temp = getOption(
@@ -1590,6 +1797,17 @@ void ConfigManager::validate(String serverhome)
     NEW_TRANSCODING_PROFILELIST_OPTION(createTranscodingProfileListFromNodeset(el));
     SET_TRANSCODING_PROFILELIST_OPTION(CFG_TRANSCODING_PROFILE_LIST);
 
+#ifdef HAVE_EPOLL
+    temp_int = getIntOption(
+        _("/transcoding/attribute::buffer-threads"),
+        DEFAULT_TRANSCODING_BUFFER_THREADS);
+    if (temp_int < 0)
+        throw _Exception(_("Error in config file: incorrect parameter "
+                           "for <transcoding buffer-threads=\"\"> attribute"));
+    NEW_INT_OPTION(temp_int);
+    SET_INT_OPTION(CFG_TRANSCODING_BUFFER_THREADS);
+#endif
+
 #ifdef HAVE_CURL
     if (temp == "yes") {
         temp_int = getIntOption(
@@ -1748,6 +1966,28 @@ void ConfigManager::validate(String serverhome)
 
         NEW_BOOL_OPTION(temp == YES ? true : false);
         SET_BOOL_OPTION(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED);
+
+        temp_int = getIntOption(_("/server/extended-runtime-options/"
+                                  "ffmpegthumbnailer/workers"),
+            DEFAULT_FFMPEGTHUMBNAILER_WORKERS);
+
+        if (temp_int < 0)
+            throw _Exception(_("Error in config file: ffmpegthumbnailer - "
+                               "invalid value in <workers> tag"));
+
+        NEW_INT_OPTION(temp_int);
+        SET_INT_OPTION(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_WORKERS);
+
+        temp_int = getIntOption(_("/server/extended-runtime-options/"
+                                  "ffmpegthumbnailer/worker-timeout"),
+            DEFAULT_FFMPEGTHUMBNAILER_WORKER_TIMEOUT);
+
+        if (temp_int <= 0)
+            throw _Exception(_("Error in config file: ffmpegthumbnailer - "
+                               "invalid value in <worker-timeout> tag"));
+
+        NEW_INT_OPTION(temp_int);
+        SET_INT_OPTION(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_WORKER_TIMEOUT);
     }
 #endif
 
@@ -2758,7 +2998,22 @@ Ref<AutoscanList> ConfigManager::createAutoscanListFromNodeset(zmm::Ref<mxml::El
         else
             throw _Exception(_("autoscan directory ") + location + ": hidden attribute " + temp + " is invalid");
 
+        bool fanotify = false;
+        temp = child->getAttribute(_("monitor"));
+        if (string_ok(temp) && temp != "inotify") {
+            if (temp != "fanotify")
+                throw _Exception(_("autoscan directory ") + location + ": monitor attribute " + temp + " is invalid");
+            if (mode != ScanMode::INotify)
+                throw _Exception(_("autoscan directory ") + location + ": monitor attribute is only valid in inotify mode");
+#ifdef HAVE_FANOTIFY
+            fanotify = true;
+#else
+            log_warning("autoscan directory %s: this version of Gerbera was compiled without fanotify support, using inotify\n", location.c_str());
+#endif
+        }
+
         Ref<AutoscanDirectory> dir(new AutoscanDirectory(location, mode, level, recursive, true, -1, interval, hidden));
+        dir->setFanotify(fanotify);
         try {
             list->add(dir);
         } catch (const Exception& e) {
@@ -71,6 +71,23 @@ typedef enum
     CFG_SERVER_EXTEND_PROTOCOLINFO_SM_HACK,
 #endif//EXTEND_PROTOCOLINFO
     CFG_SERVER_HIDE_PC_DIRECTORY,
+    CFG_SERVER_ARTWORK_CACHE_ENABLED,
+    CFG_SERVER_ARTWORK_CACHE_DIR,
+    CFG_SERVER_ARTWORK_CACHE_MEMORY_SIZE,
+    CFG_SERVER_ARTWORK_CACHE_DISK_SIZE,
+    CFG_SERVER_BROWSE_CACHE_ENABLED,
+    CFG_SERVER_BROWSE_CACHE_MEMORY_SIZE,
+    CFG_SERVER_BROWSE_CACHE_FRAGMENT_SIZE,
+    CFG_SERVER_BROWSE_CACHE_PREFETCH,
+    CFG_SERVER_BROWSE_CACHE_PREFETCH_BUDGET,
+    CFG_SERVER_EVENTING_MIN_INTERVAL,
+    CFG_SERVER_EVENTING_MAX_INTERVAL,
+    CFG_SERVER_EVENTING_COMPACT_THRESHOLD,
+#ifdef HAVE_LIBJPEG
+    CFG_SERVER_IMAGE_SCALING_ENABLED,
+    CFG_SERVER_IMAGE_SCALING_CACHE_DIR,
+    CFG_SERVER_IMAGE_SCALING_QUALITY,
+#endif
     CFG_SERVER_BOOKMARK_FILE,
     CFG_SERVER_CUSTOM_HTTP_HEADERS,
     CFG_SERVER_UPNP_TITLE_AND_DESC_STRING_LIMIT,
@@ -85,6 +102,7 @@ typedef enum
     CFG_SERVER_UI_SHOW_TOOLTIPS,
     CFG_SERVER_STORAGE_DRIVER,
     CFG_SERVER_STORAGE_CACHING_ENABLED,
+    CFG_SERVER_STORAGE_UPDATE_ID_FLUSH_INTERVAL,
 #ifdef HAVE_SQLITE3
     CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE,
     CFG_SERVER_STORAGE_SQLITE_SYNCHRONOUS,
@@ -109,6 +127,8 @@ typedef enum
     CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_IMAGE_QUALITY,
     CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED,
     CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR,
+    CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_WORKERS,
+    CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_WORKER_TIMEOUT,
 #endif
     CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED,
     CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING_MODE_PREPEND,
@@ -121,6 +141,19 @@ typedef enum
     CFG_SERVER_EXTOPTS_LASTFM_PASSWORD,
 #endif
     CFG_IMPORT_HIDDEN_FILES,
+    CFG_IMPORT_METADATA_CACHE_ENABLED,
+    CFG_IMPORT_METADATA_CACHE_DIR,
+    CFG_IMPORT_METADATA_CACHE_MAX_ENTRIES,
+    CFG_IMPORT_PROBE_WINDOW,
+#ifdef HAVE_IOURING
+    CFG_IMPORT_IOURING_QUEUE_DEPTH,
+#endif
+#ifdef HAVE_FFMPEG
+    CFG_IMPORT_FFMPEG_PROBE_SIZE,
+    CFG_IMPORT_FFMPEG_ANALYZE_DURATION,
+    CFG_IMPORT_FFMPEG_TIMEOUT,
+    CFG_IMPORT_FFMPEG_QUARANTINE_AFTER,
+#endif
     CFG_IMPORT_FILESYSTEM_CHARSET,
     CFG_IMPORT_METADATA_CHARSET,
     CFG_IMPORT_PLAYLIST_CHARSET,
@@ -139,6 +172,7 @@ typedef enum
 #ifdef HAVE_INOTIFY
     CFG_IMPORT_AUTOSCAN_USE_INOTIFY,
     CFG_IMPORT_AUTOSCAN_INOTIFY_LIST,
+    CFG_IMPORT_AUTOSCAN_INOTIFY_QUIET_WINDOW,
 #endif
     CFG_IMPORT_MAPPINGS_IGNORE_UNKNOWN_EXTENSIONS,
     CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_CASE_SENSITIVE,
@@ -155,6 +189,9 @@ typedef enum
     CFG_IMPORT_LIBOPTS_ID3_AUXDATA_TAGS_LIST,
 #endif
     CFG_TRANSCODING_PROFILE_LIST,
+#ifdef HAVE_EPOLL
+    CFG_TRANSCODING_BUFFER_THREADS,
+#endif
 #ifdef HAVE_CURL
     CFG_EXTERNAL_TRANSCODING_CURL_BUFFER_SIZE,
     CFG_EXTERNAL_TRANSCODING_CURL_FILL_SIZE,
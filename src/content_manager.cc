@@ -36,10 +36,12 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "browse_cache.h"
 #include "config_manager.h"
 #include "content_manager.h"
 #include "filesystem.h"
 #include "layout/fallback_layout.h"
+#include "media_probe.h"
 #include "metadata_handler.h"
 #include "rexp.h"
 #include "session_manager.h"
@@ -71,18 +73,19 @@
 #include "task_processor.h"
 #endif
 
-#define DEFAULT_DIR_CACHE_CAPACITY 10
-#define CM_INITIAL_QUEUE_SIZE 20
-
-#ifdef HAVE_MAGIC
-// for older versions of filemagic
-extern "C" {
-#include <magic.h>
-}
+#ifdef HAVE_LIBJPEG
+#include "metadata/image_scale_handler.h"
+#endif
 
-struct magic_set* ms = nullptr;
+#ifdef HAVE_FFMPEG
+#include "metadata/ffmpeg_handler.h"
 #endif
 
+#define DEFAULT_DIR_CACHE_CAPACITY 10
+#define CM_INITIAL_QUEUE_SIZE 20
+/// \brief images scaled per run of the rendition task
+#define CM_RENDITION_BATCH 16
+
 using namespace zmm;
 using namespace mxml;
 using namespace std;
@@ -104,12 +107,14 @@ ContentManager::ContentManager()
 {
     int i;
     ignore_unknown_extensions = false;
-    extension_map_case_sensitive = false;
 
     taskID = 1;
     working = false;
     shutdownFlag = false;
     layout_enabled = false;
+#ifdef HAVE_LIBJPEG
+    renditionTaskQueued = false;
+#endif
 
     acct = Ref<CMAccounting>(new CMAccounting());
     taskQueue1 = Ref<ObjectQueue<GenericTask>>(new ObjectQueue<GenericTask>(CM_INITIAL_QUEUE_SIZE));
@@ -130,11 +135,19 @@ ContentManager::ContentManager()
         ignore_unknown_extensions = false;
     }
 
-    extension_map_case_sensitive = cm->getBoolOption(CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_CASE_SENSITIVE);
 
     mimetype_upnpclass_map = cm->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_UPNP_CLASS_LIST);
 
     mimetype_contenttype_map = cm->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
+
+    mimeTypeMap = std::make_unique<MimeTypeMap>(extension_mimetype_map, mimetype_upnpclass_map,
+        cm->getBoolOption(CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_CASE_SENSITIVE));
+
+#ifdef HAVE_IOURING
+    statBatch = std::make_unique<StatBatch>(cm->getIntOption(CFG_IMPORT_IOURING_QUEUE_DEPTH));
+#else
+    statBatch = std::make_unique<StatBatch>(0);
+#endif
     Ref<AutoscanList> config_timed_list = cm->getAutoscanListOption(CFG_IMPORT_AUTOSCAN_TIMED_LIST);
 
     for (i = 0; i < config_timed_list->size(); i++) {
@@ -168,6 +181,17 @@ ContentManager::ContentManager()
         storage->updateAutoscanPersistentList(ScanMode::INotify,
             config_inotify_list);
         autoscan_inotify = storage->getAutoscanList(ScanMode::INotify);
+
+        // the monitor backend is not stored in the database, take it over
+        // from the configuration
+        for (i = 0; i < config_inotify_list->size(); i++) {
+            Ref<AutoscanDirectory> dir = config_inotify_list->get(i);
+            if (dir == nullptr || !dir->getFanotify())
+                continue;
+            Ref<AutoscanDirectory> adir = autoscan_inotify->get(dir->getLocation());
+            if (adir != nullptr)
+                adir->setFanotify(true);
+        }
     } else {
         // make an empty list so we do not have to do extra checks on shutdown
         autoscan_inotify = Ref<AutoscanList>(new AutoscanList());
@@ -176,24 +200,6 @@ ContentManager::ContentManager()
     // Start INotify thread
     inotify.run();
 #endif
-/* init filemagic */
-#ifdef HAVE_MAGIC
-    if (!ignore_unknown_extensions) {
-        ms = magic_open(MAGIC_MIME);
-        if (ms == nullptr) {
-            log_error("magic_open failed\n");
-        } else {
-            String magicFile = cm->getOption(CFG_IMPORT_MAGIC_FILE);
-            if (!string_ok(magicFile))
-                magicFile = nullptr;
-            if (magic_load(ms, (magicFile == nullptr) ? nullptr : magicFile.c_str()) == -1) {
-                log_warning("magic_load: %s\n", magic_error(ms));
-                magic_close(ms);
-                ms = nullptr;
-            }
-        }
-    }
-#endif // HAVE_MAGIC
 
     String layout_type = cm->getOption(CFG_IMPORT_SCRIPTING_VIRTUAL_LAYOUT_TYPE);
     if ((layout_type == "builtin") || (layout_type == "js"))
@@ -298,6 +304,17 @@ void ContentManager::init()
     reMimetype = Ref<RExp>(new RExp());
     reMimetype->compile(_(MIMETYPE_REGEXP));
 
+/* init filemagic, handles are opened on first use */
+#ifdef HAVE_MAGIC
+    String magicFile = ConfigManager::getInstance()->getOption(CFG_IMPORT_MAGIC_FILE);
+    magicPool = Ref<MagicPool>(new MagicPool(magicFile, reMimetype));
+    // served files always used the system database
+    if (string_ok(magicFile))
+        serveMagicPool = Ref<MagicPool>(new MagicPool(nullptr, reMimetype));
+    else
+        serveMagicPool = magicPool;
+#endif // HAVE_MAGIC
+
     int ret = pthread_create(
         &taskThread,
         nullptr, //&attr, // attr
@@ -382,6 +399,9 @@ void ContentManager::timerNotify(Ref<Timer::Parameter> parameter)
 void ContentManager::shutdown()
 {
     log_debug("start\n");
+#ifdef HAVE_FFMPEG
+    FfmpegHandler::shutdownQuarantine();
+#endif
     std::unique_lock<mutex_type> lock(mutex);
     log_debug("updating last_modified data for autoscan in database...\n");
     autoscan_timed->updateLMinDB();
@@ -422,10 +442,8 @@ void ContentManager::shutdown()
     taskThread = 0;
 
 #ifdef HAVE_MAGIC
-    if (ms) {
-        magic_close(ms);
-        ms = nullptr;
-    }
+    magicPool = nullptr;
+    serveMagicPool = nullptr;
 #endif
     log_debug("end\n");
 }
@@ -510,7 +528,7 @@ void ContentManager::addVirtualItem(Ref<CdsObject> obj, bool allow_fifo)
     addObject(obj);
 }
 
-int ContentManager::_addFile(String path, String rootpath, bool recursive, bool hidden, Ref<GenericTask> task)
+int ContentManager::_addFile(String path, String rootpath, bool recursive, bool hidden, Ref<GenericTask> task, struct stat* statbuf)
 {
     if (hidden == false) {
         String filename = get_filename(path);
@@ -536,7 +554,7 @@ int ContentManager::_addFile(String path, String rootpath, bool recursive, bool
 
     Ref<CdsObject> obj = storage->findObjectByPath(path);
     if (obj == nullptr) {
-        obj = createObjectFromFile(path);
+        obj = createObjectFromFile(path, true, false, statbuf);
         if (obj == nullptr) // object ignored
             return INVALID_OBJECT_ID;
         if (IS_CDS_ITEM(obj->getObjectType())) {
@@ -606,9 +624,6 @@ int ContentManager::ensurePathExistence(zmm::String path)
 void ContentManager::_rescanDirectory(int containerID, int scanID, ScanMode scanMode, ScanLevel scanLevel, Ref<GenericTask> task)
 {
     log_debug("start\n");
-    int ret;
-    struct dirent* dent;
-    struct stat statbuf;
     String location;
     String path;
     Ref<CdsObject> obj;
@@ -701,31 +716,24 @@ void ContentManager::_rescanDirectory(int containerID, int scanID, ScanMode scan
     } else
         thisTaskID = 0;
 
-    while (((dent = readdir(dir)) != nullptr) && (!shutdownFlag) && (task == nullptr || ((task != nullptr) && task->isValid()))) {
-        char* name = dent->d_name;
-        if (name[0] == '.') {
-            if (name[1] == 0) {
-                continue;
-            } else if (name[1] == '.' && name[2] == 0) {
-                continue;
-            } else if (!adir->getHidden()) {
-                continue;
-            }
-        }
+    std::vector<DirEntry> entries = statBatch->scan(dir, adir->getHidden());
+    closedir(dir);
+
+    for (auto& entry : entries) {
+        if (shutdownFlag || (task != nullptr && !task->isValid()))
+            break;
 
-        path = location + DIR_SEPARATOR + name;
-        ret = stat(path.c_str(), &statbuf);
-        if (ret != 0) {
-            log_error("Failed to stat %s, %s\n", path.c_str(), mt_strerror(errno).c_str());
+        path = location + DIR_SEPARATOR + entry.name;
+        if (entry.error != 0) {
+            log_error("Failed to stat %s, %s\n", path.c_str(), mt_strerror(entry.error).c_str());
             continue;
         }
+        struct stat& statbuf = entry.statbuf;
 
         // it is possible that someone hits remove while the container is being scanned
         // in this case we will invalidate the autoscan entry
-        if (adir->getScanID() == INVALID_SCAN_ID) {
-            closedir(dir);
+        if (adir->getScanID() == INVALID_SCAN_ID)
             return;
-        }
 
         if (S_ISREG(statbuf.st_mode)) {
             int objectID = storage->findObjectIDByPath(String(path));
@@ -739,7 +747,7 @@ void ContentManager::_rescanDirectory(int containerID, int scanID, ScanMode scan
                         // readd object - we have to do this in order to trigger
                         // layout
                         removeObject(objectID, false);
-                        addFileInternal(path, location, false, false, adir->getHidden());
+                        _addFile(path, location, false, adir->getHidden(), nullptr, &statbuf);
                         // update time variable
                         last_modified_current_max = statbuf.st_mtime;
                     }
@@ -752,7 +760,7 @@ void ContentManager::_rescanDirectory(int containerID, int scanID, ScanMode scan
                 // add file, not recursive, not async
                 // make sure not to add the current config.xml
                 if (ConfigManager::getInstance()->getConfigFilename() != path) {
-                    addFileInternal(path, location, false, false, adir->getHidden());
+                    _addFile(path, location, false, adir->getHidden(), nullptr, &statbuf);
                     if (last_modified_current_max < statbuf.st_mtime)
                         last_modified_current_max = statbuf.st_mtime;
                 }
@@ -774,18 +782,14 @@ void ContentManager::_rescanDirectory(int containerID, int scanID, ScanMode scan
 
                 // it is possible that someone hits remove while the container is being scanned
                 // in this case we will invalidate the autoscan entry
-                if (adir->getScanID() == INVALID_SCAN_ID) {
-                    closedir(dir);
+                if (adir->getScanID() == INVALID_SCAN_ID)
                     return;
-                }
 
                 // add directory, recursive, async, hidden flag, low priority
                 addFileInternal(path, location, true, true, adir->getHidden(), true, thisTaskID, task->isCancellable());
             }
         }
-    } // while
-
-    closedir(dir);
+    } // for
 
     if ((shutdownFlag) || ((task != nullptr) && !task->isValid()))
         return;
@@ -819,23 +823,19 @@ void ContentManager::addRecursive(String path, bool hidden, Ref<GenericTask> tas
         throw _Exception(_("could not list directory ") + path + " : " + strerror(errno));
     }
     int parentID = storage->findObjectIDByPath(path + DIR_SEPARATOR);
-    struct dirent* dent;
     // abort loop if either:
     // no valid directory returned, server is about to shutdown, the task is there and was invalidated
     if (task != nullptr) {
         log_debug("IS TASK VALID? [%d], taskoath: [%s]\n", task->isValid(), path.c_str());
     }
-    while (((dent = readdir(dir)) != nullptr) && (!shutdownFlag) && (task == nullptr || ((task != nullptr) && task->isValid()))) {
-        char* name = dent->d_name;
-        if (name[0] == '.') {
-            if (name[1] == 0) {
-                continue;
-            } else if (name[1] == '.' && name[2] == 0) {
-                continue;
-            } else if (hidden == false)
-                continue;
-        }
-        String newPath = path + DIR_SEPARATOR + name;
+    std::vector<DirEntry> entries = statBatch->scan(dir, hidden);
+    closedir(dir);
+
+    for (auto& entry : entries) {
+        if (shutdownFlag || (task != nullptr && !task->isValid()))
+            break;
+
+        String newPath = path + DIR_SEPARATOR + entry.name;
 
         if (ConfigManager::getInstance()->getConfigFilename() == newPath)
             continue;
@@ -846,7 +846,9 @@ void ContentManager::addRecursive(String path, bool hidden, Ref<GenericTask> tas
                 obj = storage->findObjectByPath(String(newPath));
             if (obj == nullptr) // create object
             {
-                obj = createObjectFromFile(newPath);
+                if (entry.error != 0)
+                    throw _Exception(_("Failed to stat ") + newPath + _(" , ") + mt_strerror(entry.error));
+                obj = createObjectFromFile(newPath, true, false, &entry.statbuf);
 
                 if (obj == nullptr) // object ignored
                 {
@@ -894,7 +896,6 @@ void ContentManager::addRecursive(String path, bool hidden, Ref<GenericTask> tas
             log_warning("skipping %s : %s\n", newPath.c_str(), e.getMessage().c_str());
         }
     }
-    closedir(dir);
 }
 
 void ContentManager::updateObject(int objectID, Ref<Dictionary> parameters)
@@ -1101,6 +1102,12 @@ void ContentManager::updateObject(Ref<CdsObject> obj, bool send_updates)
         um->containerChanged(obj->getParentID());
         if (IS_CDS_CONTAINER(obj->getObjectType()))
             sm->containerChangedUI(obj->getParentID());
+    } else {
+        // clients are not told, but must not be served the old state
+        Ref<BrowseCache> browseCache = BrowseCache::getInstance();
+        browseCache->invalidate(containerChanged);
+        browseCache->invalidate(obj->getParentID());
+        browseCache->invalidate(obj->getID());
     }
 }
 
@@ -1121,20 +1128,20 @@ Ref<CdsObject> ContentManager::convertObject(Ref<CdsObject> oldObj, int newType)
 }
 
 // returns nullptr if file ignored due to configuration
-Ref<CdsObject> ContentManager::createObjectFromFile(String path, bool magic, bool allow_fifo)
+Ref<CdsObject> ContentManager::createObjectFromFile(String path, bool magic, bool allow_fifo, struct stat* statbuf)
 {
     String filename = get_filename(path);
 
-    struct stat statbuf;
-    int ret;
-
-    ret = stat(path.c_str(), &statbuf);
-    if (ret != 0) {
-        throw _Exception(_("Failed to stat ") + path + _(" , ") + mt_strerror(errno));
+    struct stat st;
+    if (statbuf == nullptr) {
+        if (stat(path.c_str(), &st) != 0) {
+            throw _Exception(_("Failed to stat ") + path + _(" , ") + mt_strerror(errno));
+        }
+        statbuf = &st;
     }
 
     Ref<CdsObject> obj;
-    if (S_ISREG(statbuf.st_mode) || (allow_fifo && S_ISFIFO(statbuf.st_mode))) // item
+    if (S_ISREG(statbuf->st_mode) || (allow_fifo && S_ISFIFO(statbuf->st_mode))) // item
     {
         /* retrieve information about item and decide
            if it should be included */
@@ -1147,24 +1154,39 @@ Ref<CdsObject> ContentManager::createObjectFromFile(String path, bool magic, boo
         if (dotIndex > 0)
             extension = filename.substring(dotIndex + 1);
 
-        if (magic)
-            mimetype = extension2mimetype(extension);
+        const MimeTypeMap::MimeMapping* mapping = nullptr;
+        if (magic) {
+            mapping = mimeTypeMap->extension2mapping(extension);
+            if (mapping != nullptr) {
+                mimetype = mapping->mimetype;
+                upnp_class = mapping->upnpClass;
+            }
+        }
+
+        // shared by the mime detection and the metadata handlers, reads
+        // the file header at most once
+        Ref<MediaProbe> probe(new MediaProbe(path, statbuf));
 
         if (mimetype == nullptr && magic) {
             if (ignore_unknown_extensions)
                 return nullptr; // item should be ignored
 #ifdef HAVE_MAGIC
-            mimetype = get_mime_type(ms, reMimetype, path);
+            if (S_ISREG(statbuf->st_mode)) {
+                // as much as magic_file() would read
+                const char* header = probe->getHeader(magicPool->getBytesMax());
+                mimetype = getMimeTypeFromBuffer(header, probe->getHeaderLength());
+            } else
+                mimetype = getMimeTypeFromFile(path);
 #endif
         }
-        if (mimetype != nullptr) {
-            upnp_class = mimetype2upnpclass(mimetype);
+        if (mapping == nullptr && mimetype != nullptr) {
+            upnp_class = mimeTypeMap->mimetype2upnpclass(mimetype);
         }
 
         if (!string_ok(upnp_class)) {
             String content_type = mimetype_contenttype_map->get(mimetype);
             if (content_type == CONTENT_TYPE_OGG) {
-                if (isTheora(path))
+                if (probe->isTheora())
                     upnp_class = _(UPNP_DEFAULT_CLASS_VIDEO_ITEM);
                 else
                     upnp_class = _(UPNP_DEFAULT_CLASS_MUSIC_TRACK);
@@ -1174,8 +1196,8 @@ Ref<CdsObject> ContentManager::createObjectFromFile(String path, bool magic, boo
         Ref<CdsItem> item(new CdsItem());
         obj = RefCast(item, CdsObject);
         item->setLocation(path);
-        item->setMTime(statbuf.st_mtime);
-        item->setSizeOnDisk(statbuf.st_size);
+        item->setMTime(statbuf->st_mtime);
+        item->setSizeOnDisk(statbuf->st_size);
         if (mimetype != nullptr)
             item->setMimeType(mimetype);
         if (upnp_class != nullptr)
@@ -1183,8 +1205,8 @@ Ref<CdsObject> ContentManager::createObjectFromFile(String path, bool magic, boo
         Ref<StringConverter> f2i = StringConverter::f2i();
         obj->setTitle(f2i->convert(filename));
         if (magic)
-            MetadataHandler::setMetadata(item);
-    } else if (S_ISDIR(statbuf.st_mode)) {
+            MetadataHandler::setMetadata(item, statbuf, probe);
+    } else if (S_ISDIR(statbuf->st_mode)) {
         Ref<CdsContainer> cont(new CdsContainer());
         obj = RefCast(cont, CdsObject);
         /* adding containers is done by Storage now
@@ -1205,31 +1227,6 @@ Ref<CdsObject> ContentManager::createObjectFromFile(String path, bool magic, boo
     return obj;
 }
 
-String ContentManager::extension2mimetype(String extension)
-{
-    if (extension_mimetype_map == nullptr)
-        return nullptr;
-
-    if (!extension_map_case_sensitive)
-        extension = extension.toLower();
-
-    return extension_mimetype_map->get(extension);
-}
-
-String ContentManager::mimetype2upnpclass(String mimeType)
-{
-    if (mimetype_upnpclass_map == nullptr)
-        return nullptr;
-    String upnpClass = mimetype_upnpclass_map->get(mimeType);
-    if (upnpClass != nullptr)
-        return upnpClass;
-    // try to match foo
-    Ref<Array<StringBase>> parts = split_string(mimeType, '/');
-    if (parts->size() != 2)
-        return nullptr;
-    return mimetype_upnpclass_map->get((String)parts->get(0) + "/*");
-}
-
 void ContentManager::initLayout()
 {
 
@@ -1849,7 +1846,14 @@ void ContentManager::setAutoscanDirectory(Ref<AutoscanDirectory> dir)
 #ifdef HAVE_MAGIC
 zmm::String ContentManager::getMimeTypeFromBuffer(const void* buffer, size_t length)
 {
-    return get_mime_type_from_buffer(ms, reMimetype, buffer, length);
+    return magicPool->getMimeTypeFromBuffer(buffer, length);
+}
+
+zmm::String ContentManager::getMimeTypeFromFile(zmm::String path, bool systemDatabase)
+{
+    if (systemDatabase)
+        return serveMagicPool->getMimeType(path);
+    return magicPool->getMimeType(path);
 }
 #endif
 
@@ -2069,6 +2073,62 @@ void CMFetchOnlineContentTask::run()
 }
 #endif //ONLINE_SERVICES
 
+#ifdef HAVE_LIBJPEG
+void ContentManager::queueRenditions(String location)
+{
+    AutoLock lock(mutex);
+    renditionQueue.push_back(std::string(location.c_str()));
+    if (renditionTaskQueued)
+        return;
+
+    Ref<GenericTask> task(new CMRenditionTask());
+    task->setDescription(_("Scaling images"));
+    addTask(task, true);
+    renditionTaskQueued = true;
+}
+
+void ContentManager::_generateRenditions()
+{
+    std::vector<std::string> batch;
+    {
+        AutoLock lock(mutex);
+        while (!renditionQueue.empty() && batch.size() < CM_RENDITION_BATCH) {
+            batch.push_back(renditionQueue.front());
+            renditionQueue.pop_front();
+        }
+    }
+
+    for (auto& location : batch) {
+        if (shutdownFlag)
+            return;
+        ImageScaleHandler::generateRenditions(String(location.c_str()));
+    }
+
+    // requeue behind whatever was added meanwhile
+    AutoLock lock(mutex);
+    if (renditionQueue.empty()) {
+        renditionTaskQueued = false;
+        return;
+    }
+    Ref<GenericTask> task(new CMRenditionTask());
+    task->setDescription(_("Scaling images, ") + (int)renditionQueue.size() + " left");
+    addTask(task, true);
+}
+
+CMRenditionTask::CMRenditionTask()
+    : GenericTask(ContentManagerTask)
+{
+    this->taskType = GenerateRenditions;
+    this->cancellable = false;
+}
+
+void CMRenditionTask::run()
+{
+    Ref<ContentManager> cm = ContentManager::getInstance();
+    cm->_generateRenditions();
+}
+#endif
+
 CMLoadAccountingTask::CMLoadAccountingTask()
     : GenericTask(ContentManagerTask)
 {
@@ -31,7 +31,10 @@
 #ifndef __CONTENT_MANAGER_H__
 #define __CONTENT_MANAGER_H__
 
+#include <deque>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <mutex>
 #include <condition_variable>
@@ -43,6 +46,9 @@
 #include "autoscan.h"
 #include "timer.h"
 #include "generic_task.h"
+#include "stat_batch.h"
+#include "magic_pool.h"
+#include "mime_type_map.h"
 
 #ifdef HAVE_JS
     // this is somewhat not nice, the playlist header needs the cm header and
@@ -105,6 +111,15 @@ public:
     virtual void run() override;
 };
 
+#ifdef HAVE_LIBJPEG
+class CMRenditionTask : public GenericTask
+{
+public:
+    CMRenditionTask();
+    virtual void run() override;
+};
+#endif
+
 class CMRescanDirectoryTask : public GenericTask
 {
 protected: 
@@ -220,9 +235,12 @@ public:
     /// \param parameters key value pairs of fields to be updated
     void updateObject(int objectID, zmm::Ref<Dictionary> parameters);
 
+    /// \param statbuf stat information of path if the caller already has
+    /// it, the file is stat'ed otherwise
     zmm::Ref<CdsObject> createObjectFromFile(zmm::String path, 
                                              bool magic=true, 
-                                             bool allow_fifo=false);
+                                             bool allow_fifo=false,
+                                             struct stat *statbuf=nullptr);
 
 #ifdef ONLINE_SERVICES
     /// \brief Creates a layout based from data that is obtained from an
@@ -339,6 +357,17 @@ public:
 
 #ifdef HAVE_MAGIC
     zmm::String getMimeTypeFromBuffer(const void *buffer, size_t length);
+    /// \param systemDatabase use the default magic database instead of
+    /// the configured magic-file
+    zmm::String getMimeTypeFromFile(zmm::String path, bool systemDatabase = false);
+#endif
+
+#ifdef HAVE_LIBJPEG
+    /// \brief Queues generation of the scaled renditions of an image.
+    ///
+    /// The images are processed by a low priority task in small batches,
+    /// so imports and rescans queued in the meantime are not held up.
+    void queueRenditions(zmm::String location);
 #endif
 
 
@@ -354,13 +383,22 @@ protected:
     zmm::Ref<RExp> reMimetype;
 
     bool ignore_unknown_extensions;
-    bool extension_map_case_sensitive;
 
     zmm::Ref<Dictionary> extension_mimetype_map;
     zmm::Ref<Dictionary> mimetype_upnpclass_map;
     zmm::Ref<Dictionary> mimetype_contenttype_map;
 
+    /// \brief built once from the two mapping dictionaries above
+    std::unique_ptr<MimeTypeMap> mimeTypeMap;
+
+#ifdef HAVE_MAGIC
+    zmm::Ref<MagicPool> magicPool;
+    zmm::Ref<MagicPool> serveMagicPool;
+#endif
+
     zmm::Ref<AutoscanList> autoscan_timed;
+    /// \brief reads and stats directory entries during rescans
+    std::unique_ptr<StatBatch> statBatch;
 #ifdef HAVE_INOTIFY
     AutoscanInotify inotify;
     zmm::Ref<AutoscanList> autoscan_inotify;
@@ -368,6 +406,12 @@ protected:
  
     zmm::Ref<zmm::Array<Executor> > process_list;
 
+#ifdef HAVE_LIBJPEG
+    std::deque<std::string> renditionQueue;
+    bool renditionTaskQueued;
+    void _generateRenditions();
+#endif
+
     void _loadAccounting();
 
     int addFileInternal(zmm::String path, zmm::String rootpath, 
@@ -376,7 +420,7 @@ protected:
                         bool lowPriority=false, 
                         unsigned int parentTaskID = 0,
                         bool cancellable = true);
-    int _addFile(zmm::String path, zmm::String rootpath, bool recursive=false, bool hidden=false, zmm::Ref<GenericTask> task=nullptr);
+    int _addFile(zmm::String path, zmm::String rootpath, bool recursive=false, bool hidden=false, zmm::Ref<GenericTask> task=nullptr, struct stat *statbuf=nullptr);
     //void _addFile2(zmm::String path, bool recursive=0);
     void _removeObject(int objectID, bool all);
     
@@ -385,8 +429,6 @@ protected:
     void addRecursive(zmm::String path, bool hidden, zmm::Ref<GenericTask> task);
     //void addRecursive2(zmm::Ref<DirCache> dirCache, zmm::String filename, bool recursive);
     
-    zmm::String extension2mimetype(zmm::String extension);
-    zmm::String mimetype2upnpclass(zmm::String mimeType);
 
     void invalidateAddTask(zmm::Ref<GenericTask> t, zmm::String path);
     
@@ -447,6 +489,9 @@ protected:
     friend void CMFetchOnlineContentTask::run();
 #endif
     friend void CMLoadAccountingTask::run();
+#ifdef HAVE_LIBJPEG
+    friend void CMRenditionTask::run();
+#endif
 };
 
 #endif // __CONTENT_MANAGER_H__
@@ -0,0 +1,206 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    didl_fragment_store.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file didl_fragment_store.cc
+/// \brief Implementation of the DidlFragmentStore class.
+
+#include "didl_fragment_store.h"
+
+#include "config_manager.h"
+
+/// \brief a single fragment may use at most this fraction of the budget
+#define DIDL_FRAGMENT_ENTRY_FRACTION 16
+/// \brief rough bookkeeping cost of a fragment besides the XML
+#define DIDL_FRAGMENT_ENTRY_OVERHEAD 128
+
+using namespace zmm;
+using namespace std;
+
+DidlFragmentStore::DidlFragmentStore()
+    : Singleton<DidlFragmentStore>()
+    , enabled(false)
+    , memoryLimit(0)
+    , memoryUsed(0)
+    , generation(0)
+    , hits(0)
+    , misses(0)
+{
+}
+
+void DidlFragmentStore::init()
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    memoryLimit = (size_t)cfg->getIntOption(CFG_SERVER_BROWSE_CACHE_FRAGMENT_SIZE) * 1024 * 1024;
+    enabled = cfg->getBoolOption(CFG_SERVER_BROWSE_CACHE_ENABLED) && (memoryLimit > 0);
+}
+
+void DidlFragmentStore::shutdown()
+{
+    if (!enabled)
+        return;
+
+    log_debug("DIDL fragment hits: %ld, misses: %ld\n", getHits(), getMisses());
+    clear();
+}
+
+unsigned long DidlFragmentStore::getGeneration()
+{
+    AutoLock lock(mutex);
+    return generation;
+}
+
+bool DidlFragmentStore::append(Ref<CdsObject> obj, int variant, DidlWriter& writer)
+{
+    if (!enabled)
+        return false;
+
+    AutoLock lock(mutex);
+    auto it = entries.find(obj->getID());
+    if (it != entries.end()) {
+        Entry& entry = it->second;
+        bool valid = (entry.variant == variant);
+        if (valid && IS_CDS_CONTAINER(obj->getObjectType())) {
+            Ref<CdsContainer> cont = RefCast(obj, CdsContainer);
+            valid = (entry.updateID == cont->getUpdateID())
+                && (entry.childCount == cont->getChildCount());
+        }
+        if (valid) {
+            lru.splice(lru.begin(), lru, entry.lru);
+            writer.raw(entry.xml);
+            hits++;
+            return true;
+        }
+        erase(obj->getID());
+    }
+
+    misses++;
+    return false;
+}
+
+void DidlFragmentStore::put(Ref<CdsObject> obj, int variant, unsigned long generation,
+    string fragment)
+{
+    if (!enabled)
+        return;
+
+    int objectID = obj->getID();
+    size_t size = fragment.size() + DIDL_FRAGMENT_ENTRY_OVERHEAD;
+    if (size > memoryLimit / DIDL_FRAGMENT_ENTRY_FRACTION)
+        return;
+
+    vector<int> dependencies;
+    dependencies.push_back(objectID);
+    if (obj->getRefID() > 0)
+        dependencies.push_back(obj->getRefID());
+
+    int updateID = 0;
+    int childCount = 0;
+    if (IS_CDS_CONTAINER(obj->getObjectType())) {
+        Ref<CdsContainer> cont = RefCast(obj, CdsContainer);
+        updateID = cont->getUpdateID();
+        childCount = cont->getChildCount();
+        if (cont->getArtObjectID() != INVALID_OBJECT_ID)
+            dependencies.push_back(cont->getArtObjectID());
+    } else if (obj->getClass() == UPNP_DEFAULT_CLASS_MUSIC_TRACK)
+        // tracks show the folder art of their parent
+        dependencies.push_back(obj->getParentID());
+
+    AutoLock lock(mutex);
+    if (generation != this->generation)
+        return;
+
+    if (entries.find(objectID) != entries.end())
+        erase(objectID);
+
+    while (memoryUsed + size > memoryLimit && !lru.empty())
+        erase(lru.back());
+
+    lru.push_front(objectID);
+
+    Entry& entry = entries[objectID];
+    entry.xml = std::move(fragment);
+    entry.variant = variant;
+    entry.updateID = updateID;
+    entry.childCount = childCount;
+    entry.size = size;
+    entry.dependencies = std::move(dependencies);
+    entry.lru = lru.begin();
+    for (int id : entry.dependencies)
+        dependents[id].insert(objectID);
+
+    memoryUsed += size;
+}
+
+void DidlFragmentStore::invalidate(int objectID)
+{
+    if (!enabled || objectID == INVALID_OBJECT_ID)
+        return;
+
+    AutoLock lock(mutex);
+    generation++;
+
+    auto it = dependents.find(objectID);
+    if (it == dependents.end())
+        return;
+
+    // erase() modifies the set we are iterating over
+    vector<int> ids(it->second.begin(), it->second.end());
+    for (int id : ids)
+        erase(id);
+}
+
+void DidlFragmentStore::clear()
+{
+    AutoLock lock(mutex);
+    generation++;
+    lru.clear();
+    entries.clear();
+    dependents.clear();
+    memoryUsed = 0;
+}
+
+void DidlFragmentStore::erase(int objectID)
+{
+    auto it = entries.find(objectID);
+    if (it == entries.end())
+        return;
+
+    for (int id : it->second.dependencies) {
+        auto dep = dependents.find(id);
+        if (dep == dependents.end())
+            continue;
+        dep->second.erase(objectID);
+        if (dep->second.empty())
+            dependents.erase(dep);
+    }
+
+    memoryUsed -= it->second.size;
+    lru.erase(it->second.lru);
+    entries.erase(it);
+}
@@ -0,0 +1,121 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    didl_fragment_store.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file didl_fragment_store.h
+
+#ifndef __DIDL_FRAGMENT_STORE_H__
+#define __DIDL_FRAGMENT_STORE_H__
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "cds_objects.h"
+#include "common.h"
+#include "didl_writer.h"
+#include "singleton.h"
+
+/// \brief Size bounded LRU of the rendered DIDL-Lite of single objects.
+///
+/// A Browse that misses the BrowseCache mostly renders objects that did
+/// not change since the last time. Their \<item\> and \<container\>
+/// elements are kept here and copied into the response as they are.
+///
+/// Fragments of containers are tagged with the update ID and the child
+/// count they were rendered with. Everything else a fragment depends on
+/// is dropped by the storage through invalidate(): the object itself,
+/// the object it references, the art object of containers and, for
+/// music tracks, the parent whose folder art they show.
+class DidlFragmentStore : public Singleton<DidlFragmentStore>
+{
+public:
+    DidlFragmentStore();
+    virtual void init() override;
+    virtual void shutdown() override;
+    zmm::String getName() override { return _("DIDL Fragment Store"); }
+
+    inline bool isEnabled() { return enabled; }
+
+    /// \brief Has to be taken before the objects are loaded and passed
+    /// to put(), so that fragments of objects which changed meanwhile
+    /// are not stored.
+    unsigned long getGeneration();
+
+    /// \brief Appends the fragment of the object to the writer.
+    /// \param obj the object as loaded for this request
+    /// \param variant rendering options of the caller, fragments that
+    /// were rendered with other options are not used
+    /// \return false if there is no valid fragment
+    bool append(zmm::Ref<CdsObject> obj, int variant, DidlWriter& writer);
+
+    /// \brief Stores the fragment rendered after append() failed.
+    void put(zmm::Ref<CdsObject> obj, int variant, unsigned long generation,
+        std::string fragment);
+
+    /// \brief Drops the fragments that depend on the given object.
+    void invalidate(int objectID);
+
+    /// \brief Drops all fragments.
+    void clear();
+
+    inline long getHits() { return hits; }
+    inline long getMisses() { return misses; }
+
+protected:
+    struct Entry {
+        std::string xml;
+        int variant;
+        int updateID;
+        int childCount;
+        size_t size;
+        std::vector<int> dependencies;
+        std::list<int>::iterator lru;
+    };
+
+    bool enabled;
+    size_t memoryLimit;
+    size_t memoryUsed;
+    unsigned long generation;
+
+    /// \brief most recently used object ID in front
+    std::list<int> lru;
+    std::unordered_map<int, Entry> entries;
+    /// \brief IDs of the fragments depending on an object
+    std::unordered_map<int, std::unordered_set<int>> dependents;
+
+    std::atomic<long> hits;
+    std::atomic<long> misses;
+
+    void erase(int objectID);
+};
+
+#endif // __DIDL_FRAGMENT_STORE_H__
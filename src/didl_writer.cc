@@ -0,0 +1,194 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    didl_writer.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file didl_writer.cc
+
+#include "didl_writer.h"
+
+/// \brief a thread's writer gives back memory kept after a document this large
+#define DIDL_WRITER_MAX_KEEP (4 * 1024 * 1024)
+
+using namespace zmm;
+using namespace mxml;
+
+void DidlElementBuilder::startElement(String name)
+{
+    Ref<Element> el(new Element(name));
+    if (stack.empty())
+        root = el;
+    else
+        stack.back()->appendElementChild(el);
+    stack.push_back(el);
+}
+
+void DidlElementBuilder::attribute(String name, String value)
+{
+    stack.back()->setAttribute(name, value);
+}
+
+void DidlElementBuilder::textElement(String name, String text)
+{
+    stack.back()->appendTextChild(name, text);
+}
+
+void DidlElementBuilder::text(String text)
+{
+    stack.back()->setText(text);
+}
+
+void DidlElementBuilder::endElement()
+{
+    stack.pop_back();
+}
+
+DidlWriter::DidlWriter()
+    : tagOpen(false)
+{
+}
+
+DidlWriter& DidlWriter::getThreadWriter()
+{
+    static thread_local DidlWriter writer;
+    writer.reset();
+    return writer;
+}
+
+void DidlWriter::reset()
+{
+    if (buffer.capacity() > DIDL_WRITER_MAX_KEEP)
+        std::string().swap(buffer);
+    else
+        buffer.clear();
+    open.clear();
+    tagOpen = false;
+}
+
+void DidlWriter::closeTag()
+{
+    if (tagOpen) {
+        buffer += '>';
+        tagOpen = false;
+    }
+}
+
+void DidlWriter::startElement(String name)
+{
+    closeTag();
+    buffer += '<';
+    buffer += name.c_str();
+    open.push_back(name);
+    tagOpen = true;
+}
+
+void DidlWriter::attribute(String name, String value)
+{
+    buffer += ' ';
+    buffer += name.c_str();
+    buffer += "=\"";
+    appendEscaped(value);
+    buffer += '"';
+}
+
+void DidlWriter::textElement(String name, String text)
+{
+    String attr;
+    String val;
+    int i, j;
+
+    // name@attr[val] => <name attr="val">, as in Element::appendTextChild()
+    if (((i = name.index('@')) > 0)
+        && ((j = name.index(i + 1, '[')) > 0)
+        && (name[name.length() - 1] == ']')) {
+        attr = name.substring(i + 1, j - i - 1);
+        val = name.substring(j + 1, name.length() - j - 2);
+        name = name.substring(0, i);
+    }
+
+    closeTag();
+    buffer += '<';
+    buffer += name.c_str();
+    if (attr.length() && val.length())
+        attribute(attr, val);
+    buffer += '>';
+    appendEscaped(text);
+    buffer += "</";
+    buffer += name.c_str();
+    buffer += '>';
+}
+
+void DidlWriter::text(String text)
+{
+    closeTag();
+    appendEscaped(text);
+}
+
+void DidlWriter::endElement()
+{
+    if (tagOpen) {
+        buffer += "/>";
+        tagOpen = false;
+    } else {
+        buffer += "</";
+        buffer += open.back().c_str();
+        buffer += '>';
+    }
+    open.pop_back();
+}
+
+void DidlWriter::appendEscaped(String str)
+{
+    // same output as Node::escape()
+    auto ptr = (const signed char*)str.c_str();
+    while (ptr && *ptr) {
+        switch (*ptr) {
+        case '<':
+            buffer += "&lt;";
+            break;
+        case '>':
+            buffer += "&gt;";
+            break;
+        case '&':
+            buffer += "&amp;";
+            break;
+        case '"':
+            buffer += "&quot;";
+            break;
+        case '\'':
+            buffer += "&apos;";
+            break;
+        default:
+            // handle control codes
+            if (((*ptr >= 0x00) && (*ptr <= 0x1f) && (*ptr != 0x09) && (*ptr != 0x0d) && (*ptr != 0x0a)) || (*ptr == 0x7f))
+                buffer += '.';
+            else
+                buffer += (char)*ptr;
+            break;
+        }
+        ptr++;
+    }
+}
@@ -0,0 +1,128 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    didl_writer.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file didl_writer.h
+/// \brief Definition of the DidlSink, DidlElementBuilder and DidlWriter classes.
+
+#ifndef __DIDL_WRITER_H__
+#define __DIDL_WRITER_H__
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "mxml/mxml.h"
+
+/// \brief Receives DIDL-Lite as a sequence of elements.
+///
+/// Attributes must follow startElement() before any child or text is
+/// added, textElement() understands the name\@attr[val] notation of
+/// mxml::Element::appendTextChild().
+class DidlSink
+{
+public:
+    virtual ~DidlSink() = default;
+
+    virtual void startElement(zmm::String name) = 0;
+    virtual void attribute(zmm::String name, zmm::String value) = 0;
+    virtual void textElement(zmm::String name, zmm::String text) = 0;
+    /// \brief sets the text of the current element, which must not have
+    /// children
+    virtual void text(zmm::String text) = 0;
+    virtual void endElement() = 0;
+};
+
+/// \brief Builds an mxml::Element tree from DIDL-Lite.
+class DidlElementBuilder : public DidlSink
+{
+public:
+    virtual void startElement(zmm::String name) override;
+    virtual void attribute(zmm::String name, zmm::String value) override;
+    virtual void textElement(zmm::String name, zmm::String text) override;
+    virtual void text(zmm::String text) override;
+    virtual void endElement() override;
+
+    /// \brief the first element that was started
+    zmm::Ref<mxml::Element> getRoot() { return root; }
+
+protected:
+    zmm::Ref<mxml::Element> root;
+    std::vector<zmm::Ref<mxml::Element>> stack;
+};
+
+/// \brief Serializes DIDL-Lite straight into a string buffer.
+///
+/// The output is identical to printing the element tree that
+/// DidlElementBuilder creates from the same calls, without allocating
+/// the tree.
+class DidlWriter : public DidlSink
+{
+public:
+    DidlWriter();
+
+    virtual void startElement(zmm::String name) override;
+    virtual void attribute(zmm::String name, zmm::String value) override;
+    virtual void textElement(zmm::String name, zmm::String text) override;
+    virtual void text(zmm::String text) override;
+    virtual void endElement() override;
+
+    /// \brief empties the writer, the buffer is kept for the next document
+    void reset();
+
+    /// \brief position after which the next element starts, for taking
+    /// its serialized form out of str() once it is ended
+    size_t mark()
+    {
+        closeTag();
+        return buffer.size();
+    }
+
+    /// \brief appends an element serialized by mark() and str() before
+    void raw(const std::string& xml)
+    {
+        closeTag();
+        buffer += xml;
+    }
+
+    const std::string& str() { return buffer; }
+    zmm::String toString() { return zmm::String(buffer.data(), buffer.size()); }
+
+    /// \brief writer that is reused by all calls on the current thread
+    static DidlWriter& getThreadWriter();
+
+protected:
+    std::string buffer;
+    std::vector<zmm::String> open;
+    /// \brief true while attributes can be added to the last started element
+    bool tagOpen;
+
+    void closeTag();
+    void appendEscaped(zmm::String str);
+};
+
+#endif // __DIDL_WRITER_H__
@@ -29,8 +29,12 @@
 
 /// \file file_request_handler.cc
 
+#include <mutex>
+#include <pthread.h>
 #include <sys/stat.h>
+#include <unordered_map>
 
+#include "artwork_cache.h"
 #include "file_io_handler.h"
 #include "file_request_handler.h"
 #include "metadata_handler.h"
@@ -45,6 +49,88 @@
 using namespace zmm;
 using namespace mxml;
 
+/// \brief lifetime of a request context in milliseconds, libupnp calls
+/// open() right after get_info() on the same thread
+#define REQUEST_CONTEXT_TTL 5000
+
+/// \brief upper bound of pending contexts, requests that never reach
+/// open() (HEAD, aborted connections) are dropped when it is hit
+#define REQUEST_CONTEXT_MAX 64
+
+/// \brief State resolved by get_info() that open() would otherwise have
+/// to load from the database and the filesystem a second time.
+class RequestContext {
+public:
+    struct timespec created;
+    Ref<CdsItem> item;
+    String path;
+    struct stat statbuf;
+};
+
+/// \brief Hands request contexts from get_info() over to open().
+///
+/// Entries are keyed by URL and calling thread, open() takes its entry
+/// out of the table so every context is used at most once.
+class RequestContextCache {
+public:
+    static RequestContextCache* getInstance()
+    {
+        static RequestContextCache instance;
+        return &instance;
+    }
+
+    void put(const char* url, RequestContext ctx);
+    bool take(const char* url, RequestContext* ctx);
+
+protected:
+    static std::string makeKey(const char* url);
+    void purgeExpired();
+
+    std::mutex mutex;
+    std::unordered_map<std::string, RequestContext> contexts;
+};
+
+std::string RequestContextCache::makeKey(const char* url)
+{
+    return std::to_string((unsigned long)pthread_self()) + " " + url;
+}
+
+void RequestContextCache::purgeExpired()
+{
+    for (auto it = contexts.begin(); it != contexts.end();) {
+        if (getDeltaMillis(&(it->second.created)) > REQUEST_CONTEXT_TTL)
+            it = contexts.erase(it);
+        else
+            ++it;
+    }
+}
+
+void RequestContextCache::put(const char* url, RequestContext ctx)
+{
+    getTimespecNow(&ctx.created);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (contexts.size() >= REQUEST_CONTEXT_MAX)
+        purgeExpired();
+    if (contexts.size() >= REQUEST_CONTEXT_MAX)
+        contexts.clear();
+    contexts[makeKey(url)] = ctx;
+}
+
+bool RequestContextCache::take(const char* url, RequestContext* ctx)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = contexts.find(makeKey(url));
+    if (it == contexts.end())
+        return false;
+
+    bool valid = getDeltaMillis(&(it->second.created)) <= REQUEST_CONTEXT_TTL;
+    if (valid)
+        *ctx = it->second;
+    contexts.erase(it);
+    return valid;
+}
+
 FileRequestHandler::FileRequestHandler()
     : RequestHandler()
 {
@@ -130,6 +216,12 @@ void FileRequestHandler::get_info(IN const char* filename, OUT UpnpFileInfo* inf
                 _("Failed to open ") + path + " - " + strerror(errno));
     }
 
+    RequestContext ctx;
+    ctx.item = item;
+    ctx.path = path;
+    ctx.statbuf = statbuf;
+    RequestContextCache::getInstance()->put(filename, ctx);
+
     if (access(path.c_str(), R_OK) == 0) {
         UpnpFileInfo_set_IsReadable(info, 1);
     } else {
@@ -179,8 +271,8 @@ void FileRequestHandler::get_info(IN const char* filename, OUT UpnpFileInfo* inf
             mimeType = h->getMimeType();
 
         off_t size = UpnpFileInfo_get_FileLength(info);
-        /*        Ref<IOHandler> io_handler = */ h
-            ->serveContent(item, res_id, &(size));
+        /*        Ref<IOHandler> io_handler = */ ArtworkCache::getInstance()
+            ->serveContent(h, item, res_id, res_handler, &(size));
 
     } else
         if (!is_srt && string_ok(tr_profile)) {
@@ -334,7 +426,17 @@ Ref<IOHandler> FileRequestHandler::open(IN const char* filename,
     log_debug("Opening media file with object id %d\n", objectID);
     Ref<Storage> storage = Storage::getInstance();
 
-    Ref<CdsObject> obj = storage->loadObject(objectID);
+    // get_info() usually ran on this thread just before, reuse what it
+    // loaded instead of hitting the database and the filesystem again
+    RequestContext ctx;
+    bool cached = RequestContextCache::getInstance()->take(filename, &ctx)
+        && (ctx.item->getID() == objectID);
+
+    Ref<CdsObject> obj;
+    if (cached)
+        obj = RefCast(ctx.item, CdsObject);
+    else
+        obj = storage->loadObject(objectID);
 
     int objectType = obj->getObjectType();
 
@@ -403,6 +505,8 @@ Ref<IOHandler> FileRequestHandler::open(IN const char* filename,
                 um->containerChanged(clone->getParentID(), FLUSH_ASAP);
             }
             obj = clone;
+            // the action may have moved the item, stat it again
+            cached = false;
         } else {
             log_debug("Item untouched...\n");
         }
@@ -429,7 +533,11 @@ Ref<IOHandler> FileRequestHandler::open(IN const char* filename,
         is_srt = true;
     }
 
-    ret = stat(path.c_str(), &statbuf);
+    if (cached && (path == ctx.path)) {
+        statbuf = ctx.statbuf;
+        ret = 0;
+    } else
+        ret = stat(path.c_str(), &statbuf);
     if (ret != 0) {
         if (is_srt)
             throw SubtitlesNotFoundException(_("Subtitle file ") + path + " is not available.");
@@ -521,7 +629,7 @@ Ref<IOHandler> FileRequestHandler::open(IN const char* filename,
         //Ref<IOHandler> io_handler = h->serveContent(item, res_id, &(info->file_length));
 
         off_t filelength = -1;
-        Ref<IOHandler> io_handler = h->serveContent(item, res_id, &filelength);
+        Ref<IOHandler> io_handler = ArtworkCache::getInstance()->serveContent(h, item, res_id, res_handler, &filelength);
         io_handler->open(mode);
         return io_handler;
 
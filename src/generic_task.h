@@ -13,7 +13,8 @@ enum task_type_t
     RemoveObject,
     LoadAccounting,
     RescanDirectory,
-    FetchOnlineContent
+    FetchOnlineContent,
+    GenerateRenditions
 };
 
 enum task_owner_t
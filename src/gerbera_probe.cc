@@ -0,0 +1,135 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    gerbera_probe.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file gerbera_probe.cc
+/// \brief Helper process that reads the stream information of one file.
+///
+/// The ffmpeg metadata handler starts this program for every file instead
+/// of running libavformat in the server process, a broken file may hang it
+/// in places no interrupt callback reaches or crash it.
+///
+/// Usage: gerbera-probe input probesize analyzeduration
+///
+/// The result is written to stdout, one record per line with tab separated
+/// fields; backslashes, tabs and line breaks in values are escaped:
+///
+///     meta <key> <value>
+///     duration <microseconds>
+///     bitrate <bits per second>
+///     video <codec tag> <width> <height>
+///     audio <sample rate> <channels>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" {
+
+#include <libavformat/avformat.h>
+#include <libavutil/avutil.h>
+#include <libavutil/dict.h>
+
+} // extern "C"
+
+#ifdef HAVE_AVSTREAM_CODECPAR
+#define as_codecpar(s) s->codecpar
+#else
+#define as_codecpar(s) s->codec
+#endif
+
+static void printEscaped(const char* value)
+{
+    for (const char* p = value; *p; p++) {
+        switch (*p) {
+        case '\\':
+            fputs("\\\\", stdout);
+            break;
+        case '\t':
+            fputs("\\t", stdout);
+            break;
+        case '\n':
+            fputs("\\n", stdout);
+            break;
+        default:
+            putchar(*p);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s input probesize analyzeduration\n", argv[0]);
+        return 2;
+    }
+
+    av_log_set_level(AV_LOG_QUIET);
+    av_register_all();
+
+    AVDictionary* options = NULL;
+    av_dict_set(&options, "probesize", argv[2], 0);
+    av_dict_set(&options, "analyzeduration", argv[3], 0);
+
+    AVFormatContext* pFormatCtx = NULL;
+    int ret = avformat_open_input(&pFormatCtx, argv[1], NULL, &options);
+    av_dict_free(&options);
+    if (ret != 0)
+        return 1;
+
+    if (avformat_find_stream_info(pFormatCtx, NULL) < 0) {
+        avformat_close_input(&pFormatCtx);
+        return 1;
+    }
+
+    AVDictionaryEntry* e = NULL;
+    while ((e = av_dict_get(pFormatCtx->metadata, "", e, AV_DICT_IGNORE_SUFFIX))) {
+        fputs("meta\t", stdout);
+        printEscaped(e->key);
+        putchar('\t');
+        printEscaped(e->value);
+        putchar('\n');
+    }
+
+    printf("duration\t%" PRId64 "\n", (int64_t)pFormatCtx->duration);
+    printf("bitrate\t%" PRId64 "\n", (int64_t)pFormatCtx->bit_rate);
+
+    for (unsigned int i = 0; i < pFormatCtx->nb_streams; i++) {
+        AVStream* st = pFormatCtx->streams[i];
+        if (st == NULL)
+            continue;
+        if (as_codecpar(st)->codec_type == AVMEDIA_TYPE_VIDEO)
+            printf("video\t%u\t%d\t%d\n", as_codecpar(st)->codec_tag,
+                as_codecpar(st)->width, as_codecpar(st)->height);
+        else if (as_codecpar(st)->codec_type == AVMEDIA_TYPE_AUDIO)
+            printf("audio\t%d\t%d\n", as_codecpar(st)->sample_rate,
+                as_codecpar(st)->channels);
+    }
+
+    avformat_close_input(&pFormatCtx);
+    return fflush(stdout) == 0 ? 0 : 1;
+}
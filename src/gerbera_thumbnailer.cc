@@ -0,0 +1,71 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    gerbera_thumbnailer.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file gerbera_thumbnailer.cc
+/// \brief Helper process that generates one video thumbnail.
+///
+/// The ThumbnailService starts this program for every job instead of
+/// running ffmpegthumbnailer in the server process: the thumbnailer is
+/// not thread safe and a broken file may hang or crash it.
+///
+/// Usage: gerbera-thumbnailer input output size seek quality filmstrip
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <libffmpegthumbnailer/videothumbnailerc.h>
+
+int main(int argc, char** argv)
+{
+    if (argc != 7) {
+        fprintf(stderr, "Usage: %s input output size seek quality filmstrip\n", argv[0]);
+        return 2;
+    }
+
+#ifdef FFMPEGTHUMBNAILER_OLD_API
+    video_thumbnailer* th = create_thumbnailer();
+#else
+    video_thumbnailer* th = video_thumbnailer_create();
+#endif // old api
+
+    th->thumbnail_size = atoi(argv[3]);
+    th->seek_percentage = atoi(argv[4]);
+    th->thumbnail_image_quality = atoi(argv[5]);
+    th->overlay_film_strip = atoi(argv[6]) ? 1 : 0;
+    th->thumbnail_image_type = Jpeg;
+
+#ifdef FFMPEGTHUMBNAILER_OLD_API
+    int ret = generate_thumbnail_to_file(th, argv[1], argv[2]);
+    destroy_thumbnailer(th);
+#else
+    int ret = video_thumbnailer_generate_thumbnail_to_file(th, argv[1], argv[2]);
+    video_thumbnailer_destroy(th);
+#endif // old api
+
+    return ret == 0 ? 0 : 1;
+}
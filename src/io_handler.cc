@@ -122,3 +122,12 @@ void IOHandler::seek(IN off_t offset, IN int whence)
 void IOHandler::close()
 {
 }
+
+int IOHandler::getPollFd()
+{
+    return -1;
+}
+
+void IOHandler::setShortReads(bool shortReads)
+{
+}
@@ -69,6 +69,15 @@ public:
 
     /// \brief Close/free previously opened/initialized data.
     virtual void close();
+
+    /// \brief Descriptor that becomes readable when read() can return
+    /// data without blocking, -1 if the handler has none.
+    virtual int getPollFd();
+
+    /// \brief Lets read() return as soon as some data is available
+    /// instead of filling the whole buffer, for callers that poll
+    /// getPollFd() and ask again.
+    virtual void setShortReads(bool shortReads);
 };
 
 
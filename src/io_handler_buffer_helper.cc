@@ -29,12 +29,64 @@
 
 /// \file io_handler_buffer_helper.cc
 
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
 #include "io_handler_buffer_helper.h"
 #include "config_manager.h"
 
+/// \brief number of idle buffers kept per buffer size
+#define BUFFER_POOL_SIZE 8
+
 using namespace zmm;
 using namespace std;
 
+/// \brief Keeps the buffers of closed streams for the next stream with
+/// the same buffer size, transcoding profiles use a handful of sizes.
+class BufferPool {
+public:
+    static BufferPool* getInstance()
+    {
+        static BufferPool instance;
+        return &instance;
+    }
+
+    char* acquire(size_t size);
+    void release(char* buffer, size_t size);
+
+protected:
+    std::mutex mutex;
+    std::unordered_map<size_t, std::vector<char*>> idle;
+};
+
+char* BufferPool::acquire(size_t size)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        auto it = idle.find(size);
+        if (it != idle.end() && !it->second.empty()) {
+            char* buffer = it->second.back();
+            it->second.pop_back();
+            return buffer;
+        }
+    }
+    return (char*)MALLOC(size);
+}
+
+void BufferPool::release(char* buffer, size_t size)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        auto& buffers = idle[size];
+        if (buffers.size() < BUFFER_POOL_SIZE) {
+            buffers.push_back(buffer);
+            return;
+        }
+    }
+    FREE(buffer);
+}
+
 IOHandlerBufferHelper::IOHandlerBufferHelper(size_t bufSize, size_t initialFillSize) : IOHandler()
 {
     if (bufSize <=0)
@@ -47,6 +99,7 @@ IOHandlerBufferHelper::IOHandlerBufferHelper(size_t bufSize, size_t initialFillS
     waitForInitialFillSize = (initialFillSize > 0);
     buffer = nullptr;
     isOpen = false;
+    bufferThread = 0;
     threadShutdown = false;
     eof = false;
     readError = false;
@@ -54,6 +107,7 @@ IOHandlerBufferHelper::IOHandlerBufferHelper(size_t bufSize, size_t initialFillS
     empty = true;
     signalAfterEveryRead = false;
     checkSocket = false;
+    checkSocketTimeout = 0;
     
     seekEnabled = false;
     doSeek = false;
@@ -63,7 +117,7 @@ void IOHandlerBufferHelper::open(IN enum UpnpOpenFileMode mode)
 {
     if (isOpen)
         throw _Exception(_("tried to reopen an open IOHandlerBufferHelper"));
-    buffer = (char *)MALLOC(bufSize);
+    buffer = BufferPool::getInstance()->acquire(bufSize);
     if (buffer == nullptr)
         throw _Exception(_("Failed to allocate memory for transcoding buffer!"));
 
@@ -93,6 +147,11 @@ int IOHandlerBufferHelper::read(OUT char *buf, IN size_t length)
             checkSocket = false;
             return CHECK_SOCKET;
         }
+        else if (checkSocketTimeout > 0)
+        {
+            if (cond.wait_for(lock, chrono::seconds(checkSocketTimeout)) == cv_status::timeout)
+                return CHECK_SOCKET;
+        }
         else
             cond.wait(lock);
     }
@@ -124,23 +183,17 @@ int IOHandlerBufferHelper::read(OUT char *buf, IN size_t length)
     
     lock.lock();
     
-    bool signalled = false;
-    // was the buffer full or became it "full" while we read?
-    if (signalAfterEveryRead || a == b)
-    {
-        cond.notify_one();
-        signalled = true;
-    }
+    bool wasFull = (a == b);
     
     a += didRead;
     if (a >= bufSize)
         a -= bufSize;
     if (a == b)
-    {
         empty = true;
-        if (! signalled)
-            cond.notify_one();
-    }
+    
+    // was the buffer full or became it "full" while we read?
+    if (signalAfterEveryRead || wasFull || empty)
+        notifyWriter();
     
     posRead += didRead;
     return didRead;
@@ -172,7 +225,7 @@ void IOHandlerBufferHelper::seek(IN off_t offset, IN int whence)
     seekWhence = whence;
     
     // tell the probably sleeping thread to process our seek
-    cond.notify_one();
+    notifyWriter();
     
     // wait until the seek has been processed
     cond.wait(lock, [&](){
@@ -186,7 +239,7 @@ void IOHandlerBufferHelper::close()
         throw _Exception(_("close called on closed IOHandlerBufferHelper"));
     isOpen = false;
     stopBufferThread();
-    FREE(buffer);
+    BufferPool::getInstance()->release(buffer, bufSize);
     buffer = nullptr;
 }
 
@@ -202,6 +255,11 @@ void IOHandlerBufferHelper::startBufferThread()
     );
 }
 
+void IOHandlerBufferHelper::notifyWriter()
+{
+    cond.notify_one();
+}
+
 void IOHandlerBufferHelper::stopBufferThread()
 {
     unique_lock<std::mutex> lock(mutex);
@@ -72,6 +72,9 @@ protected:
     bool waitForInitialFillSize;
     bool signalAfterEveryRead;
     bool checkSocket;
+    /// \brief seconds read() waits for data before it returns CHECK_SOCKET
+    /// by itself, 0 leaves that to the buffer thread
+    int checkSocketTimeout;
     
     // buffer stuff..
     bool empty;
@@ -86,8 +89,11 @@ protected:
     int seekWhence;
     
     // thread stuff..
-    void startBufferThread();
-    void stopBufferThread();
+    virtual void startBufferThread();
+    virtual void stopBufferThread();
+    /// \brief tells the filling side that there is room in the buffer or
+    /// a seek to process, called with the mutex held
+    virtual void notifyWriter();
     static void *staticThreadProc(void *arg);
     virtual void threadProc() = 0;
     
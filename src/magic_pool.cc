@@ -0,0 +1,133 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    magic_pool.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file magic_pool.cc
+
+#ifdef HAVE_MAGIC
+
+#include "magic_pool.h"
+
+#include "tools.h"
+
+/// \brief bytes libmagic reads from a file, unless it says otherwise
+#define MAGIC_POOL_BYTES_MAX (1024 * 1024)
+
+using namespace zmm;
+
+MagicPool::MagicPool(String magicFile, Ref<RExp> reMimetype)
+{
+    this->magicFile = magicFile;
+    this->reMimetype = reMimetype;
+    failed = false;
+    bytesMax = 0;
+}
+
+MagicPool::~MagicPool()
+{
+    for (auto ms : idle)
+        magic_close(ms);
+}
+
+magic_set* MagicPool::getHandle()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            magic_set* ms = idle.back();
+            idle.pop_back();
+            return ms;
+        }
+        if (failed)
+            return nullptr;
+    }
+
+    // loading the database takes a while, do it outside of the lock
+    magic_set* ms = magic_open(MAGIC_MIME);
+    if (ms == nullptr) {
+        log_error("magic_open failed\n");
+    } else if (magic_load(ms, string_ok(magicFile) ? magicFile.c_str() : nullptr) == -1) {
+        log_warning("magic_load: %s\n", magic_error(ms));
+        magic_close(ms);
+        ms = nullptr;
+    }
+
+    if (ms == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed = true;
+    }
+    return ms;
+}
+
+void MagicPool::putHandle(magic_set* ms)
+{
+    if (ms == nullptr)
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.push_back(ms);
+}
+
+String MagicPool::getMimeType(String path)
+{
+    Handle handle(this);
+    if (handle.get() == nullptr)
+        return nullptr;
+    return get_mime_type(handle.get(), reMimetype, path);
+}
+
+String MagicPool::getMimeTypeFromBuffer(const void* buffer, size_t length)
+{
+    Handle handle(this);
+    if (handle.get() == nullptr)
+        return nullptr;
+    return get_mime_type_from_buffer(handle.get(), reMimetype, buffer, length);
+}
+
+size_t MagicPool::getBytesMax()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (bytesMax > 0)
+            return bytesMax;
+    }
+
+    // the compiled in default of libmagic versions without the parameter
+    size_t value = MAGIC_POOL_BYTES_MAX;
+#ifdef MAGIC_PARAM_BYTES_MAX
+    {
+        Handle handle(this);
+        if (handle.get() != nullptr)
+            magic_getparam(handle.get(), MAGIC_PARAM_BYTES_MAX, &value);
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bytesMax = value;
+    return bytesMax;
+}
+
+#endif // HAVE_MAGIC
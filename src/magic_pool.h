@@ -0,0 +1,107 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    magic_pool.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file magic_pool.h
+/// \brief Definition of the MagicPool class.
+
+#ifdef HAVE_MAGIC
+
+#ifndef __MAGIC_POOL_H__
+#define __MAGIC_POOL_H__
+
+#include <mutex>
+#include <vector>
+
+#include "rexp.h"
+#include "zmm/zmmf.h"
+
+// for older versions of filemagic
+extern "C" {
+#include <magic.h>
+}
+
+/// \brief Hands out libmagic handles to concurrent callers.
+///
+/// A magic_set must not be used by two threads at the same time. Each
+/// lookup borrows an idle handle from the pool, a new one is opened when
+/// all of them are busy, so the pool grows to the number of threads doing
+/// mime detection in parallel.
+class MagicPool : public zmm::Object
+{
+public:
+    /// \param magicFile magic database to load, nullptr for the default
+    /// \param reMimetype expression extracting the mime type from the
+    /// libmagic answer
+    MagicPool(zmm::String magicFile, zmm::Ref<RExp> reMimetype);
+    virtual ~MagicPool();
+
+    /// \brief Returns the mime type of the file or nullptr.
+    zmm::String getMimeType(zmm::String path);
+
+    /// \brief Returns the mime type of the buffer content or nullptr.
+    zmm::String getMimeTypeFromBuffer(const void* buffer, size_t length);
+
+    /// \brief Number of bytes libmagic reads from a file, a buffer of
+    /// that size gives the same answer as getMimeType().
+    size_t getBytesMax();
+
+protected:
+    magic_set* getHandle();
+    void putHandle(magic_set* ms);
+
+    /// \brief Borrows a handle for its lifetime, also if the lookup throws.
+    class Handle
+    {
+    public:
+        explicit Handle(MagicPool* pool)
+            : pool(pool)
+            , ms(pool->getHandle())
+        {
+        }
+        ~Handle() { pool->putHandle(ms); }
+        magic_set* get() { return ms; }
+
+    private:
+        MagicPool* pool;
+        magic_set* ms;
+    };
+
+    zmm::String magicFile;
+    zmm::Ref<RExp> reMimetype;
+
+    std::mutex mutex;
+    std::vector<magic_set*> idle;
+    /// \brief set once opening a handle failed, no further attempts are made
+    bool failed;
+    /// \brief 0 until getBytesMax() asked libmagic
+    size_t bytesMax;
+};
+
+#endif // __MAGIC_POOL_H__
+
+#endif // HAVE_MAGIC
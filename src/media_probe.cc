@@ -0,0 +1,110 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    media_probe.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file media_probe.cc
+
+#include "media_probe.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "config_manager.h"
+#include "tools.h"
+
+using namespace zmm;
+
+MediaProbe::MediaProbe(String path, struct stat* statbuf)
+{
+    this->path = path;
+    fileSize = statbuf->st_size;
+    regular = S_ISREG(statbuf->st_mode);
+    requested = 0;
+}
+
+void MediaProbe::read(size_t window)
+{
+    if (!regular || window <= requested)
+        return;
+    requested = window;
+
+    if (fileSize >= 0 && static_cast<size_t>(fileSize) < window)
+        window = fileSize;
+    size_t total = header.size();
+    if (total >= window)
+        return;
+    header.resize(window);
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw _Exception(_("Error opening ") + path + _(" : ") + mt_strerror(errno));
+
+    // an extension continues where the last read stopped
+    while (total < window) {
+        ssize_t ret = pread(fd, header.data() + total, window - total, total);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            int err = errno;
+            close(fd);
+            throw _Exception(_("Error reading ") + path + _(" : ") + mt_strerror(err));
+        }
+        if (ret == 0)
+            break;
+        total += ret;
+    }
+    close(fd);
+    header.resize(total);
+}
+
+const char* MediaProbe::getHeader(size_t length)
+{
+    if (length == 0)
+        length = ConfigManager::getInstance()->getIntOption(CFG_IMPORT_PROBE_WINDOW);
+    read(length);
+    return header.data();
+}
+
+size_t MediaProbe::getHeaderLength()
+{
+    if (requested == 0)
+        getHeader();
+    return header.size();
+}
+
+bool MediaProbe::isTheora()
+{
+    return ::isTheora(getHeader(), getHeaderLength());
+}
+
+#ifndef HAVE_FFMPEG
+String MediaProbe::getAVIFourCC()
+{
+    return ::getAVIFourCC(getHeader(), getHeaderLength());
+}
+#endif
@@ -0,0 +1,86 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    media_probe.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file media_probe.h
+/// \brief Definition of the MediaProbe class.
+
+#ifndef __MEDIA_PROBE_H__
+#define __MEDIA_PROBE_H__
+
+#include <sys/stat.h>
+#include <vector>
+
+#include "zmm/zmmf.h"
+
+/// \brief Reads the header of a media file once for all detectors.
+///
+/// The mime type detection, the ogg/theora check and the AVI fourcc
+/// fallback all look at the first bytes of a file. Instead of opening the
+/// file for each of them, the probe reads a header window of
+/// CFG_IMPORT_PROBE_WINDOW bytes on first use and hands out the buffer.
+/// Detectors that look further into the file, like libmagic, ask for a
+/// larger header and the buffer is extended.
+/// Libraries that need the whole file (TagLib, exiv2, ffmpeg) still open
+/// it themselves, but only for the content types they handle.
+class MediaProbe : public zmm::Object
+{
+public:
+    /// \param path file to probe
+    /// \param statbuf stat result of the file, only regular files are read
+    MediaProbe(zmm::String path, struct stat* statbuf);
+
+    zmm::String getPath() { return path; }
+
+    /// \brief Returns the first bytes of the file, reading them if needed.
+    /// \param length bytes wanted, 0 for CFG_IMPORT_PROBE_WINDOW
+    const char* getHeader(size_t length = 0);
+
+    /// \brief Number of valid bytes returned by the last getHeader(),
+    /// reads the probe window if nothing was read yet.
+    size_t getHeaderLength();
+
+    /// \brief Determines if the ogg file contains a video (theora) stream.
+    bool isTheora();
+
+#ifndef HAVE_FFMPEG
+    /// \brief Retrieves the fourcc of an AVI file, nullptr if there is none.
+    zmm::String getAVIFourCC();
+#endif
+
+protected:
+    void read(size_t window);
+
+    zmm::String path;
+    off_t fileSize;
+    bool regular;
+    /// \brief largest window read so far
+    size_t requested;
+    std::vector<char> header;
+};
+
+#endif // __MEDIA_PROBE_H__
@@ -45,6 +45,13 @@ const char* names[] = {
     "/poster.jpg"
 };
 
+/// \brief upper bound for cached directories, the cache is simply
+/// flushed when it is reached
+#define FANART_CACHE_MAX_SIZE 4096
+
+std::mutex FanArtHandler::cacheMutex;
+std::unordered_map<String, FanArtHandler::FolderArt> FanArtHandler::cache;
+
 FanArtHandler::FanArtHandler() : MetadataHandler()
 {
 }
@@ -73,23 +80,63 @@ String getFanArtPath(String folder) {
     return found;
 }
 
+String FanArtHandler::resolve(String folder)
+{
+    struct stat statbuf;
+    if (stat(folder.c_str(), &statbuf) != 0) {
+        invalidate(folder);
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(folder);
+        if (it != cache.end()
+            && it->second.mtime.tv_sec == statbuf.st_mtim.tv_sec
+            && it->second.mtime.tv_nsec == statbuf.st_mtim.tv_nsec)
+            return it->second.path;
+    }
+
+    // creating or removing one of the art files changes the directory
+    // mtime, so the result stays valid until then
+    String found = getFanArtPath(folder);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cache.size() >= FANART_CACHE_MAX_SIZE)
+        cache.clear();
+    cache[folder] = FolderArt { statbuf.st_mtim, found };
+    return found;
+}
+
+void FanArtHandler::invalidate(String folder)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.erase(folder);
+}
+
 void FanArtHandler::fillMetadata(Ref<CdsItem> item)
 {
     log_debug("Running fanart handler on %s\n", item->getLocation().c_str());
 
-    String found = getFanArtPath(getFolderName(item));
+    String found = resolve(getFolderName(item));
 
     if (found != nullptr) {
         Ref<CdsResource> resource(new CdsResource(CH_FANART));
         resource->addAttribute(MetadataHandler::getResAttrName(R_PROTOCOLINFO), renderProtocolInfo("jpg"));
         resource->addParameter(_(RESOURCE_CONTENT_TYPE), _(ID3_ALBUM_ART));
+        resource->addOption(_(RESOURCE_OPTION_FANART_PATH), found);
         item->addResource(resource);
     }
 }
 
 Ref<IOHandler> FanArtHandler::serveContent(Ref<CdsItem> item, int resNum, off_t *data_size)
 {
-    String path = getFanArtPath(getFolderName(item));
+    String path;
+    if (resNum >= 0 && resNum < item->getResourceCount())
+        path = item->getResource(resNum)->getOption(_(RESOURCE_OPTION_FANART_PATH));
+    // items imported before the path was recorded
+    if (!string_ok(path))
+        path = resolve(getFolderName(item));
 
     log_debug("FanArt: Opening name: %s\n", path.c_str());
 
@@ -97,4 +144,3 @@ Ref<IOHandler> FanArtHandler::serveContent(Ref<CdsItem> item, int resNum, off_t
     Ref<IOHandler> io_handler(new FileIOHandler(path));
     return io_handler;
 }
-
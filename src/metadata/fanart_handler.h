@@ -33,6 +33,10 @@
 #ifndef __METADATA_FANART_H__
 #define __METADATA_FANART_H__
 
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+
 #include "metadata_handler.h"
 
 /// \brief This class is responsible for populating filesystem based album and fan art
@@ -42,6 +46,24 @@ public:
     FanArtHandler();
     virtual void fillMetadata(zmm::Ref<CdsItem> item);
     virtual zmm::Ref<IOHandler> serveContent(zmm::Ref<CdsItem> item, int resNum, off_t *data_size);
+
+    /// \brief Drops the cached lookup for the given directory.
+    static void invalidate(zmm::String folder);
+
+protected:
+    /// \brief Result of the art lookup in one directory, valid as long as
+    /// the directory mtime does not change.
+    struct FolderArt {
+        struct timespec mtime;
+        zmm::String path;
+    };
+
+    static std::mutex cacheMutex;
+    static std::unordered_map<zmm::String, FolderArt> cache;
+
+    /// \brief Returns the art file of the folder or nullptr, stats the
+    /// candidate names only if the directory changed since the last lookup.
+    static zmm::String resolve(zmm::String folder);
 };
 
 #endif // __METADATA_FANART_H__
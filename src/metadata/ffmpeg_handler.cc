@@ -45,22 +45,39 @@
 // ffmpeg needs the following sources
 // INT64_C is not defined in ffmpeg/avformat.h but is needed
 // macro defines included via autoconfig.h
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <mutex>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdint.h>
 #include <string.h>
+#include <string>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 extern "C" {
 
 #include <libavformat/avformat.h>
 #include <libavutil/avutil.h>
+#include <libavutil/dict.h>
 
 } // extern "C"
 
 #ifdef HAVE_FFMPEGTHUMBNAILER
 #include <libffmpegthumbnailer/videothumbnailerc.h>
 #include "mem_io_handler.h"
+#include "thumbnail_service.h"
 #endif
 
 #include "config_manager.h"
@@ -73,48 +90,76 @@ extern "C" {
 #define as_codecpar(s) s->codec
 #endif
 
+/// \brief milliseconds between checks whether the probe helper is done
+#define FFMPEG_PROBE_POLL_INTERVAL 50
+
+#ifndef PROBE_BINARY
+#define PROBE_BINARY "gerbera-probe"
+#endif
+
+extern char** environ;
+
 using namespace zmm;
 
+/// \brief What fillMetadata() takes from a probe, read either from the
+/// gerbera-probe helper or from libavformat in process.
+struct FfmpegStreamInfo {
+    bool video;
+    unsigned int codecTag;
+    int width;
+    int height;
+    int sampleRate;
+    int channels;
+};
+
+struct FfmpegProbeResult {
+    std::vector<std::pair<std::string, std::string>> metadata;
+    int64_t duration;
+    int64_t bitRate;
+    std::vector<FfmpegStreamInfo> streams;
+};
+
 // Default constructor
 FfmpegHandler::FfmpegHandler()
     : MetadataHandler()
+    , complete(true)
 {
 }
 
-static void addFfmpegMetadataFields(Ref<CdsItem> item, AVFormatContext* pFormatCtx)
+static void addFfmpegMetadataFields(Ref<CdsItem> item, const FfmpegProbeResult& probe)
 {
-    AVDictionaryEntry* e = NULL;
     Ref<StringConverter> sc = StringConverter::m2i();
     metadata_fields_t field;
     String value;
 
-    while ((e = av_dict_get(pFormatCtx->metadata, "", e, AV_DICT_IGNORE_SUFFIX))) {
-        value = e->value;
+    for (auto& entry : probe.metadata) {
+        const char* key = entry.first.c_str();
+        value = entry.second.c_str();
 
-        if (strcmp(e->key, "title") == 0) {
-            log_debug("Identified metadata title: %s\n", e->value);
+        if (strcmp(key, "title") == 0) {
+            log_debug("Identified metadata title: %s\n", value.c_str());
             field = M_TITLE;
-        } else if (strcmp(e->key, "artist") == 0) {
-            log_debug("Identified metadata artist: %s\n", e->value);
+        } else if (strcmp(key, "artist") == 0) {
+            log_debug("Identified metadata artist: %s\n", value.c_str());
             field = M_ARTIST;
-        } else if (strcmp(e->key, "album") == 0) {
-            log_debug("Identified metadata album: %s\n", e->value);
+        } else if (strcmp(key, "album") == 0) {
+            log_debug("Identified metadata album: %s\n", value.c_str());
             field = M_ALBUM;
-        } else if (strcmp(e->key, "date") == 0) {
+        } else if (strcmp(key, "date") == 0) {
             if ((value.length() == 4) && (value.toInt() > 0)) {
                 value = value + _("-01-01");
                 log_debug("Identified metadata date: %s\n", value.c_str());
             }
             /// \toto parse possible ISO8601 timestamp
             field = M_DATE;
-        } else if (strcmp(e->key, "genre") == 0) {
-            log_debug("Identified metadata genre: %s\n", e->value);
+        } else if (strcmp(key, "genre") == 0) {
+            log_debug("Identified metadata genre: %s\n", value.c_str());
             field = M_GENRE;
-        } else if (strcmp(e->key, "comment") == 0) {
-            log_debug("Identified metadata comment: %s\n", e->value);
+        } else if (strcmp(key, "comment") == 0) {
+            log_debug("Identified metadata comment: %s\n", value.c_str());
             field = M_DESCRIPTION;
-        } else if (strcmp(e->key, "track") == 0) {
-            log_debug("Identified metadata track: %d\n", e->value);
+        } else if (strcmp(key, "track") == 0) {
+            log_debug("Identified metadata track: %s\n", value.c_str());
             field = M_TRACKNUMBER;
         } else {
             continue;
@@ -124,8 +169,7 @@ static void addFfmpegMetadataFields(Ref<CdsItem> item, AVFormatContext* pFormatC
     }
 }
 
-// ffmpeg library calls
-static void addFfmpegResourceFields(Ref<CdsItem> item, AVFormatContext* pFormatCtx, int* x, int* y)
+static void addFfmpegResourceFields(Ref<CdsItem> item, const FfmpegProbeResult& probe, int* x, int* y)
 {
     int64_t hours, mins, secs, us;
     int audioch = 0, samplefreq = 0;
@@ -140,8 +184,8 @@ static void addFfmpegResourceFields(Ref<CdsItem> item, AVFormatContext* pFormatC
     *y = 0;
 
     // duration
-    secs = pFormatCtx->duration / AV_TIME_BASE;
-    us = pFormatCtx->duration % AV_TIME_BASE;
+    secs = probe.duration / AV_TIME_BASE;
+    us = probe.duration % AV_TIME_BASE;
     mins = secs / 60;
     secs %= 60;
     hours = mins / 60;
@@ -153,54 +197,53 @@ static void addFfmpegResourceFields(Ref<CdsItem> item, AVFormatContext* pFormatC
     }
 
     // bitrate
-    if (pFormatCtx->bit_rate > 0) {
+    if (probe.bitRate > 0) {
         // ffmpeg's bit_rate is in bits/sec, upnp wants it in bytes/sec
         // See http://www.upnp.org/schemas/av/didl-lite-v3.xsd
-        log_debug("Added overall bitrate: %d kb/s\n", pFormatCtx->bit_rate / 8);
-        item->getResource(0)->addAttribute(MetadataHandler::getResAttrName(R_BITRATE), String::from(pFormatCtx->bit_rate / 8));
+        log_debug("Added overall bitrate: %d kb/s\n", (int)(probe.bitRate / 8));
+        item->getResource(0)->addAttribute(MetadataHandler::getResAttrName(R_BITRATE), String::from(probe.bitRate / 8));
     }
 
     // video resolution, audio sampling rate, nr of audio channels
     audioset = false;
     videoset = false;
-    for (unsigned int i = 0; i < pFormatCtx->nb_streams; i++) {
-        AVStream* st = pFormatCtx->streams[i];
-        if ((st != NULL) && (videoset == false) && (as_codecpar(st)->codec_type == AVMEDIA_TYPE_VIDEO)) {
-            if (as_codecpar(st)->codec_tag > 0) {
+    for (auto& st : probe.streams) {
+        if ((videoset == false) && st.video) {
+            if (st.codecTag > 0) {
                 char fourcc[5];
-                fourcc[0] = as_codecpar(st)->codec_tag;
-                fourcc[1] = as_codecpar(st)->codec_tag >> 8;
-                fourcc[2] = as_codecpar(st)->codec_tag >> 16;
-                fourcc[3] = as_codecpar(st)->codec_tag >> 24;
+                fourcc[0] = st.codecTag;
+                fourcc[1] = st.codecTag >> 8;
+                fourcc[2] = st.codecTag >> 16;
+                fourcc[3] = st.codecTag >> 24;
                 fourcc[4] = '\0';
 
                 log_debug("FourCC: %x = %s\n",
-                    as_codecpar(st)->codec_tag, fourcc);
+                    st.codecTag, fourcc);
                 String fcc = fourcc;
                 if (string_ok(fcc))
                     item->getResource(0)->addOption(_(RESOURCE_OPTION_FOURCC),
                         fcc);
             }
 
-            if ((as_codecpar(st)->width > 0) && (as_codecpar(st)->height > 0)) {
-                resolution = String::from(as_codecpar(st)->width) + "x" + String::from(as_codecpar(st)->height);
+            if ((st.width > 0) && (st.height > 0)) {
+                resolution = String::from(st.width) + "x" + String::from(st.height);
 
                 log_debug("Added resolution: %s pixel\n", resolution.c_str());
                 item->getResource(0)->addAttribute(MetadataHandler::getResAttrName(R_RESOLUTION), resolution);
                 videoset = true;
-                *x = as_codecpar(st)->width;
-                *y = as_codecpar(st)->height;
+                *x = st.width;
+                *y = st.height;
             }
         }
-        if ((st != NULL) && (audioset == false) && (as_codecpar(st)->codec_type == AVMEDIA_TYPE_AUDIO)) {
+        if ((audioset == false) && !st.video) {
             // find the first stream that has a valid sample rate
-            if (as_codecpar(st)->sample_rate > 0) {
-                samplefreq = as_codecpar(st)->sample_rate;
+            if (st.sampleRate > 0) {
+                samplefreq = st.sampleRate;
                 log_debug("Added sample frequency: %d Hz\n", samplefreq);
                 item->getResource(0)->addAttribute(MetadataHandler::getResAttrName(R_SAMPLEFREQUENCY), String::from(samplefreq));
                 audioset = true;
 
-                audioch = as_codecpar(st)->channels;
+                audioch = st.channels;
                 if (audioch > 0) {
                     log_debug("Added number of audio channels: %d\n", audioch);
                     item->getResource(0)->addAttribute(MetadataHandler::getResAttrName(R_NRAUDIOCHANNELS), String::from(audioch));
@@ -211,19 +254,515 @@ static void addFfmpegResourceFields(Ref<CdsItem> item, AVFormatContext* pFormatC
 
 }
 
+// ffmpeg library calls, used when the probe helper is not available
+static void readFfmpegProbeResult(AVFormatContext* pFormatCtx, FfmpegProbeResult& probe)
+{
+    AVDictionaryEntry* e = NULL;
+    while ((e = av_dict_get(pFormatCtx->metadata, "", e, AV_DICT_IGNORE_SUFFIX)))
+        probe.metadata.emplace_back(e->key, e->value);
+
+    probe.duration = pFormatCtx->duration;
+    probe.bitRate = pFormatCtx->bit_rate;
+
+    for (unsigned int i = 0; i < pFormatCtx->nb_streams; i++) {
+        AVStream* st = pFormatCtx->streams[i];
+        if (st == NULL)
+            continue;
+        FfmpegStreamInfo info = {};
+        if (as_codecpar(st)->codec_type == AVMEDIA_TYPE_VIDEO) {
+            info.video = true;
+            info.codecTag = as_codecpar(st)->codec_tag;
+            info.width = as_codecpar(st)->width;
+            info.height = as_codecpar(st)->height;
+        } else if (as_codecpar(st)->codec_type == AVMEDIA_TYPE_AUDIO) {
+            info.sampleRate = as_codecpar(st)->sample_rate;
+            info.channels = as_codecpar(st)->channels;
+        } else
+            continue;
+        probe.streams.push_back(info);
+    }
+}
+
 // Stub for suppressing ffmpeg error messages during matadata extraction
 void FfmpegNoOutputStub(void* ptr, int level, const char* fmt, va_list vl)
 {
     // do nothing
 }
 
-void FfmpegHandler::fillMetadata(Ref<CdsItem> item)
+/// \brief Remembers files that made libavformat hang or crash.
+///
+/// Probes in the gerbera-probe helper get a strike when the helper is
+/// killed for running out of its time budget or dies from a signal.
+/// Probes that run in process, when the helper is not installed, are
+/// recorded in a journal in the server home before they start and removed
+/// when they return. Paths still listed in the journal at the next start
+/// belong to probes that took the server down; they get a strike, as do
+/// probes that ran out of their time budget. Files with enough strikes are
+/// no longer handed to ffmpeg.
+///
+/// Both files are only appended to while running: the journal gets a
+/// "+path" and a "-path" line per probe, the quarantine file a "strikes
+/// path" line per change, where the last line of a path counts. They are
+/// compacted at startup, the journal also every
+/// FFMPEG_QUARANTINE_COMPACT lines.
+class FfmpegQuarantine {
+public:
+    static FfmpegQuarantine* getInstance()
+    {
+        static FfmpegQuarantine instance;
+        return &instance;
+    }
+
+    bool isQuarantined(String location);
+    void begin(String location);
+    void end(String location, bool timedOut);
+
+    /// \brief Counts a hang or crash of the probe helper.
+    void strike(String location, String reason);
+    /// \brief Forgets the strikes of a file that was probed fine.
+    void clear(String location);
+
+    /// \brief Removes the journal on orderly shutdown, probes that are
+    /// still running do not earn a strike.
+    void shutdown();
+
+protected:
+    FfmpegQuarantine();
+    ~FfmpegQuarantine();
+    void writeQuarantine();
+    void writeJournal();
+    void append(FILE* f, const std::string& line);
+    void addStrike(const std::string& key, String reason);
+    void clearStrikes(const std::string& key);
+
+    std::mutex mutex;
+    int maxStrikes;
+    String quarantineFile;
+    String journalFile;
+    FILE* quarantine;
+    FILE* journal;
+    int journalLines;
+    bool closed;
+    std::unordered_map<std::string, int> strikes;
+    std::unordered_set<std::string> inProgress;
+};
+
+// paths may legally end in blanks, only the line break is removed
+static String chompLine(char* line)
 {
-    log_debug("Running ffmpeg handler on %s\n", item->getLocation().c_str());
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\n')
+        line[len - 1] = '\0';
+    return String(line);
+}
 
-    int x = 0;
-    int y = 0;
+/// \brief Replaces a file by the given lines and opens it for appending.
+static FILE* rewriteFile(String file, const std::vector<std::string>& lines)
+{
+    String tmpFile = file + ".tmp";
+    FILE* f = fopen(tmpFile.c_str(), "w");
+    if (f) {
+        for (auto& line : lines)
+            fprintf(f, "%s\n", line.c_str());
+        if (fclose(f) != 0 || rename(tmpFile.c_str(), file.c_str()) != 0)
+            log_warning("could not write %s: %s\n", file.c_str(), strerror(errno));
+    } else
+        log_warning("could not write %s: %s\n", tmpFile.c_str(), strerror(errno));
+
+    f = fopen(file.c_str(), "a");
+    if (!f)
+        log_warning("could not open %s: %s\n", file.c_str(), strerror(errno));
+    return f;
+}
+
+FfmpegQuarantine::FfmpegQuarantine()
+{
+    quarantine = nullptr;
+    journal = nullptr;
+    journalLines = 0;
+    closed = false;
+
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    maxStrikes = cfg->getIntOption(CFG_IMPORT_FFMPEG_QUARANTINE_AFTER);
+    if (maxStrikes == 0)
+        return;
+
+    String home = cfg->getOption(CFG_SERVER_HOME);
+    quarantineFile = home + DIR_SEPARATOR + FFMPEG_QUARANTINE_FILE;
+    journalFile = home + DIR_SEPARATOR + FFMPEG_QUARANTINE_JOURNAL;
+
+    char line[PATH_MAX + 32];
+    FILE* f = fopen(quarantineFile.c_str(), "r");
+    if (f) {
+        while (fgets(line, sizeof(line), f)) {
+            char* sep = strchr(line, ' ');
+            if (!sep)
+                continue;
+            *sep = '\0';
+            String path = chompLine(sep + 1);
+            if (string_ok(path))
+                strikes[std::string(path.c_str())] = atoi(line);
+        }
+        fclose(f);
+    }
+
+    f = fopen(journalFile.c_str(), "r");
+    if (f) {
+        std::unordered_set<std::string> unfinished;
+        while (fgets(line, sizeof(line), f)) {
+            String path = chompLine(line + 1);
+            if (!string_ok(path))
+                continue;
+            if (line[0] == '+')
+                unfinished.insert(std::string(path.c_str()));
+            else if (line[0] == '-')
+                unfinished.erase(std::string(path.c_str()));
+        }
+        fclose(f);
+
+        for (auto& path : unfinished) {
+            int count = ++strikes[path];
+            log_warning("ffmpeg did not return from probing %s before the last shutdown (strike %d of %d)\n",
+                path.c_str(), count, maxStrikes);
+        }
+    }
+
+    writeQuarantine();
+    writeJournal();
+}
+
+FfmpegQuarantine::~FfmpegQuarantine()
+{
+    if (quarantine)
+        fclose(quarantine);
+    if (journal)
+        fclose(journal);
+}
+
+bool FfmpegQuarantine::isQuarantined(String location)
+{
+    if (maxStrikes == 0)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = strikes.find(std::string(location.c_str()));
+    return it != strikes.end() && it->second >= maxStrikes;
+}
 
+void FfmpegQuarantine::append(FILE* f, const std::string& line)
+{
+    if (closed || !f)
+        return;
+    // flushed right away, the line has to survive a crash of the probe;
+    // a crashed process leaves the page cache intact, no fsync required
+    fprintf(f, "%s\n", line.c_str());
+    fflush(f);
+}
+
+void FfmpegQuarantine::begin(String location)
+{
+    // a path with a line break can not be stored in the journal
+    if (maxStrikes == 0 || strchr(location.c_str(), '\n'))
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string key(location.c_str());
+    inProgress.insert(key);
+    append(journal, "+" + key);
+    journalLines++;
+}
+
+void FfmpegQuarantine::end(String location, bool timedOut)
+{
+    if (maxStrikes == 0 || strchr(location.c_str(), '\n'))
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string key(location.c_str());
+    inProgress.erase(key);
+    append(journal, "-" + key);
+    if (++journalLines >= FFMPEG_QUARANTINE_COMPACT && !closed)
+        writeJournal();
+
+    if (timedOut)
+        addStrike(key, _("exceeded its time budget"));
+    else
+        clearStrikes(key);
+}
+
+void FfmpegQuarantine::strike(String location, String reason)
+{
+    if (maxStrikes == 0 || strchr(location.c_str(), '\n'))
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    addStrike(std::string(location.c_str()), reason);
+}
+
+void FfmpegQuarantine::clear(String location)
+{
+    if (maxStrikes == 0 || strchr(location.c_str(), '\n'))
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    clearStrikes(std::string(location.c_str()));
+}
+
+// both called with the mutex held
+void FfmpegQuarantine::addStrike(const std::string& key, String reason)
+{
+    int count = ++strikes[key];
+    log_warning("ffmpeg %s on %s (strike %d of %d)\n",
+        reason.c_str(), key.c_str(), count, maxStrikes);
+    append(quarantine, std::to_string(count) + " " + key);
+}
+
+void FfmpegQuarantine::clearStrikes(const std::string& key)
+{
+    if (strikes.erase(key) > 0)
+        append(quarantine, "0 " + key);
+}
+
+void FfmpegQuarantine::shutdown()
+{
+    if (maxStrikes == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed)
+        return;
+    closed = true;
+    if (journal) {
+        fclose(journal);
+        journal = nullptr;
+    }
+    unlink(journalFile.c_str());
+    if (quarantine) {
+        fclose(quarantine);
+        quarantine = nullptr;
+    }
+}
+
+void FfmpegQuarantine::writeQuarantine()
+{
+    std::vector<std::string> lines;
+    for (auto it = strikes.begin(); it != strikes.end();) {
+        if (it->second <= 0) {
+            it = strikes.erase(it);
+            continue;
+        }
+        lines.push_back(std::to_string(it->second) + " " + it->first);
+        ++it;
+    }
+    if (quarantine)
+        fclose(quarantine);
+    quarantine = rewriteFile(quarantineFile, lines);
+}
+
+void FfmpegQuarantine::writeJournal()
+{
+    std::vector<std::string> lines;
+    for (auto& path : inProgress)
+        lines.push_back("+" + path);
+    if (journal)
+        fclose(journal);
+    journal = rewriteFile(journalFile, lines);
+    journalLines = lines.size();
+}
+
+/// \brief Set on orderly shutdown, running probe helpers are killed.
+static std::atomic<bool> probeShutdown(false);
+
+void FfmpegHandler::shutdownQuarantine()
+{
+    probeShutdown = true;
+    FfmpegQuarantine::getInstance()->shutdown();
+}
+
+/// \brief Time budget of a single probe, checked by libavformat
+/// between blocking operations.
+struct FfmpegDeadline {
+    std::chrono::steady_clock::time_point deadline;
+    bool expired;
+};
+
+static int FfmpegInterruptCallback(void* opaque)
+{
+    FfmpegDeadline* budget = (FfmpegDeadline*)opaque;
+    if (std::chrono::steady_clock::now() < budget->deadline)
+        return 0;
+    budget->expired = true;
+    return 1;
+}
+
+enum ProbeStatus {
+    PROBE_OK,
+    PROBE_FAILED, // libavformat could not read the file
+    PROBE_ABORTED, // killed after its time budget or died from a signal
+    PROBE_STOPPED, // killed on shutdown
+    PROBE_UNAVAILABLE // the helper could not be started
+};
+
+static std::string unescapeProbeField(const std::string& field)
+{
+    std::string out;
+    out.reserve(field.size());
+    for (size_t i = 0; i < field.size(); i++) {
+        if (field[i] != '\\' || i + 1 == field.size()) {
+            out += field[i];
+            continue;
+        }
+        char c = field[++i];
+        out += (c == 'n') ? '\n' : (c == 't') ? '\t' : c;
+    }
+    return out;
+}
+
+/// \brief Parses the output of gerbera-probe, see gerbera_probe.cc.
+static void parseProbeOutput(const std::string& output, FfmpegProbeResult& probe)
+{
+    size_t pos = 0;
+    while (pos < output.size()) {
+        size_t end = output.find('\n', pos);
+        if (end == std::string::npos)
+            end = output.size();
+
+        std::vector<std::string> fields;
+        size_t start = pos;
+        while (true) {
+            size_t tab = output.find('\t', start);
+            if (tab == std::string::npos || tab > end) {
+                fields.push_back(output.substr(start, end - start));
+                break;
+            }
+            fields.push_back(output.substr(start, tab - start));
+            start = tab + 1;
+        }
+        pos = end + 1;
+
+        const std::string& type = fields[0];
+        if (type == "meta" && fields.size() == 3) {
+            probe.metadata.emplace_back(unescapeProbeField(fields[1]), unescapeProbeField(fields[2]));
+        } else if (type == "duration" && fields.size() == 2) {
+            probe.duration = strtoll(fields[1].c_str(), nullptr, 10);
+        } else if (type == "bitrate" && fields.size() == 2) {
+            probe.bitRate = strtoll(fields[1].c_str(), nullptr, 10);
+        } else if (type == "video" && fields.size() == 4) {
+            FfmpegStreamInfo info = {};
+            info.video = true;
+            info.codecTag = strtoul(fields[1].c_str(), nullptr, 10);
+            info.width = atoi(fields[2].c_str());
+            info.height = atoi(fields[3].c_str());
+            probe.streams.push_back(info);
+        } else if (type == "audio" && fields.size() == 3) {
+            FfmpegStreamInfo info = {};
+            info.sampleRate = atoi(fields[1].c_str());
+            info.channels = atoi(fields[2].c_str());
+            probe.streams.push_back(info);
+        }
+    }
+}
+
+/// \brief Runs gerbera-probe on a file and collects its output.
+/// \param timeout seconds the helper may run, 0 for no limit
+static ProbeStatus runProbeHelper(String helper, String location, int timeout, FfmpegProbeResult& probe)
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    String probeSize = String::from(cfg->getIntOption(CFG_IMPORT_FFMPEG_PROBE_SIZE));
+    // analyzeduration is in microseconds
+    String analyzeDuration = String::from(cfg->getIntOption(CFG_IMPORT_FFMPEG_ANALYZE_DURATION)) + "000";
+
+    const char* argv[] = {
+        helper.c_str(), location.c_str(), probeSize.c_str(),
+        analyzeDuration.c_str(), nullptr
+    };
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        log_error("Could not create a pipe for %s: %s\n", helper.c_str(), strerror(errno));
+        return PROBE_UNAVAILABLE;
+    }
+
+    // the server threads block their signals, the helper gets an empty mask
+    posix_spawnattr_t attr;
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+    pid_t pid;
+    int err = posix_spawn(&pid, helper.c_str(), &actions, &attr,
+        const_cast<char* const*>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+    if (err != 0) {
+        close(fds[0]);
+        log_error("Could not start %s: %s\n", helper.c_str(), strerror(err));
+        return PROBE_UNAVAILABLE;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+    std::string output;
+    bool eof = false;
+    int status = 0;
+    while (true) {
+        if (eof) {
+            pid_t ret = waitpid(pid, &status, WNOHANG);
+            if (ret == pid)
+                break;
+            if (ret < 0 && errno != EINTR) {
+                log_error("Lost probe helper %d: %s\n", pid, strerror(errno));
+                close(fds[0]);
+                return PROBE_FAILED;
+            }
+        }
+
+        if (probeShutdown || (timeout > 0 && std::chrono::steady_clock::now() > deadline)) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            close(fds[0]);
+            return probeShutdown ? PROBE_STOPPED : PROBE_ABORTED;
+        }
+
+        if (eof) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(FFMPEG_PROBE_POLL_INTERVAL));
+            continue;
+        }
+
+        struct pollfd pfd = { fds[0], POLLIN, 0 };
+        if (poll(&pfd, 1, FFMPEG_PROBE_POLL_INTERVAL) <= 0)
+            continue;
+        char buf[4096];
+        ssize_t len = read(fds[0], buf, sizeof(buf));
+        if (len > 0)
+            output.append(buf, len);
+        else if (len == 0 || errno != EINTR)
+            eof = true;
+    }
+    close(fds[0]);
+
+    if (WIFSIGNALED(status)) {
+        log_warning("Probe helper for %s died with signal %d\n",
+            location.c_str(), WTERMSIG(status));
+        return PROBE_ABORTED;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return PROBE_FAILED;
+
+    parseProbeOutput(output, probe);
+    return PROBE_OK;
+}
+
+/// \brief Probes in process, only used when gerbera-probe is missing.
+/// \return false if the file could not be read
+static bool probeInProcess(String location, FfmpegProbeResult& probe, bool* timedOut)
+{
     AVFormatContext* pFormatCtx = NULL;
 
     // Suppress all log messages
@@ -232,99 +771,118 @@ void FfmpegHandler::fillMetadata(Ref<CdsItem> item)
     // Register all formats and codecs
     av_register_all();
 
-    // Open video file
-    if (avformat_open_input(&pFormatCtx,
-            item->getLocation().c_str(), NULL, NULL)
-        != 0)
-        return; // Couldn't open file
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    FfmpegQuarantine* quarantine = FfmpegQuarantine::getInstance();
+
+    pFormatCtx = avformat_alloc_context();
+    if (!pFormatCtx)
+        return false;
+
+    FfmpegDeadline budget;
+    budget.expired = false;
+    int timeout = cfg->getIntOption(CFG_IMPORT_FFMPEG_TIMEOUT);
+    if (timeout > 0) {
+        budget.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+        pFormatCtx->interrupt_callback.callback = FfmpegInterruptCallback;
+        pFormatCtx->interrupt_callback.opaque = &budget;
+    }
+
+    // Bound how much of the file is read and decoded to find the streams,
+    // analyzeduration is in microseconds
+    AVDictionary* options = NULL;
+    av_dict_set_int(&options, "probesize",
+        cfg->getIntOption(CFG_IMPORT_FFMPEG_PROBE_SIZE), 0);
+    av_dict_set_int(&options, "analyzeduration",
+        (int64_t)cfg->getIntOption(CFG_IMPORT_FFMPEG_ANALYZE_DURATION) * 1000, 0);
+
+    quarantine->begin(location);
+
+    // Open video file, frees the context on failure
+    int ret = avformat_open_input(&pFormatCtx, location.c_str(), NULL, &options);
+    av_dict_free(&options);
+    if (ret != 0) {
+        quarantine->end(location, budget.expired);
+        *timedOut = budget.expired;
+        return false; // Couldn't open file
+    }
 
     // Retrieve stream information
     if (avformat_find_stream_info(pFormatCtx, NULL) < 0) {
         avformat_close_input(&pFormatCtx);
-        return; // Couldn't find stream information
+        quarantine->end(location, budget.expired);
+        *timedOut = budget.expired;
+        return false; // Couldn't find stream information
     }
-    // Add metadata using ffmpeg library calls
-    addFfmpegMetadataFields(item, pFormatCtx);
-    // Add resources using ffmpeg library calls
-    addFfmpegResourceFields(item, pFormatCtx, &x, &y);
+    quarantine->end(location, budget.expired);
+    *timedOut = budget.expired;
+
+    readFfmpegProbeResult(pFormatCtx, probe);
 
     // Close the video file
     avformat_close_input(&pFormatCtx);
+    return true;
 }
 
-#ifdef HAVE_FFMPEGTHUMBNAILER
-
-// The ffmpegthumbnailer code (ffmpeg?) is not threading safe.
-// Add a lock around the usage to avoid crashing randomly.
-static pthread_mutex_t thumb_lock;
-
-static int _mkdir(const char* path)
+static std::string findProbeHelper()
 {
-    int ret = mkdir(path, 0777);
-
-    if (ret == 0) {
-        // Make sure we are +x in case of restrictive umask that strips +x.
-        struct stat st;
-        if (stat(path, &st)) {
-            log_warning("could not stat(%s): %s\n", path, strerror(errno));
-            return -1;
-        }
-        mode_t xbits = S_IXUSR | S_IXGRP | S_IXOTH;
-        if (!(st.st_mode & xbits)) {
-            if (chmod(path, st.st_mode | xbits)) {
-                log_warning("could not chmod(%s, +x): %s\n", path, strerror(errno));
-                return -1;
-            }
-        }
+    String helper = find_helper(_(PROBE_BINARY), _("gerbera-probe"));
+    if (!string_ok(helper)) {
+        log_warning("%s not found, ffmpeg probes files in the server process\n", PROBE_BINARY);
+        return std::string();
     }
-
-    return ret;
+    return std::string(helper.c_str());
 }
 
-static bool makeThumbnailCacheDir(String& path)
+void FfmpegHandler::fillMetadata(Ref<CdsItem> item)
 {
-    char* path_temp = strdup(path.c_str());
-    char* last_slash = strrchr(path_temp, '/');
-    char* slash = last_slash;
-    bool ret = false;
+    log_debug("Running ffmpeg handler on %s\n", item->getLocation().c_str());
+
+    int x = 0;
+    int y = 0;
 
-    if (!last_slash)
-        return ret;
+    FfmpegQuarantine* quarantine = FfmpegQuarantine::getInstance();
+    String location = item->getLocation();
+    if (quarantine->isQuarantined(location)) {
+        log_debug("Skipping quarantined file %s\n", location.c_str());
+        complete = false;
+        return;
+    }
 
-    // Assume most dirs exist, so scan backwards first.
-    // Avoid stat/access checks due to TOCTOU races.
-    errno = 0;
-    for (slash = last_slash; slash > path_temp; --slash) {
-        if (*slash != '/')
-            continue;
-        *slash = '\0';
-        if (_mkdir(path_temp) == 0) {
-            // Now we can forward scan.
-            while (slash < last_slash) {
-                *slash = DIR_SEPARATOR;
-                if (_mkdir(path_temp) < 0)
-                    // Allow EEXIST in case of someone else doing `mkdir`.
-                    if (errno != EEXIST)
-                        goto done;
-                slash += strlen(slash);
-            }
-            if (slash == last_slash)
-                ret = true;
-            break;
-        } else if (errno == EEXIST) {
-            ret = true;
-            break;
-        } else if (errno != ENOENT) {
-            break;
-        }
+    FfmpegProbeResult probe = {};
+    ProbeStatus status = PROBE_UNAVAILABLE;
+
+    // a hang or crash of libavformat only takes the helper down
+    static const std::string helper = findProbeHelper();
+    if (!helper.empty()) {
+        int timeout = ConfigManager::getInstance()->getIntOption(CFG_IMPORT_FFMPEG_TIMEOUT);
+        status = runProbeHelper(_(helper.c_str()), location, timeout, probe);
+        if (status == PROBE_ABORTED)
+            quarantine->strike(location, _("did not finish probing"));
+        else if (status != PROBE_STOPPED && status != PROBE_UNAVAILABLE)
+            quarantine->clear(location);
     }
 
-done:
-    free(path_temp);
-    return ret;
+    bool timedOut = false;
+    if (status == PROBE_UNAVAILABLE)
+        status = probeInProcess(location, probe, &timedOut) ? PROBE_OK : PROBE_FAILED;
+
+    complete = !timedOut && status != PROBE_ABORTED && status != PROBE_STOPPED;
+    if (status != PROBE_OK)
+        return;
+
+    // Add metadata using ffmpeg library calls
+    addFfmpegMetadataFields(item, probe);
+    // Add resources using ffmpeg library calls
+    addFfmpegResourceFields(item, probe, &x, &y);
 }
 
-static String getThumbnailCacheFilePath(String& movie_filename, bool create)
+#ifdef HAVE_FFMPEGTHUMBNAILER
+
+// The ffmpegthumbnailer code (ffmpeg?) is not threading safe.
+// Add a lock around the usage to avoid crashing randomly.
+static pthread_mutex_t thumb_lock;
+
+String FfmpegHandler::getThumbnailCachePath(String location, bool create)
 {
     Ref<ConfigManager> cfg = ConfigManager::getInstance();
     String cache_dir = cfg->getOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR);
@@ -334,15 +892,15 @@ static String getThumbnailCacheFilePath(String& movie_filename, bool create)
         cache_dir = home_dir + "/cache-dir";
     }
 
-    cache_dir = cache_dir + movie_filename + "-thumb.jpg";
-    if (create && !makeThumbnailCacheDir(cache_dir))
+    cache_dir = cache_dir + location + "-thumb.jpg";
+    if (create && !make_parent_dirs(cache_dir))
         cache_dir = "";
     return cache_dir;
 }
 
 static bool readThumbnailCacheFile(String movie_filename, uint8_t** ptr_img, size_t* size_img)
 {
-    String path = getThumbnailCacheFilePath(movie_filename, false);
+    String path = FfmpegHandler::getThumbnailCachePath(movie_filename, false);
     FILE* fp = fopen(path.c_str(), "rb");
     if (!fp)
         return false;
@@ -360,42 +918,31 @@ static bool readThumbnailCacheFile(String movie_filename, uint8_t** ptr_img, siz
     return true;
 }
 
-static void writeThumbnailCacheFile(String movie_filename, uint8_t* ptr_img, int size_img)
+static bool writeThumbnailCacheFile(String movie_filename, uint8_t* ptr_img, int size_img)
 {
-    String path = getThumbnailCacheFilePath(movie_filename, true);
-    FILE* fp = fopen(path.c_str(), "wb");
+    String path = FfmpegHandler::getThumbnailCachePath(movie_filename, true);
+    if (!string_ok(path))
+        return false;
+
+    // readers must never see a partially written thumbnail
+    String part = path + ".part";
+    FILE* fp = fopen(part.c_str(), "wb");
     if (!fp)
-        return;
-    fwrite(ptr_img, sizeof(uint8_t), size_img, fp);
-    fclose(fp);
+        return false;
+    bool ok = fwrite(ptr_img, sizeof(uint8_t), size_img, fp) == (size_t)size_img;
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || rename(part.c_str(), path.c_str()) != 0) {
+        unlink(part.c_str());
+        return false;
+    }
+    return true;
 }
 
-#endif
-
-Ref<IOHandler> FfmpegHandler::serveContent(Ref<CdsItem> item, int resNum, off_t* data_size)
+// Runs ffmpegthumbnailer, the returned buffer is malloc'ed
+static bool generateThumbnail(String location, uint8_t** ptr_img, size_t* size_img)
 {
-    *data_size = -1;
-#ifdef HAVE_FFMPEGTHUMBNAILER
     Ref<ConfigManager> cfg = ConfigManager::getInstance();
 
-    if (!cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED))
-        return nullptr;
-
-    if (cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED)) {
-        uint8_t* ptr_image;
-        size_t size_image;
-        if (readThumbnailCacheFile(item->getLocation(),
-                &ptr_image, &size_image)) {
-            *data_size = (off_t)size_image;
-            Ref<IOHandler> h(new MemIOHandler(ptr_image, size_image));
-            free(ptr_image);
-            log_debug("Returning cached thumbnail for file: %s\n", item->getLocation().c_str());
-            return h;
-        }
-    }
-
-    pthread_mutex_lock(&thumb_lock);
-
 #ifdef FFMPEGTHUMBNAILER_OLD_API
     video_thumbnailer* th = create_thumbnailer();
     image_data* img = create_image_data();
@@ -415,27 +962,25 @@ Ref<IOHandler> FfmpegHandler::serveContent(Ref<CdsItem> item, int resNum, off_t*
     th->thumbnail_image_quality = cfg->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_IMAGE_QUALITY);
     th->thumbnail_image_type = Jpeg;
 
-    log_debug("Generating thumbnail for file: %s\n", item->getLocation().c_str());
-
 #ifdef FFMPEGTHUMBNAILER_OLD_API
-    if (generate_thumbnail_to_buffer(th, item->getLocation().c_str(), img) != 0)
+    bool ok = generate_thumbnail_to_buffer(th, location.c_str(), img) == 0;
 #else
-    if (video_thumbnailer_generate_thumbnail_to_buffer(th,
-            item->getLocation().c_str(), img)
-        != 0)
+    bool ok = video_thumbnailer_generate_thumbnail_to_buffer(th,
+                  location.c_str(), img)
+        == 0;
 #endif // old api
-    {
-        pthread_mutex_unlock(&thumb_lock);
-        throw _Exception(_("Could not generate thumbnail for ") + item->getLocation());
-    }
-    if (cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED)) {
-        writeThumbnailCacheFile(item->getLocation(),
-            img->image_data_ptr, img->image_data_size);
+
+    *ptr_img = NULL;
+    *size_img = 0;
+    if (ok) {
+        *ptr_img = (uint8_t*)malloc(img->image_data_size);
+        ok = (*ptr_img != NULL);
+        if (ok) {
+            memcpy(*ptr_img, img->image_data_ptr, img->image_data_size);
+            *size_img = img->image_data_size;
+        }
     }
 
-    *data_size = (off_t)img->image_data_size;
-    Ref<IOHandler> h(new MemIOHandler((void*)img->image_data_ptr,
-        img->image_data_size));
 #ifdef FFMPEGTHUMBNAILER_OLD_API
     destroy_image_data(img);
     destroy_thumbnailer(th);
@@ -443,7 +988,57 @@ Ref<IOHandler> FfmpegHandler::serveContent(Ref<CdsItem> item, int resNum, off_t*
     video_thumbnailer_destroy_image_data(img);
     video_thumbnailer_destroy(th);
 #endif // old api
-    pthread_mutex_unlock(&thumb_lock);
+    return ok;
+}
+
+#endif
+
+Ref<IOHandler> FfmpegHandler::serveContent(Ref<CdsItem> item, int resNum, off_t* data_size)
+{
+    *data_size = -1;
+#ifdef HAVE_FFMPEGTHUMBNAILER
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+
+    if (!cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED))
+        return nullptr;
+
+    String location = item->getLocation();
+    uint8_t* ptr_image;
+    size_t size_image;
+    bool useCache = cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED);
+    bool found = useCache && readThumbnailCacheFile(location, &ptr_image, &size_image);
+
+    if (!found) {
+        Ref<ThumbnailService> service = ThumbnailService::getInstance();
+        if (service->isEnabled()) {
+            // the request only waits for the workers, it never runs
+            // the thumbnailer itself
+            log_debug("Waiting for thumbnail of file: %s\n", location.c_str());
+            if (service->waitFor(location))
+                found = readThumbnailCacheFile(location, &ptr_image, &size_image);
+            if (!found)
+                throw _Exception(_("Could not generate thumbnail for ") + location);
+        }
+    }
+
+    if (!found) {
+        log_debug("Generating thumbnail for file: %s\n", location.c_str());
+
+        pthread_mutex_lock(&thumb_lock);
+        bool ok = generateThumbnail(location, &ptr_image, &size_image);
+        pthread_mutex_unlock(&thumb_lock);
+        if (!ok)
+            throw _Exception(_("Could not generate thumbnail for ") + location);
+
+        if (useCache)
+            writeThumbnailCacheFile(location, ptr_image, size_image);
+    } else {
+        log_debug("Returning cached thumbnail for file: %s\n", location.c_str());
+    }
+
+    *data_size = (off_t)size_image;
+    Ref<IOHandler> h(new MemIOHandler(ptr_image, size_image));
+    free(ptr_image);
     return h;
 #else
     return nullptr;
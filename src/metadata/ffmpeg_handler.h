@@ -48,6 +48,24 @@ public:
     virtual void fillMetadata(zmm::Ref<CdsItem> item);
     virtual zmm::Ref<IOHandler> serveContent(zmm::Ref<CdsItem> item, int resNum, off_t *data_size);
     virtual zmm::String getMimeType();
+
+    /// \brief false if the last fillMetadata() skipped a quarantined file
+    /// or ran out of its time budget
+    bool isComplete() { return complete; }
+
+    /// \brief Called on orderly shutdown, probes that are still running
+    /// are stopped and not counted as crashes.
+    static void shutdownQuarantine();
+
+#ifdef HAVE_FFMPEGTHUMBNAILER
+    /// \brief Returns the thumbnail cache file of a video file.
+    /// \param location path of the video file
+    /// \param create create missing directories of the cache file
+    static zmm::String getThumbnailCachePath(zmm::String location, bool create);
+#endif
+
+protected:
+    bool complete;
 };
 
 #endif//__FFMPEG_HANDLER_H__
@@ -0,0 +1,361 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    image_scale_handler.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file image_scale_handler.cc
+/// \brief Implementation of the ImageScaleHandler class.
+
+#ifdef HAVE_LIBJPEG
+
+#include "image_scale_handler.h"
+
+#include <cerrno>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// jpeglib.h needs FILE and size_t declared first
+extern "C" {
+#include <jpeglib.h>
+}
+
+#include "config_manager.h"
+#include "file_io_handler.h"
+#include "tools.h"
+
+using namespace zmm;
+
+struct rendition_profile_t {
+    const char* name;
+    int width;
+    int height;
+};
+
+// DLNA media format profiles for JPEG, JPEG_LRG is left to the original
+static const rendition_profile_t RENDITION_PROFILES[] = {
+    { "JPEG_TN", 160, 160 },
+    { "JPEG_SM", 640, 480 },
+    { "JPEG_MED", 1024, 768 },
+};
+#define RENDITION_PROFILE_COUNT (sizeof(RENDITION_PROFILES) / sizeof(RENDITION_PROFILES[0]))
+
+static const rendition_profile_t* getProfile(String name)
+{
+    for (size_t i = 0; i < RENDITION_PROFILE_COUNT; i++) {
+        if (name == RENDITION_PROFILES[i].name)
+            return &RENDITION_PROFILES[i];
+    }
+    return nullptr;
+}
+
+// Fits the image into the profile box keeping the aspect ratio, returns
+// false if the image already fits
+static bool fitProfile(const rendition_profile_t* profile, int x, int y, int* width, int* height)
+{
+    if (x <= 0 || y <= 0 || (x <= profile->width && y <= profile->height))
+        return false;
+
+    if ((long)x * profile->height >= (long)y * profile->width) {
+        *width = profile->width;
+        *height = (int)(((long)y * profile->width + x / 2) / x);
+    } else {
+        *height = profile->height;
+        *width = (int)(((long)x * profile->height + y / 2) / y);
+    }
+    if (*width < 1)
+        *width = 1;
+    if (*height < 1)
+        *height = 1;
+    return true;
+}
+
+// shared by the decompressor and the compressor of one scaleJpeg() call
+struct scale_error_t {
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+};
+
+static void scaleErrorExit(j_common_ptr cinfo)
+{
+    // the default handler calls exit()
+    longjmp(((scale_error_t*)cinfo->err)->jump, 1);
+}
+
+static void scaleOutputMessage(j_common_ptr cinfo)
+{
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, buffer);
+    log_debug("libjpeg: %s\n", buffer);
+}
+
+// Averages the source pixels covered by each target pixel
+static void boxScale(const unsigned char* src, int srcWidth, int srcHeight,
+    unsigned char* dst, int dstWidth, int dstHeight, int components)
+{
+    for (int ty = 0; ty < dstHeight; ty++) {
+        int y0 = (int)((long)ty * srcHeight / dstHeight);
+        int y1 = (int)((long)(ty + 1) * srcHeight / dstHeight);
+        if (y1 <= y0)
+            y1 = y0 + 1;
+        for (int tx = 0; tx < dstWidth; tx++) {
+            int x0 = (int)((long)tx * srcWidth / dstWidth);
+            int x1 = (int)((long)(tx + 1) * srcWidth / dstWidth);
+            if (x1 <= x0)
+                x1 = x0 + 1;
+            for (int c = 0; c < components; c++) {
+                unsigned long sum = 0;
+                for (int sy = y0; sy < y1; sy++) {
+                    const unsigned char* row = src + ((size_t)sy * srcWidth + x0) * components + c;
+                    for (int sx = x0; sx < x1; sx++, row += components)
+                        sum += *row;
+                }
+                dst[((size_t)ty * dstWidth + tx) * components + c] = (unsigned char)(sum / ((unsigned long)(y1 - y0) * (x1 - x0)));
+            }
+        }
+    }
+}
+
+// Decodes source with the largest DCT scaling that keeps it at least
+// as big as the box, scales the rest with a box filter and encodes the
+// result to target. Only plain C types live in this frame because of
+// the longjmp error handling.
+static bool scaleJpeg(const char* source, const char* target,
+    const rendition_profile_t* profile, int quality)
+{
+    struct jpeg_decompress_struct dinfo;
+    struct jpeg_compress_struct cinfo;
+    struct scale_error_t err;
+    FILE* volatile in = nullptr;
+    FILE* volatile out = nullptr;
+    unsigned char* volatile decoded = nullptr;
+    unsigned char* volatile scaled = nullptr;
+    volatile bool haveCompress = false;
+    volatile bool ok = false;
+
+    dinfo.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = scaleErrorExit;
+    err.pub.output_message = scaleOutputMessage;
+    cinfo.err = &err.pub;
+    jpeg_create_decompress(&dinfo);
+
+    if (setjmp(err.jump))
+        goto cleanup;
+
+    in = fopen(source, "rb");
+    if (!in)
+        goto cleanup;
+    jpeg_stdio_src(&dinfo, in);
+    jpeg_read_header(&dinfo, TRUE);
+
+    int width, height;
+    if (!fitProfile(profile, dinfo.image_width, dinfo.image_height, &width, &height))
+        goto cleanup;
+
+    dinfo.out_color_space = (dinfo.jpeg_color_space == JCS_GRAYSCALE) ? JCS_GRAYSCALE : JCS_RGB;
+    dinfo.scale_num = 1;
+    dinfo.scale_denom = 1;
+    for (unsigned int denom = 8; denom > 1; denom /= 2) {
+        if (dinfo.image_width / denom >= (unsigned int)width
+            && dinfo.image_height / denom >= (unsigned int)height) {
+            dinfo.scale_denom = denom;
+            break;
+        }
+    }
+    dinfo.dct_method = JDCT_IFAST;
+    jpeg_start_decompress(&dinfo);
+
+    {
+        int components = dinfo.output_components;
+        size_t stride = (size_t)dinfo.output_width * components;
+        decoded = (unsigned char*)malloc(stride * dinfo.output_height);
+        scaled = (unsigned char*)malloc((size_t)width * height * components);
+        if (!decoded || !scaled)
+            goto cleanup;
+
+        while (dinfo.output_scanline < dinfo.output_height) {
+            JSAMPROW row = decoded + stride * dinfo.output_scanline;
+            jpeg_read_scanlines(&dinfo, &row, 1);
+        }
+        jpeg_finish_decompress(&dinfo);
+
+        boxScale(decoded, dinfo.output_width, dinfo.output_height,
+            scaled, width, height, components);
+
+        out = fopen(target, "wb");
+        if (!out)
+            goto cleanup;
+
+        jpeg_create_compress(&cinfo);
+        haveCompress = true;
+        jpeg_stdio_dest(&cinfo, out);
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = components;
+        cinfo.in_color_space = dinfo.out_color_space;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        jpeg_start_compress(&cinfo, TRUE);
+        while (cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW row = scaled + (size_t)cinfo.next_scanline * width * components;
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_compress(&cinfo);
+        ok = true;
+    }
+
+cleanup:
+    if (haveCompress)
+        jpeg_destroy_compress(&cinfo);
+    jpeg_destroy_decompress(&dinfo);
+    if (out && fclose(out) != 0)
+        ok = false;
+    if (in)
+        fclose(in);
+    free(decoded);
+    free(scaled);
+    return ok;
+}
+
+ImageScaleHandler::ImageScaleHandler()
+    : MetadataHandler()
+{
+}
+
+String ImageScaleHandler::getCachePath(String location, String profile)
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    String cacheDir = cfg->getOption(CFG_SERVER_IMAGE_SCALING_CACHE_DIR);
+    if (!string_ok(cacheDir))
+        cacheDir = cfg->getOption(CFG_SERVER_HOME) + DIR_SEPARATOR + DEFAULT_IMAGE_SCALING_CACHE_DIR;
+    return cacheDir + location + "-" + profile + ".jpg";
+}
+
+String ImageScaleHandler::getRendition(String location, String profile)
+{
+    const rendition_profile_t* p = getProfile(profile);
+    if (p == nullptr)
+        return nullptr;
+
+    struct stat source;
+    struct stat cached;
+    if (stat(location.c_str(), &source) != 0)
+        return nullptr;
+
+    String path = getCachePath(location, profile);
+    if (stat(path.c_str(), &cached) == 0 && cached.st_mtime >= source.st_mtime)
+        return path;
+
+    if (!make_parent_dirs(path))
+        return nullptr;
+
+    // concurrent requests for the same rendition each write their own file
+    String part = path + ".XXXXXX";
+    int fd = mkstemp(const_cast<char*>(part.c_str()));
+    if (fd < 0)
+        return nullptr;
+    close(fd);
+
+    int quality = ConfigManager::getInstance()->getIntOption(CFG_SERVER_IMAGE_SCALING_QUALITY);
+    if (!scaleJpeg(location.c_str(), part.c_str(), p, quality)
+        || rename(part.c_str(), path.c_str()) != 0) {
+        unlink(part.c_str());
+        log_debug("Could not scale %s to %s\n", location.c_str(), profile.c_str());
+        return nullptr;
+    }
+    return path;
+}
+
+void ImageScaleHandler::generateRenditions(String location)
+{
+    for (size_t i = 0; i < RENDITION_PROFILE_COUNT; i++) {
+        // images smaller than a profile do not get that rendition
+        if (getRendition(location, _(RENDITION_PROFILES[i].name)) == nullptr)
+            break;
+    }
+}
+
+void ImageScaleHandler::fillMetadata(Ref<CdsItem> item)
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    if (!cfg->getBoolOption(CFG_SERVER_IMAGE_SCALING_ENABLED))
+        return;
+
+    String resolution = item->getResource(0)->getAttribute(MetadataHandler::getResAttrName(R_RESOLUTION));
+    if (!string_ok(resolution)) {
+        set_jpeg_resolution_resource(item, 0);
+        resolution = item->getResource(0)->getAttribute(MetadataHandler::getResAttrName(R_RESOLUTION));
+    }
+
+    int x;
+    int y;
+    if (!string_ok(resolution) || !check_resolution(resolution, &x, &y))
+        return;
+
+    for (size_t i = 0; i < RENDITION_PROFILE_COUNT; i++) {
+        int width;
+        int height;
+        if (!fitProfile(&RENDITION_PROFILES[i], x, y, &width, &height))
+            break;
+
+        Ref<CdsResource> resource(new CdsResource(CH_IMAGESCALE));
+        resource->addAttribute(MetadataHandler::getResAttrName(R_PROTOCOLINFO),
+            renderProtocolInfo(getMimeType()));
+        resource->addAttribute(MetadataHandler::getResAttrName(R_RESOLUTION),
+            String::from(width) + "x" + String::from(height));
+        resource->addParameter(_(RESOURCE_RENDITION), _(RENDITION_PROFILES[i].name));
+        // lets the protocolInfo extension label it JPEG_TN
+        if (i == 0)
+            resource->addOption(_(RESOURCE_CONTENT_TYPE), _(THUMBNAIL));
+        item->addResource(resource);
+    }
+}
+
+Ref<IOHandler> ImageScaleHandler::serveContent(Ref<CdsItem> item, int resNum, off_t *data_size)
+{
+    Ref<CdsResource> res = item->getResource(resNum);
+    String profile = res->getParameter(_(RESOURCE_RENDITION));
+
+    String path = getRendition(item->getLocation(), profile);
+    if (path == nullptr)
+        throw _Exception(_("ImageScaleHandler: could not scale ") + item->getLocation()
+            + " to " + profile);
+
+    // served from the file, the page cache keeps the hot renditions
+    *data_size = -1;
+    return Ref<IOHandler>(new FileIOHandler(path));
+}
+
+String ImageScaleHandler::getMimeType()
+{
+    // renditions are always encoded as JPEG
+    return _("image/jpeg");
+}
+
+#endif // HAVE_LIBJPEG
@@ -0,0 +1,65 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    image_scale_handler.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file image_scale_handler.h
+/// \brief Definition of the ImageScaleHandler class.
+
+#ifdef HAVE_LIBJPEG
+
+#ifndef __METADATA_IMAGE_SCALE_H__
+#define __METADATA_IMAGE_SCALE_H__
+
+#include "metadata_handler.h"
+
+/// \brief Serves JPEG images downscaled to the DLNA JPEG_TN, JPEG_SM and
+/// JPEG_MED sizes.
+///
+/// Import adds a resource for every size that is smaller than the image.
+/// The renditions are decoded with libjpeg DCT scaling, encoded once and
+/// kept in the rendition cache directory next to their source path.
+class ImageScaleHandler : public MetadataHandler
+{
+public:
+    ImageScaleHandler();
+    virtual void fillMetadata(zmm::Ref<CdsItem> item);
+    virtual zmm::Ref<IOHandler> serveContent(zmm::Ref<CdsItem> item, int resNum, off_t *data_size);
+    virtual zmm::String getMimeType();
+
+    /// \brief Creates all missing or outdated renditions of an image.
+    static void generateRenditions(zmm::String location);
+
+protected:
+    /// \brief Returns the cached rendition, generating it if needed.
+    /// \return the cache file or nullptr if the image could not be scaled
+    static zmm::String getRendition(zmm::String location, zmm::String profile);
+    static zmm::String getCachePath(zmm::String location, zmm::String profile);
+};
+
+#endif // __METADATA_IMAGE_SCALE_H__
+
+#endif // HAVE_LIBJPEG
@@ -0,0 +1,289 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    metadata_cache.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file metadata_cache.cc
+/// \brief Implementation of the MetadataCache class.
+
+#include "metadata_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "config_manager.h"
+#include "tools.h"
+
+/// \brief "GMC1" - bump when the on-disk entry layout changes
+#define METADATA_CACHE_MAGIC 0x31434d47
+/// \brief upper bound for a single serialized string, protects against
+/// reading garbage from truncated or foreign files
+#define METADATA_CACHE_MAX_STRING (16 * 1024 * 1024)
+#define METADATA_CACHE_MAX_RESOURCES 256
+
+using namespace zmm;
+
+static bool writeUInt64(FILE* f, uint64_t value)
+{
+    return fwrite(&value, sizeof(value), 1, f) == 1;
+}
+
+static bool readUInt64(FILE* f, uint64_t* value)
+{
+    return fread(value, sizeof(*value), 1, f) == 1;
+}
+
+static bool writeString(FILE* f, String str)
+{
+    uint64_t len = (str == nullptr) ? 0 : str.length();
+    if (!writeUInt64(f, len))
+        return false;
+    return (len == 0) || (fwrite(str.c_str(), 1, len, f) == len);
+}
+
+static bool readString(FILE* f, String& str)
+{
+    uint64_t len;
+    if (!readUInt64(f, &len) || len > METADATA_CACHE_MAX_STRING)
+        return false;
+    if (len == 0) {
+        str = _("");
+        return true;
+    }
+    str = String::allocate(len);
+    auto* data = const_cast<char*>(str.c_str());
+    if (fread(data, 1, len, f) != len)
+        return false;
+    data[len] = 0;
+    return true;
+}
+
+MetadataCache::MetadataCache()
+    : Singleton<MetadataCache>()
+    , enabled(false)
+    , maxEntries(0)
+    , stored(0)
+    , hits(0)
+    , misses(0)
+{
+}
+
+void MetadataCache::init()
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    enabled = cfg->getBoolOption(CFG_IMPORT_METADATA_CACHE_ENABLED);
+    if (!enabled)
+        return;
+
+    cacheDir = cfg->getOption(CFG_IMPORT_METADATA_CACHE_DIR);
+    if (!string_ok(cacheDir))
+        cacheDir = cfg->getOption(CFG_SERVER_HOME) + DIR_SEPARATOR + DEFAULT_METADATA_CACHE_DIR;
+
+    if (mkdir(cacheDir.c_str(), 0777) < 0 && errno != EEXIST) {
+        log_error("Could not create metadata cache directory %s: %s\n",
+            cacheDir.c_str(), mt_strerror(errno).c_str());
+        enabled = false;
+        return;
+    }
+    log_info("Metadata cache enabled: %s\n", cacheDir.c_str());
+
+    maxEntries = cfg->getIntOption(CFG_IMPORT_METADATA_CACHE_MAX_ENTRIES);
+    if (maxEntries > 0)
+        prune();
+}
+
+void MetadataCache::prune()
+{
+    std::vector<std::pair<time_t, std::string>> entries;
+    for (int i = 0; i < 256; i++) {
+        char shard[3];
+        snprintf(shard, sizeof(shard), "%02x", i);
+        std::string dir = std::string(cacheDir.c_str()) + DIR_SEPARATOR + shard;
+        DIR* d = opendir(dir.c_str());
+        if (d == nullptr)
+            continue;
+        struct dirent* de;
+        while ((de = readdir(d)) != nullptr) {
+            if (de->d_name[0] == '.' || strstr(de->d_name, ".tmp.") != nullptr)
+                continue;
+            std::string path = dir + DIR_SEPARATOR + de->d_name;
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0)
+                entries.emplace_back(st.st_mtime, path);
+        }
+        closedir(d);
+    }
+
+    if (entries.size() <= (size_t)maxEntries)
+        return;
+
+    // down to 90%, so that the next prune is some stores away
+    size_t remove = entries.size() - (size_t)maxEntries * 9 / 10;
+    std::nth_element(entries.begin(), entries.begin() + remove, entries.end());
+    for (size_t i = 0; i < remove; i++)
+        unlink(entries[i].second.c_str());
+    log_debug("pruned %d of %d metadata cache entries\n", (int)remove, (int)entries.size());
+}
+
+void MetadataCache::shutdown()
+{
+    if (enabled)
+        log_debug("metadata cache hits: %ld, misses: %ld\n", getHits(), getMisses());
+}
+
+String MetadataCache::getEntryPath(struct stat* statbuf, bool create)
+{
+    // spread the entries over 256 subdirectories, large libraries would
+    // otherwise end up with a single directory holding every file
+    char shard[3];
+    snprintf(shard, sizeof(shard), "%02x", (unsigned int)(statbuf->st_ino & 0xff));
+    String dir = cacheDir + DIR_SEPARATOR + shard;
+
+    if (create && mkdir(dir.c_str(), 0777) < 0 && errno != EEXIST) {
+        log_debug("could not create %s: %s\n", dir.c_str(), mt_strerror(errno).c_str());
+        return nullptr;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%llx-%llx",
+        (unsigned long long)statbuf->st_dev, (unsigned long long)statbuf->st_ino);
+    return dir + DIR_SEPARATOR + name;
+}
+
+bool MetadataCache::restore(Ref<CdsItem> item, struct stat* statbuf)
+{
+    if (!enabled)
+        return false;
+
+    String path = getEntryPath(statbuf, false);
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        misses++;
+        return false;
+    }
+
+    bool ok = false;
+    uint64_t magic, size, mtime, flags, count;
+    String mimetype, metadata, auxdata;
+
+    // the entry file is named after (device, inode), size and mtime are
+    // stored inside so a modified file simply overwrites its stale entry
+    if (readUInt64(f, &magic) && magic == METADATA_CACHE_MAGIC
+        && readUInt64(f, &size) && size == (uint64_t)statbuf->st_size
+        && readUInt64(f, &mtime) && mtime == (uint64_t)statbuf->st_mtime
+        && readString(f, mimetype) && mimetype == item->getMimeType()
+        && readUInt64(f, &flags)
+        && readString(f, metadata)
+        && readString(f, auxdata)
+        && readUInt64(f, &count) && count <= METADATA_CACHE_MAX_RESOURCES) {
+
+        Ref<Array<CdsResource>> resources(new Array<CdsResource>(count));
+        String res;
+        ok = true;
+        for (uint64_t i = 0; i < count; i++) {
+            if (!readString(f, res)) {
+                ok = false;
+                break;
+            }
+            resources->append(CdsResource::decode(res));
+        }
+
+        if (ok) {
+            item->getMetadata()->decode(metadata);
+            item->getAuxData()->decode(auxdata);
+            for (int i = 0; i < resources->size(); i++)
+                item->addResource(resources->get(i));
+            item->setFlag((unsigned int)flags);
+        }
+    }
+    fclose(f);
+
+    if (ok) {
+        hits++;
+        // the entry mtime is the last use, see prune()
+        utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+        log_debug("metadata cache hit: %s\n", item->getLocation().c_str());
+    } else
+        misses++;
+    return ok;
+}
+
+void MetadataCache::store(Ref<CdsItem> item, struct stat* statbuf, unsigned int addedFlags)
+{
+    if (!enabled)
+        return;
+
+    String path = getEntryPath(statbuf, true);
+    if (path == nullptr)
+        return;
+
+    // write to a temporary file first, concurrent imports of hardlinked
+    // files must never see a half written entry
+    String tmpPath = path + ".tmp." + String::from((long)getpid()) + "." + String::from((unsigned long)pthread_self());
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        log_debug("could not write metadata cache entry %s: %s\n", tmpPath.c_str(), mt_strerror(errno).c_str());
+        return;
+    }
+
+    Ref<Array<CdsResource>> resources = item->getResources();
+    bool ok = writeUInt64(f, METADATA_CACHE_MAGIC)
+        && writeUInt64(f, statbuf->st_size)
+        && writeUInt64(f, statbuf->st_mtime)
+        && writeString(f, item->getMimeType())
+        && writeUInt64(f, addedFlags)
+        && writeString(f, item->getMetadata()->encode())
+        && writeString(f, item->getAuxData()->encode())
+        && writeUInt64(f, resources->size());
+
+    for (int i = 0; ok && i < resources->size(); i++)
+        ok = writeString(f, resources->get(i)->encode());
+
+    if (fclose(f) != 0)
+        ok = false;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        log_debug("could not write metadata cache entry %s\n", path.c_str());
+        unlink(tmpPath.c_str());
+        return;
+    }
+
+    if (maxEntries > 0 && ++stored >= std::max(maxEntries / 10, 1)) {
+        std::unique_lock<std::mutex> lock(pruneMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            stored = 0;
+            prune();
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    metadata_cache.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file metadata_cache.h
+/// \brief Definition of the MetadataCache class.
+
+#ifndef __METADATA_CACHE_H__
+#define __METADATA_CACHE_H__
+
+#include <atomic>
+#include <mutex>
+#include <sys/stat.h>
+
+#include "cds_objects.h"
+#include "common.h"
+#include "singleton.h"
+
+/// \brief Persistent on-disk cache of extracted file metadata.
+///
+/// Entries are keyed by the identity of the file on disk (device, inode,
+/// size and modification time), so re-importing an unchanged file - after
+/// an mtime-neutral rescan, a layout reload or a database reset - replays
+/// the stored metadata instead of parsing the media headers again.
+/// Entries of files that are gone can not be told apart from others, so
+/// the least recently used entries are pruned once there are more than
+/// max-entries of them.
+class MetadataCache : public Singleton<MetadataCache>
+{
+public:
+    MetadataCache();
+    virtual void init() override;
+    virtual void shutdown() override;
+    zmm::String getName() override { return _("Metadata Cache"); }
+
+    inline bool isEnabled() { return enabled; }
+
+    /// \brief Fills the item from a cached entry.
+    /// \param item item to fill, mimetype and location must be set
+    /// \param statbuf stat information of the item location
+    /// \return true if a matching entry was found and restored
+    bool restore(zmm::Ref<CdsItem> item, struct stat* statbuf);
+
+    /// \brief Stores metadata, auxdata, resources and flags of the item.
+    /// Callers skip this if the extraction was incomplete.
+    /// \param item item after metadata extraction
+    /// \param statbuf stat information of the item location
+    /// \param addedFlags object flags that were set by the extraction
+    void store(zmm::Ref<CdsItem> item, struct stat* statbuf, unsigned int addedFlags);
+
+    inline long getHits() { return hits; }
+    inline long getMisses() { return misses; }
+
+protected:
+    bool enabled;
+    zmm::String cacheDir;
+    int maxEntries;
+
+    /// \brief entries written since the last prune
+    std::atomic<long> stored;
+    std::mutex pruneMutex;
+    void prune();
+
+    std::atomic<long> hits;
+    std::atomic<long> misses;
+
+    zmm::String getEntryPath(struct stat* statbuf, bool create);
+};
+
+#endif // __METADATA_CACHE_H__
@@ -33,6 +33,10 @@
 #include "metadata_handler.h"
 #include "tools.h"
 #include "config_manager.h"
+#include "metadata_cache.h"
+
+#include <cerrno>
+#include <sys/stat.h>
 
 #ifdef HAVE_EXIV2
 #include "metadata/exiv2_handler.h"
@@ -46,6 +50,15 @@
 #include "metadata/ffmpeg_handler.h"
 #endif
 
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+#include "thumbnail_service.h"
+#endif
+
+#ifdef HAVE_LIBJPEG
+#include "content_manager.h"
+#include "metadata/image_scale_handler.h"
+#endif
+
 #ifdef HAVE_LIBEXIF
 #include "metadata/libexif_handler.h"
 #endif
@@ -90,14 +103,57 @@ MetadataHandler::MetadataHandler() : Object()
 {
 }
        
-void MetadataHandler::setMetadata(Ref<CdsItem> item)
+// Thumbnails and image renditions are generated in the background
+static void queueDerivedContent(Ref<CdsItem> item)
+{
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+    if (item->getMimeType().startsWith(_("video")) ||
+        item->getFlag(OBJECT_FLAG_OGG_THEORA))
+    {
+        ThumbnailService::getInstance()->enqueue(item->getLocation());
+    }
+#endif
+#ifdef HAVE_LIBJPEG
+    for (int i = 1; i < item->getResourceCount(); i++)
+    {
+        if (item->getResource(i)->getHandlerType() == CH_IMAGESCALE)
+        {
+            ContentManager::getInstance()->queueRenditions(item->getLocation());
+            break;
+        }
+    }
+#endif
+}
+
+void MetadataHandler::setMetadata(Ref<CdsItem> item, struct stat* statbuf, Ref<MediaProbe> probe)
 {
     String location = item->getLocation();
-    off_t filesize;
+    struct stat st;
 
     string_ok_ex(location);
-    check_path_ex(location, false, false, &filesize);
+    if (statbuf == nullptr) {
+        if (stat(location.c_str(), &st) != 0)
+            throw _Exception(mt_strerror(errno) + ": " + location);
+        statbuf = &st;
+    }
+    if (S_ISDIR(statbuf->st_mode))
+        throw _Exception(_("Not a file: ") + location);
+
+    Ref<MetadataCache> cache = MetadataCache::getInstance();
+    if (cache->restore(item, statbuf)) {
+        // fanart depends on neighbouring files, so it is never cached
+        FanArtHandler().fillMetadata(item);
+        queueDerivedContent(item);
+        return;
+    }
 
+    if (probe == nullptr)
+        probe = Ref<MediaProbe>(new MediaProbe(location, statbuf));
+
+    off_t filesize = S_ISREG(statbuf->st_mode) ? statbuf->st_size : 0;
+    unsigned int flags = item->getFlags();
+    // a probe that timed out or was skipped must be retried next time
+    bool complete = true;
     String mimetype = item->getMimeType();
 
     Ref<CdsResource> resource(new CdsResource(CH_DEFAULT));
@@ -109,7 +165,7 @@ void MetadataHandler::setMetadata(Ref<CdsItem> item)
     Ref<Dictionary> mappings = ConfigManager::getInstance()->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
     String content_type = mappings->get(mimetype);
    
-    if ((content_type == CONTENT_TYPE_OGG) && (isTheora(item->getLocation())))
+    if ((content_type == CONTENT_TYPE_OGG) && (probe->isTheora()))
             item->setFlag(OBJECT_FLAG_OGG_THEORA);
 
 #ifdef HAVE_TAGLIB
@@ -143,6 +199,14 @@ void MetadataHandler::setMetadata(Ref<CdsItem> item)
     }
 #endif // HAVE_LIBEXIF
 
+#ifdef HAVE_LIBJPEG
+    // after the exif handlers, they already know the resolution
+    if (content_type == CONTENT_TYPE_JPG)
+    {
+        ImageScaleHandler().fillMetadata(item);
+    }
+#endif // HAVE_LIBJPEG
+
 #ifdef HAVE_FFMPEG
     if (content_type != CONTENT_TYPE_PLAYLIST &&
         ((content_type == CONTENT_TYPE_OGG &&
@@ -150,12 +214,14 @@ void MetadataHandler::setMetadata(Ref<CdsItem> item)
         item->getMimeType().startsWith(_("video")) ||
         item->getMimeType().startsWith(_("audio"))))
     {
-        FfmpegHandler().fillMetadata(item);
+        FfmpegHandler handler;
+        handler.fillMetadata(item);
+        complete = handler.isComplete();
     }
 #else
     if (content_type == CONTENT_TYPE_AVI)
     {
-        String fourcc = getAVIFourCC(item->getLocation());
+        String fourcc = probe->getAVIFourCC();
         if (string_ok(fourcc))
         {
             item->getResource(0)->addOption(_(RESOURCE_OPTION_FOURCC),
@@ -165,8 +231,12 @@ void MetadataHandler::setMetadata(Ref<CdsItem> item)
 
 #endif // HAVE_FFMPEG
 
+    if (complete)
+        cache->store(item, statbuf, item->getFlags() & ~flags);
+
     // Fanart for all things!
     FanArtHandler().fillMetadata(item);
+    queueDerivedContent(item);
 }
 
 String MetadataHandler::getMetaFieldName(metadata_fields_t field)
@@ -197,6 +267,10 @@ Ref<MetadataHandler> MetadataHandler::createHandler(int handlerType)
 #endif
         case CH_FANART:
             return Ref<MetadataHandler>(new FanArtHandler());
+#ifdef HAVE_LIBJPEG
+        case CH_IMAGESCALE:
+            return Ref<MetadataHandler>(new ImageScaleHandler());
+#endif
         default:
             throw _Exception(_("unknown content handler ID: ") + handlerType);
     }
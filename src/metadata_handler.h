@@ -32,10 +32,13 @@
 #ifndef __METADATA_HANDLER_H__
 #define __METADATA_HANDLER_H__
 
+#include <sys/stat.h>
+
 #include "common.h"
 #include "dictionary.h"
 #include "cds_objects.h"
 #include "io_handler.h"
+#include "media_probe.h"
 
 // content handler Id's
 #define CH_DEFAULT   0
@@ -47,6 +50,7 @@
 #define CH_FFTH      6
 #define CH_FLAC      7
 #define CH_FANART    8
+#define CH_IMAGESCALE 9
 
 #define CONTENT_TYPE_MP3        "mp3"
 #define CONTENT_TYPE_OGG        "ogg"
@@ -69,6 +73,7 @@
 
 #define RESOURCE_CONTENT_TYPE   "rct"
 #define RESOURCE_HANDLER        "rh"
+#define RESOURCE_RENDITION      "rnd" // DLNA profile of a scaled image
 
 #define ID3_ALBUM_ART           "aa"
 #define EXIF_THUMBNAIL          "EX_TH"
@@ -140,7 +145,10 @@ public:
 
     MetadataHandler();
        
-    static void setMetadata(zmm::Ref<CdsItem> item);
+    /// \brief Adds the default resource and extracts metadata of the item.
+    /// \param statbuf stat information of the item location if the caller
+    /// already has it, the location is stat'ed otherwise
+    static void setMetadata(zmm::Ref<CdsItem> item, struct stat *statbuf = nullptr, zmm::Ref<MediaProbe> probe = nullptr);
     static zmm::String getMetaFieldName(metadata_fields_t field);
     static zmm::String getResAttrName(resource_attributes_t attr);
 
@@ -0,0 +1,88 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    mime_type_map.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file mime_type_map.cc
+
+#include "mime_type_map.h"
+
+#include "tools.h"
+
+using namespace zmm;
+
+MimeTypeMap::MimeTypeMap(Ref<Dictionary> extensionMimetype,
+    Ref<Dictionary> mimetypeUpnpclass, bool caseSensitive)
+    : caseSensitive(caseSensitive)
+{
+    // first entry wins, like Dictionary::get()
+    Ref<Array<DictionaryElement>> elements = mimetypeUpnpclass->getElements();
+    for (int i = 0; i < elements->size(); i++) {
+        Ref<DictionaryElement> el = elements->get(i);
+        upnpClassMap.emplace(std::string(el->getKey().c_str()), el->getValue());
+    }
+    elements = extensionMimetype->getElements();
+    for (int i = 0; i < elements->size(); i++) {
+        Ref<DictionaryElement> el = elements->get(i);
+        MimeMapping mapping { el->getValue(), mimetype2upnpclass(el->getValue()) };
+        extensionMap.emplace(std::string(el->getKey().c_str()), mapping);
+    }
+}
+
+const MimeTypeMap::MimeMapping* MimeTypeMap::extension2mapping(String extension) const
+{
+    if (!string_ok(extension))
+        return nullptr;
+
+    std::string key(extension.c_str(), extension.length());
+    if (!caseSensitive) {
+        for (auto& c : key)
+            c = tolower(static_cast<unsigned char>(c));
+    }
+
+    auto it = extensionMap.find(key);
+    if (it == extensionMap.end())
+        return nullptr;
+    return &it->second;
+}
+
+String MimeTypeMap::mimetype2upnpclass(String mimeType) const
+{
+    if (!string_ok(mimeType))
+        return nullptr;
+    std::string key(mimeType.c_str(), mimeType.length());
+    auto it = upnpClassMap.find(key);
+    if (it != upnpClassMap.end())
+        return it->second;
+    // try to match foo
+    size_t slash = key.find('/');
+    if (slash == std::string::npos || key.find('/', slash + 1) != std::string::npos)
+        return nullptr;
+    it = upnpClassMap.find(key.substr(0, slash) + "/*");
+    if (it != upnpClassMap.end())
+        return it->second;
+    return nullptr;
+}
@@ -0,0 +1,74 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    mime_type_map.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file mime_type_map.h
+/// \brief Definition of the MimeTypeMap class.
+
+#ifndef __MIME_TYPE_MAP_H__
+#define __MIME_TYPE_MAP_H__
+
+#include <string>
+#include <unordered_map>
+
+#include "dictionary.h"
+
+/// \brief Resolves file extensions to mime type and upnp class.
+///
+/// The mapping dictionaries from the configuration are compiled into hash
+/// tables once, lookups are read only afterwards so the import threads
+/// need no locking.
+class MimeTypeMap
+{
+public:
+    /// \brief mime type and upnp class resolved from a file extension
+    struct MimeMapping {
+        zmm::String mimetype;
+        zmm::String upnpClass;
+    };
+
+    /// \param extensionMimetype extension to mime type mappings
+    /// \param mimetypeUpnpclass mime type to upnp class mappings, keys may
+    /// be a major type like "audio/*"
+    /// \param caseSensitive extensions are compared case sensitive
+    MimeTypeMap(zmm::Ref<Dictionary> extensionMimetype,
+        zmm::Ref<Dictionary> mimetypeUpnpclass, bool caseSensitive);
+
+    /// \brief Looks up the extension in the precompiled mapping table.
+    /// \return nullptr if the extension is not mapped
+    const MimeMapping* extension2mapping(zmm::String extension) const;
+
+    /// \return the upnp class of the mime type or nullptr
+    zmm::String mimetype2upnpclass(zmm::String mimeType) const;
+
+protected:
+    bool caseSensitive;
+    std::unordered_map<std::string, MimeMapping> extensionMap;
+    std::unordered_map<std::string, zmm::String> upnpClassMap;
+};
+
+#endif // __MIME_TYPE_MAP_H__
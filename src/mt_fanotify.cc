@@ -0,0 +1,292 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    mt_fanotify.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file mt_fanotify.cc
+
+#ifdef HAVE_FANOTIFY
+
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+
+#include "mt_fanotify.h"
+#include "tools.h"
+
+using namespace zmm;
+
+Fanotify::Fanotify()
+{
+    fanotify_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_REPORT_DFID_NAME, O_RDONLY | O_LARGEFILE);
+    if (fanotify_fd < 0)
+        throw _Exception(_("Unable to initialize fanotify: ") + mt_strerror(errno));
+
+    int stop_fds_pipe[2];
+    if (pipe(stop_fds_pipe) < 0) {
+        close(fanotify_fd);
+        throw _Exception(_("Unable to create pipe!\n"));
+    }
+
+    stop_fd_read = stop_fds_pipe[0];
+    stop_fd_write = stop_fds_pipe[1];
+    bufferLength = 0;
+    bufferOffset = 0;
+    permissionDenied = false;
+    readErrors = 0;
+}
+
+Fanotify::~Fanotify()
+{
+    for (auto& fs : filesystems)
+        close(fs.second.mountFd);
+    close(stop_fd_read);
+    close(stop_fd_write);
+    if (fanotify_fd >= 0)
+        close(fanotify_fd);
+}
+
+bool Fanotify::supported(String path)
+{
+    int test_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME, O_RDONLY);
+    if (test_fd < 0)
+        return false;
+    close(test_fd);
+
+    // resolving handles needs CAP_DAC_READ_SEARCH, which marking does not
+    char handleBuf[sizeof(struct file_handle) + MAX_HANDLE_SZ];
+    auto* handle = (struct file_handle*)handleBuf;
+    handle->handle_bytes = MAX_HANDLE_SZ;
+    int mountId;
+    if (name_to_handle_at(AT_FDCWD, path.c_str(), handle, &mountId, 0) < 0)
+        return false;
+
+    int mountFd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (mountFd < 0)
+        return false;
+    int fd = open_by_handle_at(mountFd, handle, O_PATH | O_CLOEXEC);
+    close(mountFd);
+    if (fd < 0)
+        return false;
+    close(fd);
+    return true;
+}
+
+bool Fanotify::getFsid(int fd, uint64_t* fsid)
+{
+    struct statfs buf;
+    if (fstatfs(fd, &buf) < 0)
+        return false;
+    *fsid = ((uint64_t)(uint32_t)buf.f_fsid.__val[0] << 32) | (uint32_t)buf.f_fsid.__val[1];
+    return true;
+}
+
+bool Fanotify::addMark(String path, uint64_t events)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    uint64_t fsid;
+    if (fd < 0 || !getFsid(fd, &fsid)) {
+        log_warning("Cannot add fanotify mark for %s: %s\n", path.c_str(), mt_strerror(errno).c_str());
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    AutoLock lock(mutex);
+    auto it = filesystems.find(fsid);
+    if (it != filesystems.end()) {
+        it->second.refCount++;
+        close(fd);
+        return true;
+    }
+
+    if (fanotify_mark(fanotify_fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, events, fd, nullptr) < 0) {
+        log_warning("Cannot add fanotify mark for %s: %s\n", path.c_str(), mt_strerror(errno).c_str());
+        close(fd);
+        return false;
+    }
+
+    filesystems[fsid] = Filesystem { fd, 1 };
+    return true;
+}
+
+void Fanotify::removeMark(String path, uint64_t events)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    uint64_t fsid;
+    bool found = (fd >= 0 && getFsid(fd, &fsid));
+    if (fd >= 0)
+        close(fd);
+    if (!found) {
+        // the directory is gone, the mark stays until the filesystem is
+        // unmounted or the server is shut down
+        log_debug("Cannot determine filesystem of %s\n", path.c_str());
+        return;
+    }
+
+    AutoLock lock(mutex);
+    auto it = filesystems.find(fsid);
+    if (it == filesystems.end() || --it->second.refCount > 0)
+        return;
+
+    if (fanotify_mark(fanotify_fd, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, events, it->second.mountFd, nullptr) < 0)
+        log_debug("Error removing fanotify mark: %s\n", mt_strerror(errno).c_str());
+    close(it->second.mountFd);
+    filesystems.erase(it);
+}
+
+String Fanotify::resolveHandle(uint64_t fsid, struct file_handle* handle)
+{
+    int fd;
+    {
+        AutoLock lock(mutex);
+        auto it = filesystems.find(fsid);
+        if (it == filesystems.end())
+            return nullptr;
+        fd = open_by_handle_at(it->second.mountFd, handle, O_PATH | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        // ESTALE: the directory was removed before we got to the event
+        if (errno == EPERM) {
+            if (!permissionDenied)
+                log_warning("Fanotify: can not resolve file handles (requires CAP_DAC_READ_SEARCH)\n");
+            permissionDenied = true;
+        }
+        else if (errno != ESTALE)
+            log_debug("open_by_handle_at failed: %s\n", mt_strerror(errno).c_str());
+        return nullptr;
+    }
+
+    char procPath[64];
+    char dirPath[PATH_MAX];
+    snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", fd);
+    ssize_t len = readlink(procPath, dirPath, sizeof(dirPath) - 1);
+    close(fd);
+    if (len <= 0)
+        return nullptr;
+    return String(dirPath, len);
+}
+
+String Fanotify::nextEvent(uint64_t* mask)
+{
+    while (true) {
+        if (bufferOffset >= bufferLength) {
+            struct pollfd fds[2];
+            fds[0].fd = fanotify_fd;
+            fds[0].events = POLLIN;
+            fds[1].fd = stop_fd_read;
+            fds[1].events = POLLIN;
+
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                log_error("Fanotify: poll failed: %s\n", mt_strerror(errno).c_str());
+                readErrors++;
+                return nullptr;
+            }
+
+            if (fds[1].revents & POLLIN) {
+                char buf;
+                if (read(stop_fd_read, &buf, 1) == -1) {
+                    log_error("Fanotify: could not read stop: %s\n",
+                        mt_strerror(errno).c_str());
+                }
+                return nullptr;
+            }
+
+            if (!(fds[0].revents & POLLIN))
+                continue;
+
+            bufferLength = read(fanotify_fd, buffer, sizeof(buffer));
+            bufferOffset = 0;
+            if (bufferLength <= 0) {
+                bufferLength = 0;
+                if (errno == EINTR || errno == EAGAIN)
+                    continue;
+                log_error("Fanotify: read failed: %s\n", mt_strerror(errno).c_str());
+                readErrors++;
+                return nullptr;
+            }
+            readErrors = 0;
+        }
+
+        auto* meta = (struct fanotify_event_metadata*)(buffer + bufferOffset);
+        ssize_t remaining = bufferLength - bufferOffset;
+        if (!FAN_EVENT_OK(meta, remaining)) {
+            bufferOffset = bufferLength;
+            continue;
+        }
+        bufferOffset += meta->event_len;
+
+        if (meta->vers != FANOTIFY_METADATA_VERSION) {
+            log_error("Fanotify: unexpected metadata version %d\n", meta->vers);
+            continue;
+        }
+
+        if (meta->mask & FAN_Q_OVERFLOW) {
+            *mask = FAN_Q_OVERFLOW;
+            return _("");
+        }
+
+        auto* fid = (struct fanotify_event_info_fid*)(meta + 1);
+        if ((char*)fid >= (char*)meta + meta->event_len
+            || fid->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME)
+            continue;
+
+        auto* handle = (struct file_handle*)fid->handle;
+        const char* name = (const char*)(handle->f_handle + handle->handle_bytes);
+        uint64_t fsid = ((uint64_t)(uint32_t)fid->fsid.val[0] << 32) | (uint32_t)fid->fsid.val[1];
+
+        String dir = resolveHandle(fsid, handle);
+        if (dir == nullptr) {
+            if (permissionDenied) {
+                *mask = 0;
+                return _("");
+            }
+            continue;
+        }
+
+        *mask = meta->mask;
+        if (name[0] == '.' && name[1] == 0)
+            return dir;
+        return dir + DIR_SEPARATOR + name;
+    }
+}
+
+void Fanotify::stop()
+{
+    char stop = 's';
+    if (write(stop_fd_write, &stop, 1) == -1) {
+        log_error("Fanotify: could not send stop: %s\n",
+            mt_strerror(errno).c_str());
+    }
+}
+
+#endif // HAVE_FANOTIFY
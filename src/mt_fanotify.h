@@ -0,0 +1,124 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    mt_fanotify.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file mt_fanotify.h
+
+#ifndef __MT_FANOTIFY_H__
+#define __MT_FANOTIFY_H__
+
+#ifdef HAVE_FANOTIFY
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sys/fanotify.h>
+
+#include "zmm/zmmf.h"
+
+/// \brief Fanotify interface.
+///
+/// Uses filesystem marks with FAN_REPORT_DFID_NAME, a single mark reports
+/// directory entry changes for a whole filesystem, so no per-directory
+/// registration is necessary. Requires CAP_SYS_ADMIN for the marks and
+/// CAP_DAC_READ_SEARCH to resolve the reported directory handles.
+class Fanotify : public zmm::Object
+{
+public:
+    Fanotify();
+    virtual ~Fanotify();
+
+    /// \brief Marks the filesystem that contains the given path.
+    ///
+    /// Marks are reference counted per filesystem.
+    /// \param path directory on the filesystem to monitor
+    /// \param events fanotify event mask
+    /// \return false if the filesystem could not be marked
+    bool addMark(zmm::String path, uint64_t events);
+
+    /// \brief Drops a reference to the filesystem mark of the given path
+    void removeMark(zmm::String path, uint64_t events);
+
+    /// \brief Returns the next fanotify event.
+    ///
+    /// Blocks until an event occurs or the stop function is called.
+    /// Events that can not be resolved to a path (i.e. the parent directory
+    /// is already gone) are skipped.
+    /// \param mask set to the fanotify event mask
+    /// \return full path of the affected entry, an empty string if the
+    /// event queue overflowed (mask is FAN_Q_OVERFLOW) or handles can not
+    /// be resolved for lack of permission (mask is 0), nullptr if stopped
+    zmm::String nextEvent(uint64_t* mask);
+
+    /// \brief Unblock the nextEvent function.
+    void stop();
+
+    /// \brief Number of failed reads since the last successful one,
+    /// nextEvent returns nullptr after each of them.
+    inline int getReadErrors() { return readErrors; }
+
+    /// \brief Reports unresolvable handles again after a fallback.
+    inline void clearPermissionDenied() { permissionDenied = false; }
+
+    /// \brief Checks if fanotify with directory entry events is supported
+    /// and handles on the filesystem of path can be resolved.
+    static bool supported(zmm::String path);
+
+private:
+    int fanotify_fd;
+    int stop_fd_read;
+    int stop_fd_write;
+
+    char buffer[8192];
+    ssize_t bufferLength;
+    ssize_t bufferOffset;
+
+    /// \brief open_by_handle_at failed with EPERM
+    std::atomic<bool> permissionDenied;
+    int readErrors;
+
+    class Filesystem
+    {
+    public:
+        /// \brief descriptor used to resolve handles of this filesystem
+        int mountFd;
+        int refCount;
+    };
+    /// \brief marked filesystems by fsid
+    std::map<uint64_t, Filesystem> filesystems;
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+
+    bool getFsid(int fd, uint64_t* fsid);
+    zmm::String resolveHandle(uint64_t fsid, struct file_handle* handle);
+};
+
+#endif
+
+#endif // __MT_FANOTIFY_H__
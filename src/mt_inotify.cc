@@ -103,7 +103,7 @@ void Inotify::removeWatch(int wd)
     }
 }
 
-struct inotify_event* Inotify::nextEvent()
+struct inotify_event* Inotify::nextEvent(int timeout)
 {
     static struct inotify_event event[MAX_EVENTS];
     static struct inotify_event* ret;
@@ -135,7 +135,7 @@ struct inotify_event* Inotify::nextEvent()
             // how much of the event do we have?
             bytes = (char*)&event[0] + bytes - (char*)ret;
             memcpy(&event[0], ret, bytes);
-            return nextEvent();
+            return nextEvent(timeout);
         }
         return ret;
 
@@ -161,8 +161,14 @@ struct inotify_event* Inotify::nextEvent()
     if (stop_fd_read > fd_max)
         fd_max = stop_fd_read;
 
+    struct timeval tv;
+    if (timeout >= 0) {
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+    }
+
     rc = select(fd_max + 1, &read_fds,
-        nullptr, nullptr, nullptr);
+        nullptr, nullptr, (timeout >= 0) ? &tv : nullptr);
     if (rc < 0) {
         return nullptr;
     } else if (rc == 0) {
@@ -60,7 +60,11 @@ public:
     /// This function will return the next inotify event that occurs, in case
     /// that there are no events the function will block indefinetely. It can
     /// be unblocked by the stop function.
-    struct inotify_event * nextEvent();
+    ///
+    /// \param timeout maximum time to wait in milliseconds, a negative
+    /// value blocks until an event arrives or stop() is called
+    /// \return the event or nullptr on timeout, stop or error
+    struct inotify_event * nextEvent(int timeout = -1);
 
     /// \brief Unblock the next_event function.
     void stop();
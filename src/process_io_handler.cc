@@ -138,6 +138,7 @@ ProcessIOHandler::ProcessIOHandler(String filename,
     this->proclist = proclist;
     this->main_proc = main_proc;
     this->ignore_seek = ignoreSeek;
+    this->short_reads = false;
 
     if ((main_proc != nullptr) && ((!main_proc->isAlive() || abort())))
     {
@@ -270,7 +271,9 @@ int ProcessIOHandler::read(OUT char *buf, IN size_t length)
             num_bytes = num_bytes + bytes_read;
             length = length - bytes_read;
 
-            if (length <= 0)
+            // hand out what the fifo had instead of waiting for the rest
+            // of the chunk, the reactor in front of us asks again anyway
+            if (length <= 0 || short_reads)
                 break;
 
             p_buffer = buf + num_bytes;
@@ -449,6 +452,16 @@ void ProcessIOHandler::close()
         throw _Exception(_("failed to kill process!"));
 }
 
+int ProcessIOHandler::getPollFd()
+{
+    return fd;
+}
+
+void ProcessIOHandler::setShortReads(bool shortReads)
+{
+    short_reads = shortReads;
+}
+
 ProcessIOHandler::~ProcessIOHandler()
 {
     try
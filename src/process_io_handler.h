@@ -90,6 +90,11 @@ public:
     /// \brief Close a previously opened file and kills the kill_pid process
     virtual void close();
 
+    /// \brief Returns the descriptor of the fifo.
+    virtual int getPollFd();
+
+    virtual void setShortReads(bool shortReads);
+
     ~ProcessIOHandler();
 
 protected:
@@ -108,6 +113,9 @@ protected:
     /// \brief if this flag is set seek on a fifo will not return an error
     bool ignore_seek;
 
+    /// \brief if this flag is set read() returns whatever the fifo had
+    bool short_reads;
+
 
     bool abort();
     void killall();
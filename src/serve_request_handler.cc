@@ -32,6 +32,7 @@
 #include <sys/stat.h>
 
 #include "server.h"
+#include "content_manager.h"
 #include "file_io_handler.h"
 #include "serve_request_handler.h"
 
@@ -82,30 +83,9 @@ void ServeRequestHandler::get_info(IN const char *filename, OUT UpnpFileInfo *in
     {
         String mimetype = _(MIMETYPE_DEFAULT);
 #ifdef HAVE_MAGIC
-        magic_set *ms = nullptr;
-        ms = magic_open(MAGIC_MIME);
-        if (ms != nullptr)
-        {
-            if (magic_load(ms, nullptr) == -1)
-            {
-                log_warning("magic_load: %s\n", magic_error(ms));
-                magic_close(ms);
-                ms = nullptr;
-            } 
-            else
-            {
-                /// \TODO we could request the mimetype rex from content manager
-                Ref<RExp> reMimetype;
-                reMimetype = Ref<RExp>(new RExp());
-                reMimetype->compile(_(MIMETYPE_REGEXP));
-
-                String mime = get_mime_type(ms, reMimetype, path);
-                if (string_ok(mime))
-                    mimetype = mime;
-
-                magic_close(ms);
-            }
-        }
+        String mime = ContentManager::getInstance()->getMimeTypeFromFile(path, true);
+        if (string_ok(mime))
+            mimetype = mime;
 #endif // HAVE_MAGIC
 
         UpnpFileInfo_set_FileLength(info, statbuf.st_size);
@@ -171,30 +151,9 @@ Ref<IOHandler> ServeRequestHandler::open(IN const char *filename,
     {
         String mimetype = _(MIMETYPE_DEFAULT);
 #ifdef HAVE_MAGIC
-        magic_set *ms = nullptr;
-        ms = magic_open(MAGIC_MIME);
-        if (ms != nullptr)
-        {
-            if (magic_load(ms, nullptr) == -1)
-            {
-                log_warning("magic_load: %s\n", magic_error(ms));
-                magic_close(ms);
-                ms = nullptr;
-            }
-            else
-            {
-                /// \TODO we could request the mimetype rex from content manager
-                Ref<RExp> reMimetype;
-                reMimetype = Ref<RExp>(new RExp());
-                reMimetype->compile(_(MIMETYPE_REGEXP));
-
-                String mime = get_mime_type(ms, reMimetype, path);
-                if (string_ok(mime))
-                    mimetype = mime;
-
-                magic_close(ms);
-            }
-        }
+        String mime = ContentManager::getInstance()->getMimeTypeFromFile(path, true);
+        if (string_ok(mime))
+            mimetype = mime;
 #endif // HAVE_MAGIC
 
 		// FIXME upstream headers
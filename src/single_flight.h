@@ -0,0 +1,148 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    single_flight.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file single_flight.h
+
+#ifndef __SINGLE_FLIGHT_H__
+#define __SINGLE_FLIGHT_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/// \brief Lets concurrent identical calls share one execution.
+///
+/// The first caller for a key runs the function, callers arriving while
+/// it runs wait for it and get a copy of its result, or the exception it
+/// threw. Copies are made by the executing caller before the waiters
+/// wake up, so it may modify its own result right away.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class SingleFlight
+{
+public:
+    SingleFlight()
+        : executed(0)
+        , coalesced(0)
+    {
+    }
+
+    Value run(const Key& key, const std::function<Value()>& fn,
+        const std::function<Value(const Value&)>& copy)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = calls.find(key);
+        if (it != calls.end()) {
+            std::shared_ptr<Call> call = it->second;
+            call->waiters++;
+            coalesced++;
+            cond.wait(lock, [&call] { return call->done; });
+            if (call->error)
+                std::rethrow_exception(call->error);
+            Value value = call->results.back();
+            call->results.pop_back();
+            return value;
+        }
+
+        auto call = std::make_shared<Call>();
+        calls[key] = call;
+        executed++;
+        lock.unlock();
+
+        Value value;
+        std::exception_ptr error;
+        try {
+            value = fn();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        // no one can join from here on
+        lock.lock();
+        it = calls.find(key);
+        if (it != calls.end() && it->second == call)
+            calls.erase(it);
+        int waiters = call->waiters;
+        lock.unlock();
+
+        std::vector<Value> results;
+        if (!error && waiters > 0) {
+            try {
+                for (int i = 0; i < waiters; i++)
+                    results.push_back(copy(value));
+            } catch (...) {
+                call->error = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        if (error)
+            call->error = error;
+        call->results = std::move(results);
+        call->done = true;
+        lock.unlock();
+        cond.notify_all();
+
+        if (error)
+            std::rethrow_exception(error);
+        return value;
+    }
+
+    /// \brief Makes later callers start a new execution instead of joining
+    /// the ones in flight, for when the underlying data changed.
+    void detach()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        calls.clear();
+    }
+
+    inline long getExecuted() { return executed; }
+    inline long getCoalesced() { return coalesced; }
+
+protected:
+    struct Call {
+        int waiters = 0;
+        bool done = false;
+        std::vector<Value> results;
+        std::exception_ptr error;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::unordered_map<Key, std::shared_ptr<Call>, Hash> calls;
+
+    std::atomic<long> executed;
+    std::atomic<long> coalesced;
+};
+
+#endif // __SINGLE_FLIGHT_H__
@@ -36,7 +36,7 @@
 #include "zmm/zmmf.h"
 #include "exceptions.h"
 
-#define SINGLETON_CUR_MAX 15
+#define SINGLETON_CUR_MAX 20
 
 template <class T, class MutexT = std::mutex> class Singleton;
 
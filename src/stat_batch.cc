@@ -0,0 +1,233 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    stat_batch.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file stat_batch.cc
+
+#include "stat_batch.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef HAVE_IOURING
+#include <chrono>
+#include <sys/sysmacros.h>
+#include <thread>
+#endif
+
+#include "tools.h"
+
+using namespace zmm;
+
+StatBatch::StatBatch(unsigned int queueDepth)
+{
+#ifdef HAVE_IOURING
+    this->queueDepth = queueDepth;
+    ringReady = false;
+    if (queueDepth > 0) {
+        int ret = io_uring_queue_init(queueDepth, &ring, 0);
+        if (ret < 0)
+            log_warning("Could not set up io_uring (%s), falling back to synchronous stat\n", mt_strerror(-ret).c_str());
+        else
+            ringReady = true;
+    }
+#endif
+}
+
+StatBatch::~StatBatch()
+{
+#ifdef HAVE_IOURING
+    if (ringReady)
+        io_uring_queue_exit(&ring);
+#endif
+}
+
+std::vector<DirEntry> StatBatch::scan(DIR* dir, bool hidden)
+{
+    std::vector<DirEntry> entries;
+    struct dirent* dent;
+
+    while ((dent = readdir(dir)) != nullptr) {
+        char* name = dent->d_name;
+        if (name[0] == '.') {
+            if (name[1] == 0) {
+                continue;
+            } else if (name[1] == '.' && name[2] == 0) {
+                continue;
+            } else if (!hidden) {
+                continue;
+            }
+        }
+
+        DirEntry entry;
+        entry.name = name;
+        entry.type = dent->d_type;
+        entry.error = 0;
+        if (entry.type == DT_DIR) {
+            memset(&entry.statbuf, 0, sizeof(entry.statbuf));
+            entry.statbuf.st_mode = S_IFDIR;
+        }
+        entries.push_back(entry);
+    }
+
+    int dirFd = dirfd(dir);
+
+#ifdef HAVE_IOURING
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ringReady) {
+            statUring(dirFd, entries);
+            return entries;
+        }
+    }
+#endif
+
+    for (auto& entry : entries) {
+        if (entry.type != DT_DIR)
+            statSync(dirFd, entry);
+    }
+    return entries;
+}
+
+void StatBatch::statSync(int dirFd, DirEntry& entry)
+{
+    if (fstatat(dirFd, entry.name.c_str(), &entry.statbuf, 0) != 0)
+        entry.error = errno;
+    else
+        entry.error = 0;
+}
+
+#ifdef HAVE_IOURING
+static void statxToStat(const struct statx* stx, struct stat* statbuf)
+{
+    memset(statbuf, 0, sizeof(struct stat));
+    statbuf->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+    statbuf->st_ino = stx->stx_ino;
+    statbuf->st_mode = stx->stx_mode;
+    statbuf->st_nlink = stx->stx_nlink;
+    statbuf->st_uid = stx->stx_uid;
+    statbuf->st_gid = stx->stx_gid;
+    statbuf->st_rdev = makedev(stx->stx_rdev_major, stx->stx_rdev_minor);
+    statbuf->st_size = stx->stx_size;
+    statbuf->st_blksize = stx->stx_blksize;
+    statbuf->st_blocks = stx->stx_blocks;
+    statbuf->st_atim.tv_sec = stx->stx_atime.tv_sec;
+    statbuf->st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+    statbuf->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+    statbuf->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+    statbuf->st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+    statbuf->st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+}
+
+void StatBatch::statUring(int dirFd, std::vector<DirEntry>& entries)
+{
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].type != DT_DIR)
+            pending.push_back(i);
+    }
+
+    std::vector<struct statx> results(queueDepth);
+
+    for (size_t start = 0; start < pending.size(); start += queueDepth) {
+        size_t count = std::min(static_cast<size_t>(queueDepth), pending.size() - start);
+
+        if (!ringReady) {
+            for (size_t j = 0; j < count; j++)
+                statSync(dirFd, entries[pending[start + j]]);
+            continue;
+        }
+
+        for (size_t j = 0; j < count; j++) {
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            io_uring_prep_statx(sqe, dirFd, entries[pending[start + j]].name.c_str(),
+                0, STATX_BASIC_STATS, &results[j]);
+            io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(j));
+        }
+
+        // the kernel may take fewer requests than queued, the rest stays
+        // in the submission queue and goes with the next call
+        size_t submitted = 0;
+        int ret = 0;
+        while (submitted < count) {
+            ret = io_uring_submit(&ring);
+            if (ret == -EINTR || ret == -EAGAIN)
+                continue;
+            if (ret <= 0)
+                break;
+            submitted += ret;
+        }
+        if (submitted < count) {
+            log_warning("io_uring submit failed (%s), falling back to synchronous stat\n", mt_strerror(-ret).c_str());
+            ringReady = false;
+        }
+
+        // every submitted request points into results and entries, all of
+        // them are reaped before the ring goes away or we return
+        std::vector<bool> completed(count, false);
+        size_t done = 0;
+        while (done < submitted) {
+            struct io_uring_cqe* cqe;
+            ret = io_uring_wait_cqe(&ring, &cqe);
+            if (ret < 0) {
+                if (ret != -EINTR) {
+                    log_debug("io_uring wait failed (%s), retrying\n", mt_strerror(-ret).c_str());
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                continue;
+            }
+            done++;
+
+            size_t j = reinterpret_cast<size_t>(io_uring_cqe_get_data(cqe));
+            completed[j] = true;
+            DirEntry& entry = entries[pending[start + j]];
+            if (cqe->res == 0) {
+                statxToStat(&results[j], &entry.statbuf);
+                entry.error = 0;
+            } else {
+                // kernels without IORING_OP_STATX answer with EINVAL,
+                // everything else is retried to get the proper errno
+                if (cqe->res == -EINVAL && ringReady) {
+                    log_debug("io_uring does not support statx, falling back to synchronous stat\n");
+                    ringReady = false;
+                }
+                statSync(dirFd, entry);
+            }
+            io_uring_cqe_seen(&ring, cqe);
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            if (!completed[k])
+                statSync(dirFd, entries[pending[start + k]]);
+        }
+
+        if (!ringReady)
+            io_uring_queue_exit(&ring);
+    }
+}
+#endif
@@ -0,0 +1,97 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    stat_batch.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+
+/// \file stat_batch.h
+/// \brief Definition of the StatBatch class.
+
+#ifndef __STAT_BATCH_H__
+#define __STAT_BATCH_H__
+
+#include <dirent.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <vector>
+
+#ifdef HAVE_IOURING
+#include <liburing.h>
+#endif
+
+#include "zmm/zmmf.h"
+
+/// \brief A directory entry together with its stat result.
+class DirEntry
+{
+public:
+    zmm::String name;
+    /// \brief d_type as reported by readdir
+    unsigned char type;
+    struct stat statbuf;
+    /// \brief errno of the failed stat, 0 on success
+    int error;
+};
+
+/// \brief Reads a directory and stats all of its entries in one go.
+///
+/// With io_uring support the statx calls of a directory are submitted in
+/// batches of up to queueDepth requests, so on network filesystems the
+/// round trips overlap instead of being paid one after the other. Without
+/// io_uring, or if the ring can not be set up, each entry gets a
+/// synchronous fstatat() relative to the directory. Entries reported as
+/// directories by d_type are never stat'ed, only st_mode is set, see
+/// stat_dir_entry().
+class StatBatch
+{
+public:
+    /// \param queueDepth maximum number of requests in flight, 0 disables io_uring
+    StatBatch(unsigned int queueDepth);
+    ~StatBatch();
+
+    /// \brief Reads all entries of the directory stream and stats them.
+    /// \param dir directory stream, stays open
+    /// \param hidden include entries starting with a dot
+    /// \return the entries in readdir order, "." and ".." are skipped
+    std::vector<DirEntry> scan(DIR* dir, bool hidden);
+
+protected:
+    void statSync(int dirFd, DirEntry& entry);
+
+#ifdef HAVE_IOURING
+    struct io_uring ring;
+    bool ringReady;
+    unsigned int queueDepth;
+    /// \brief the ring is not thread safe
+    std::mutex mutex;
+
+    /// \brief Stats all non-directory entries, falls back to statSync()
+    /// for entries the ring could not handle.
+    void statUring(int dirFd, std::vector<DirEntry>& entries);
+#endif
+};
+
+#endif // __STAT_BATCH_H__
@@ -169,7 +169,19 @@ public:
     virtual zmm::Ref<CdsObject> loadObject(int objectID) = 0;
     virtual int getChildCount(int contId, bool containers = true, bool items = true, bool hideFsRoot = false) = 0;
 
-    virtual zmm::String findFolderImage(int id, zmm::String trackArtBase) = 0;
+    /// \brief Returns the folder image of a container.
+    ///
+    /// The association is made when the image or the items are added and
+    /// kept in memory, so rendering needs no database access.
+    /// \return object ID of the image or INVALID_OBJECT_ID
+    virtual int getFolderArt(int containerID) = 0;
+
+    /// \brief Returns the image named after a track, <title>.jpg next to
+    /// the track or next to the track a virtual container refers to.
+    /// \param containerID parent of the track
+    /// \param trackArtBase lowercase title of the track without extension
+    /// \return object ID of the image or INVALID_OBJECT_ID
+    virtual int getTrackArt(int containerID, zmm::String trackArtBase) = 0;
 
     
     class ChangedContainers : public Object
@@ -218,6 +230,11 @@ public:
     
     /* accounting methods */
     virtual int getTotalFiles() = 0;
+
+    /// \brief Returns how many loadObject and browse queries were run and
+    /// how many calls waited for an identical query in flight instead.
+    virtual void getQueryStats(long* loadQueries, long* loadCoalesced,
+        long* browseQueries, long* browseCoalesced) = 0;
     
     /* internal setting methods */
     virtual zmm::String getInternalSetting(zmm::String key) = 0;
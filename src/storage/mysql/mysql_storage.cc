@@ -61,6 +61,14 @@
 #define MYSQL_UPDATE_3_4_2 "ALTER TABLE `mt_cds_object` ADD KEY `cds_object_service_id` (`service_id`)"
 #define MYSQL_UPDATE_3_4_3 "UPDATE `mt_internal_setting` SET `value`='4' WHERE `key`='db_version' AND `value`='3'"
 
+// updates 4->5
+#define MYSQL_UPDATE_4_5_1 "ALTER TABLE `mt_cds_object` ADD `art_object_id` int(11) default NULL"
+#define MYSQL_UPDATE_4_5_2 "ALTER TABLE `mt_cds_object` ADD KEY `cds_object_art_object_id` (`art_object_id`)"
+#define MYSQL_UPDATE_4_5_3 "UPDATE `mt_cds_object` `c` JOIN `mt_cds_object` `i` ON `i`.`parent_id`=`c`.`id` SET `c`.`art_object_id`=`i`.`id` WHERE `c`.`object_type`=1 AND `i`.`upnp_class`='object.item.imageItem' AND (`i`.`dc_title` LIKE 'cover.jp%' OR `i`.`dc_title` LIKE 'albumart%.jp%' OR `i`.`dc_title` LIKE 'album.jp%' OR `i`.`dc_title` LIKE 'front.jp%' OR `i`.`dc_title` LIKE 'folder.jp%')"
+#define MYSQL_UPDATE_4_5_4 "UPDATE `mt_cds_object` `c` JOIN `mt_cds_object` `v` ON `v`.`parent_id`=`c`.`id` JOIN `mt_cds_object` `r` ON `r`.`id`=`v`.`ref_id` JOIN `mt_cds_object` `f` ON `f`.`id`=`r`.`parent_id` SET `c`.`art_object_id`=`f`.`art_object_id` WHERE `c`.`art_object_id` IS NULL AND `f`.`art_object_id` IS NOT NULL"
+#define MYSQL_UPDATE_4_5_5 "INSERT INTO `mt_internal_setting` VALUES('album_art_upgrade', 'pending')"
+#define MYSQL_UPDATE_4_5_6 "UPDATE `mt_internal_setting` SET `value`='5' WHERE `key`='db_version' AND `value`='4'"
+
 using namespace zmm;
 using namespace mxml;
 using namespace std;
@@ -250,9 +258,21 @@ void MysqlStorage::init()
         dbVersion = _("4");
     }
 
+    if (dbVersion == "4") {
+        log_info("Doing an automatic database upgrade from database version 4 to version 5...\n");
+        _exec(MYSQL_UPDATE_4_5_1);
+        _exec(MYSQL_UPDATE_4_5_2);
+        _exec(MYSQL_UPDATE_4_5_3);
+        _exec(MYSQL_UPDATE_4_5_4);
+        _exec(MYSQL_UPDATE_4_5_5);
+        _exec(MYSQL_UPDATE_4_5_6);
+        log_info("database upgrade successful.\n");
+        dbVersion = _("5");
+    }
+
     /* --- --- ---*/
 
-    if (!string_ok(dbVersion) || dbVersion != "4")
+    if (!string_ok(dbVersion) || dbVersion != "5")
         throw _Exception(_("The database seems to be from a newer version (database version ") + dbVersion + ")!");
 
     lock.unlock();
@@ -31,7 +31,9 @@
 
 #include "sql_storage.h"
 #include "config_manager.h"
+#include "didl_fragment_store.h"
 #include "filesystem.h"
+#include "metadata_handler.h"
 #include "string_converter.h"
 #include "tools.h"
 #include "update_manager.h"
@@ -42,6 +44,7 @@ using namespace std;
 
 #define MAX_REMOVE_SIZE 10000
 #define MAX_REMOVE_RECURSION 500
+#define UPDATE_ID_FLUSH_BATCH 500
 
 #define SQL_NULL "NULL"
 
@@ -64,6 +67,7 @@ enum {
     _flags,
     _track_number,
     _service_id,
+    _art_object_id,
     _ref_upnp_class,
     _ref_location,
     _ref_metadata,
@@ -103,6 +107,7 @@ enum {
     SEL_EQ_SP_FQ_DT_BQ "flags" \
     SEL_EQ_SP_FQ_DT_BQ "track_number" \
     SEL_EQ_SP_FQ_DT_BQ "service_id" \
+    SEL_EQ_SP_FQ_DT_BQ "art_object_id" \
     SEL_EQ_SP_RFQ_DT_BQ "upnp_class" \
     SEL_EQ_SP_RFQ_DT_BQ "location" \
     SEL_EQ_SP_RFQ_DT_BQ "metadata" \
@@ -123,8 +128,23 @@ enum {
 
 /* enum for createObjectFromRow's mode parameter */
 
+/// \brief copy of a loaded object for a caller that shared the query
+static Ref<CdsObject> cloneObject(Ref<CdsObject> obj)
+{
+    Ref<CdsObject> copy = CdsObject::createObject(obj->getObjectType());
+    obj->copyTo(copy);
+    if (IS_CDS_CONTAINER(obj->getObjectType())) {
+        Ref<CdsContainer> cont = RefCast(obj, CdsContainer);
+        Ref<CdsContainer> contCopy = RefCast(copy, CdsContainer);
+        contCopy->setChildCount(cont->getChildCount());
+        contCopy->setAutoscanType(cont->getAutoscanType());
+    }
+    return copy;
+}
+
 SQLStorage::SQLStorage()
     : Storage()
+    , updateIDWriter(this)
 {
     table_quote_begin = '\0';
     table_quote_end = '\0';
@@ -179,11 +199,35 @@ void SQLStorage::init()
 void SQLStorage::dbReady()
 {
     loadLastID();
+    loadFolderArt();
+    loadTrackArt();
+    String albumArtUpgrade = getInternalSetting(_("album_art_upgrade"));
+    if (string_ok(albumArtUpgrade) && albumArtUpgrade == "pending") {
+        upgradeAlbumArt();
+        storeInternalSetting(_("album_art_upgrade"), _("done"));
+    }
+    loadUpdateIDs();
+    Timer::getInstance()->addTimerSubscriber(&updateIDWriter,
+        ConfigManager::getInstance()->getIntOption(CFG_SERVER_STORAGE_UPDATE_ID_FLUSH_INTERVAL));
+}
+
+void SQLStorage::getQueryStats(long* loadQueries, long* loadCoalesced,
+    long* browseQueries, long* browseCoalesced)
+{
+    *loadQueries = loadFlight.getExecuted();
+    *loadCoalesced = loadFlight.getCoalesced();
+    *browseQueries = browseFlight.getExecuted();
+    *browseCoalesced = browseFlight.getCoalesced();
 }
 
 void SQLStorage::shutdown()
 {
+    log_info("loadObject queries: %ld, coalesced: %ld; browse queries: %ld, coalesced: %ld\n",
+        loadFlight.getExecuted(), loadFlight.getCoalesced(),
+        browseFlight.getExecuted(), browseFlight.getCoalesced());
+    Timer::getInstance()->removeTimerSubscriber(&updateIDWriter, nullptr, true);
     flushInsertBuffer();
+    flushUpdateIDs();
     shutdownDriver();
 }
 
@@ -459,6 +503,9 @@ void SQLStorage::addObject(Ref<CdsObject> obj, int* changedContainer)
             addToInsertBuffer(qb);
     }
 
+    if (IS_CDS_CONTAINER(obj->getObjectType()))
+        seedUpdateID(obj->getID());
+
     /* add to cache */
     if (cacheOn()) {
         AutoLock lock(cache->getMutex());
@@ -468,6 +515,8 @@ void SQLStorage::addObject(Ref<CdsObject> obj, int* changedContainer)
         addObjectToCache(obj, true);
     }
     /* ------------ */
+
+    _updateContainerArt(obj);
 }
 
 void SQLStorage::updateObject(zmm::Ref<CdsObject> obj, int* changedContainer)
@@ -515,6 +564,8 @@ void SQLStorage::updateObject(zmm::Ref<CdsObject> obj, int* changedContainer)
     /* add to cache */
     addObjectToCache(obj);
     /* ------------ */
+
+    DidlFragmentStore::getInstance()->invalidate(obj->getID());
 }
 
 Ref<CdsObject> SQLStorage::loadObject(int objectID)
@@ -537,6 +588,13 @@ Ref<CdsObject> SQLStorage::loadObject(int objectID)
         return obj;
     throw _Exception(_("Object not found: ") + objectID);
 */
+    return loadFlight.run(objectID, [this, objectID]() {
+        return _loadObject(objectID);
+    }, cloneObject);
+}
+
+Ref<CdsObject> SQLStorage::_loadObject(int objectID)
+{
     Ref<StringBuffer> qb(new StringBuffer());
 
     //log_debug("sql_query = %s\n",sql_query.c_str());
@@ -590,6 +648,29 @@ Ref<IntArray> SQLStorage::getServiceObjectIDs(char servicePrefix)
 }
 
 Ref<Array<CdsObject>> SQLStorage::browse(Ref<BrowseParam> param)
+{
+    string key = to_string(param->getObjectID()) + ':' + to_string(param->getFlags()) + ':'
+        + to_string(param->getStartingIndex()) + ':' + to_string(param->getRequestedCount());
+
+    BrowseRows rows = browseFlight.run(key, [this, param]() {
+        BrowseRows rows;
+        rows.objects = _browse(param);
+        rows.totalMatches = param->getTotalMatches();
+        return rows;
+    }, [](const BrowseRows& rows) {
+        BrowseRows copy;
+        copy.totalMatches = rows.totalMatches;
+        copy.objects = Ref<Array<CdsObject>>(new Array<CdsObject>(rows.objects->size()));
+        for (int i = 0; i < rows.objects->size(); i++)
+            copy.objects->append(cloneObject(rows.objects->get(i)));
+        return copy;
+    });
+
+    param->setTotalMatches(rows.totalMatches);
+    return rows.objects;
+}
+
+Ref<Array<CdsObject>> SQLStorage::_browse(Ref<BrowseParam> param)
 {
     flushInsertBuffer();
 
@@ -941,6 +1022,7 @@ int SQLStorage::createContainer(int parentID, String name, String path, bool isV
         << ')';
 
     exec(qb);
+    seedUpdateID(newID);
 
     /* inform cache */
     if (cacheOn()) {
@@ -1089,7 +1171,11 @@ Ref<CdsObject> SQLStorage::createObjectFromRow(Ref<SQLRow> row)
 
     if (IS_CDS_CONTAINER(objectType)) {
         Ref<CdsContainer> cont = RefCast(obj, CdsContainer);
-        cont->setUpdateID(row->col(_update_id).toInt());
+        {
+            AutoLock lock(updateIDMutex);
+            auto it = updateIDs.find(cont->getID());
+            cont->setUpdateID(it != updateIDs.end() ? it->second : row->col(_update_id).toInt());
+        }
         char locationPrefix;
         cont->setLocation(stripLocationPrefix(&locationPrefix, row->col(_location)));
         if (locationPrefix == LOC_VIRT_PREFIX)
@@ -1103,6 +1189,10 @@ Ref<CdsObject> SQLStorage::createObjectFromRow(Ref<SQLRow> row)
                 cont->setAutoscanType(OBJECT_AUTOSCAN_UI);
         } else
             cont->setAutoscanType(OBJECT_AUTOSCAN_NONE);
+
+        String artObjectID = row->col(_art_object_id);
+        if (string_ok(artObjectID))
+            cont->setArtObjectID(artObjectID.toInt());
         matched_types++;
     }
 
@@ -1178,94 +1268,452 @@ String SQLStorage::incrementUpdateIDs(shared_ptr<unordered_set<int>> ids)
 {
     if (ids->empty())
         return nullptr;
-    Ref<StringBuffer> inBuf(new StringBuffer()); // ??? what was that: size * sizeof(int)));
 
-    bool first = true;
-    for (const auto& id : *ids) {
-        if (first) {
-            *inBuf << "IN (" << id;
-            first = false;
-        } else {
-            *inBuf << ',' << id;
+    vector<int> unknown;
+    {
+        AutoLock lock(updateIDMutex);
+        for (const auto& id : *ids) {
+            if (updateIDs.find(id) == updateIDs.end())
+                unknown.push_back(id);
         }
     }
-    *inBuf << ')';
+
+    // objects added since loadUpdateIDs(), their row is still current
+    if (!unknown.empty()) {
+        Ref<StringBuffer> q(new StringBuffer());
+        *q << "SELECT " << TQ("id") << ',' << TQ("update_id") << " FROM " << TQ(CDS_OBJECT_TABLE)
+           << " WHERE " << TQ("id") << " IN (" << unknown[0];
+        for (size_t i = 1; i < unknown.size(); i++)
+            *q << ',' << unknown[i];
+        *q << ')';
+        Ref<SQLResult> res = select(q);
+        if (res == nullptr)
+            throw _Exception(_("Error while fetching update ids"));
+        Ref<SQLRow> row;
+        AutoLock lock(updateIDMutex);
+        while ((row = res->nextRow()) != nullptr)
+            updateIDs.emplace(row->col(0).toInt(), row->col(1).toInt());
+    }
 
     Ref<StringBuffer> buf(new StringBuffer());
-    *buf << "UPDATE " << TQ(CDS_OBJECT_TABLE) << " SET " << TQ("update_id") << '=' << TQ("update_id") << " + 1 WHERE " << TQ("id") << ' ';
-    *buf << inBuf;
-    exec(buf);
-
-    buf->clear();
-    *buf << "SELECT " << TQ("id") << ',' << TQ("update_id") << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE " << TQ("id") << ' ';
-    *buf << inBuf;
-    Ref<SQLResult> res = select(buf);
+    vector<pair<int, int>> changed;
+    {
+        AutoLock lock(updateIDMutex);
+        for (const auto& id : *ids) {
+            auto it = updateIDs.find(id);
+            if (it == updateIDs.end())
+                continue; // removed meanwhile
+            it->second++;
+            dirtyUpdateIDs.insert(id);
+            changed.emplace_back(id, it->second);
+            *buf << ',' << id << ',' << it->second;
+        }
+    }
+
+    if (cacheOn()) {
+        AutoLock lock(cache->getMutex());
+        for (const auto& entry : changed) {
+            Ref<CacheObject> cObj = cache->getObject(entry.first);
+            if (cObj != nullptr && cObj->knowsObject() && IS_CDS_CONTAINER(cObj->getObject()->getObjectType()))
+                RefCast(cObj->getObject(), CdsContainer)->setUpdateID(entry.second);
+        }
+    }
+
+    if (buf->length() <= 0)
+        return nullptr;
+    return buf->toString(1);
+}
+
+void SQLStorage::seedUpdateID(int id)
+{
+    // new rows start with update_id 0, incrementUpdateIDs() must not have
+    // to ask the database for them
+    AutoLock lock(updateIDMutex);
+    updateIDs.emplace(id, 0);
+}
+
+void SQLStorage::loadUpdateIDs()
+{
+    Ref<StringBuffer> q(new StringBuffer());
+    *q << "SELECT " << TQ("id") << ',' << TQ("update_id") << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("object_type") << '=' << quote(OBJECT_TYPE_CONTAINER);
+    Ref<SQLResult> res = select(q);
     if (res == nullptr)
-        throw _Exception(_("Error while fetching update ids"));
+        throw _Exception(_("could not load the update ids"));
+
+    AutoLock lock(updateIDMutex);
+    updateIDs.clear();
+    dirtyUpdateIDs.clear();
     Ref<SQLRow> row;
-    buf->clear();
     while ((row = res->nextRow()) != nullptr)
-        *buf << ',' << row->col(0) << ',' << row->col(1);
-    if (buf->length() <= 0)
+        updateIDs[row->col(0).toInt()] = row->col(1).toInt();
+    log_debug("%d container update ids loaded\n", (int)updateIDs.size());
+}
+
+void SQLStorage::flushUpdateIDs()
+{
+    AutoLock flushLock(updateIDFlushMutex);
+    vector<pair<int, int>> pending;
+    {
+        AutoLock lock(updateIDMutex);
+        if (dirtyUpdateIDs.empty())
+            return;
+        pending.reserve(dirtyUpdateIDs.size());
+        for (const auto& id : dirtyUpdateIDs) {
+            auto it = updateIDs.find(id);
+            if (it != updateIDs.end())
+                pending.emplace_back(id, it->second);
+        }
+        dirtyUpdateIDs.clear();
+    }
+
+    Ref<StringBuffer> q(new StringBuffer());
+    for (size_t start = 0; start < pending.size(); start += UPDATE_ID_FLUSH_BATCH) {
+        size_t end = std::min(pending.size(), start + UPDATE_ID_FLUSH_BATCH);
+        q->clear();
+        *q << "UPDATE " << TQ(CDS_OBJECT_TABLE) << " SET " << TQ("update_id") << "=CASE " << TQ("id");
+        for (size_t i = start; i < end; i++)
+            *q << " WHEN " << pending[i].first << " THEN " << pending[i].second;
+        *q << " END WHERE " << TQ("id") << " IN (" << pending[start].first;
+        for (size_t i = start + 1; i < end; i++)
+            *q << ',' << pending[i].first;
+        *q << ')';
+        try {
+            exec(q);
+        } catch (const Exception& e) {
+            log_error("could not write %d update ids: %s\n", (int)(pending.size() - start), e.getMessage().c_str());
+            // retry with the next flush
+            AutoLock lock(updateIDMutex);
+            for (size_t i = start; i < pending.size(); i++) {
+                if (updateIDs.find(pending[i].first) != updateIDs.end())
+                    dirtyUpdateIDs.insert(pending[i].first);
+            }
+            return;
+        }
+    }
+    log_debug("wrote %d update ids\n", (int)pending.size());
+}
+
+void SQLStorage::forgetUpdateIDs(const unordered_set<int>& ids)
+{
+    AutoLock lock(updateIDMutex);
+    for (const auto& id : ids) {
+        updateIDs.erase(id);
+        dirtyUpdateIDs.erase(id);
+    }
+}
+
+int SQLStorage::getFolderArt(int containerID)
+{
+    AutoLock lock(folderArtMutex);
+    auto it = folderArt.find(containerID);
+    if (it == folderArt.end())
+        return INVALID_OBJECT_ID;
+    return it->second;
+}
+
+void SQLStorage::loadFolderArt()
+{
+    Ref<StringBuffer> q(new StringBuffer());
+    *q << "SELECT " << TQD('c', "id") << ',' << TQD('c', "art_object_id")
+       << " FROM " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('c')
+       << " JOIN " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('a')
+       << " ON " << TQD('a', "id") << '=' << TQD('c', "art_object_id")
+       << " WHERE " << TQD('a', "upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_IMAGE_ITEM));
+    Ref<SQLResult> res = select(q);
+    if (res == nullptr)
+        throw _Exception(_("could not load the folder art"));
+
+    AutoLock lock(folderArtMutex);
+    folderArt.clear();
+    Ref<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr)
+        folderArt[row->col(0).toInt()] = row->col(1).toInt();
+    log_debug("%d containers with folder art\n", (int)folderArt.size());
+}
+
+int SQLStorage::getTrackArt(int containerID, String trackArtBase)
+{
+    if (!string_ok(trackArtBase))
+        return INVALID_OBJECT_ID;
+    AutoLock lock(folderArtMutex);
+    auto it = trackArt.find(make_pair(containerID, string(trackArtBase.c_str())));
+    if (it == trackArt.end())
+        return INVALID_OBJECT_ID;
+    return it->second;
+}
+
+/// \brief Returns the lowercase name of a .jp* image without extension,
+/// nullptr for other names.
+static String getTrackArtBase(String title)
+{
+    String lower = title.toLower();
+    int dot = lower.rindex('.');
+    if (dot <= 0 || strncmp(lower.c_str() + dot, ".jp", 3) != 0)
         return nullptr;
-    return buf->toString(1);
+    return lower.substring(0, dot);
 }
 
-// id is the parent_id for cover media to find, and if set, trackArtBase is the case-folded
-// name of the track to try as artwork; we rely on LIKE being case-insensitive
-#define MAX_ART_CONTAINERS 100
-String SQLStorage::findFolderImage(int id, String trackArtBase)
+void SQLStorage::loadTrackArt()
 {
+    // the images themselves and the virtual containers holding references
+    // to items of their directory
     Ref<StringBuffer> q(new StringBuffer());
-    // folder.jpg or cover.jpg [and variants]
-    // note - "_" is regexp "." and "%" is regexp ".*" in sql LIKE land
-    *q << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE ";
-    *q << "( ";
-    if (trackArtBase.length() > 0) {
-        *q << TQ("dc_title") << "LIKE " << quote(trackArtBase + _(".jp%")) << " OR ";
-    }
-    *q << TQ("dc_title") << "LIKE " << quote(_("cover.jp%")) << " OR ";
-    *q << TQ("dc_title") << "LIKE " << quote(_("albumart%.jp%")) << " OR ";
-    *q << TQ("dc_title") << "LIKE " << quote(_("album.jp%")) << " OR ";
-    *q << TQ("dc_title") << "LIKE " << quote(_("front.jp%")) << " OR ";
-    *q << TQ("dc_title") << "LIKE " << quote(_("folder.jp%"));
-    *q << " ) AND ";
-    *q << TQ("upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_IMAGE_ITEM)) << " AND ";
-#ifndef ONLY_REAL_FOLDER_ART
-    *q << "( ";
-    *q <<       "( ";
-        // virtual listing via Album, Artist etc
-    *q << TQ("parent_id") << " IN ";
-    *q <<       "(";
-    *q << "SELECT " << TQ("parent_id") << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE ";
-    *q << TQ("upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_MUSIC_TRACK)) << " AND ";
-    *q << TQ("id") << " IN ";
-    *q <<               "(";
-    *q << "SELECT " << TQ("ref_id") << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE ";
-    *q << TQ("parent_id") << '=' << quote(String::from(id)) << " AND ";
-    *q << TQ("object_type") << '=' << quote(OBJECT_TYPE_ITEM);
-    *q <<               " LIMIT " << MAX_ART_CONTAINERS << ")";
-    *q <<       ")";
-    *q << "     ) OR ";
-#endif
-        // straightforward folder listing of real filesystem
-    *q << TQ("parent_id") << '=' << quote(String::from(id));
-#ifndef ONLY_REAL_FOLDER_ART
-    *q << ")";
-#endif
-    *q << " LIMIT 1";
+    *q << "SELECT " << TQ("parent_id") << ',' << TQ("id") << ',' << TQ("dc_title")
+       << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_IMAGE_ITEM))
+       << " AND " << TQ("dc_title") << " LIKE " << quote(_("%.jp%"))
+       << " UNION SELECT " << TQD('v', "parent_id") << ',' << TQD('i', "id") << ',' << TQD('i', "dc_title")
+       << " FROM " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('i')
+       << " JOIN " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('r')
+       << " ON " << TQD('r', "parent_id") << '=' << TQD('i', "parent_id")
+       << " JOIN " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('v')
+       << " ON " << TQD('v', "ref_id") << '=' << TQD('r', "id")
+       << " WHERE " << TQD('i', "upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_IMAGE_ITEM))
+       << " AND " << TQD('i', "dc_title") << " LIKE " << quote(_("%.jp%"))
+       << " AND " << TQD('r', "upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_MUSIC_TRACK));
+    Ref<SQLResult> res = select(q);
+    if (res == nullptr)
+        throw _Exception(_("could not load the track art"));
+
+    AutoLock lock(folderArtMutex);
+    trackArt.clear();
+    Ref<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        String base = getTrackArtBase(row->col(2));
+        if (string_ok(base))
+            trackArt[make_pair(row->col(0).toInt(), string(base.c_str()))] = row->col(1).toInt();
+    }
+    log_debug("%d track art images\n", (int)trackArt.size());
+}
+
+/// \brief Checks if the image title is one of the folder art names
+/// cover, albumart*, album, front or folder .jp*, case insensitive.
+static bool isFolderArtTitle(String title)
+{
+    String lower = title.toLower();
+    const char* t = lower.c_str();
+    if (t == nullptr)
+        return false;
+    if (!strncmp(t, "cover.jp", 8) || !strncmp(t, "album.jp", 8)
+        || !strncmp(t, "front.jp", 8) || !strncmp(t, "folder.jp", 9))
+        return true;
+    return !strncmp(t, "albumart", 8) && strstr(t + 8, ".jp") != nullptr;
+}
+
+/// \brief Checks if the track carries artwork in one of its resources,
+/// the same test the DIDL renderer uses for album containers.
+static bool hasTrackArt(Ref<CdsObject> obj)
+{
+    if (obj->getClass() != UPNP_DEFAULT_CLASS_MUSIC_TRACK)
+        return false;
+    for (int i = 1; i < obj->getResourceCount(); i++) {
+        int handlerType = obj->getResource(i)->getHandlerType();
+        if (handlerType == CH_ID3 || handlerType == CH_MP4 || handlerType == CH_FLAC
+            || handlerType == CH_FANART || handlerType == CH_EXTURL)
+            return true;
+    }
+    return false;
+}
+
+void SQLStorage::_updateContainerArt(Ref<CdsObject> obj)
+{
+    if (!IS_CDS_PURE_ITEM(obj->getObjectType()))
+        return;
+
+    if (obj->isVirtual()) {
+        // reference in a virtual container (Album, Artist, ...), use the
+        // art of the directory holding the referenced item; albums fall
+        // back to the embedded art of the track
+        if (obj->getRefID() <= 0)
+            return;
+        Ref<CdsObject> refObj = loadObject(obj->getRefID());
+
+        // <title>.jpg next to the referenced track
+        String title = obj->getTitle().toLower();
+        int dot = title.rindex('.');
+        if (obj->getClass() == UPNP_DEFAULT_CLASS_MUSIC_TRACK && dot > 0) {
+            String trackArtBase = title.substring(0, dot);
+            int trackArtID = getTrackArt(refObj->getParentID(), trackArtBase);
+            if (trackArtID != INVALID_OBJECT_ID) {
+                Ref<IntArray> containerIDs(new IntArray());
+                containerIDs->append(obj->getParentID());
+                _setTrackArt(containerIDs, trackArtBase, trackArtID);
+            }
+        }
+
+        Ref<StringBuffer> q(new StringBuffer());
+        *q << "SELECT " << TQ("id") << ',' << TQ("art_object_id") << ',' << TQ("upnp_class")
+           << " FROM " << TQ(CDS_OBJECT_TABLE)
+           << " WHERE " << TQ("id") << " IN (" << refObj->getParentID()
+           << ',' << obj->getParentID() << ')';
+        Ref<SQLResult> res = select(q);
+        if (res == nullptr)
+            throw _Exception(_("db error"));
+
+        int artObjectID = INVALID_OBJECT_ID;
+        bool hasArt = false;
+        bool isAlbum = false;
+        Ref<SQLRow> row;
+        while ((row = res->nextRow()) != nullptr) {
+            int id = row->col(0).toInt();
+            String art = row->col(1);
+            if (id == obj->getParentID()) {
+                hasArt = string_ok(art);
+                isAlbum = (row->col(2) == UPNP_DEFAULT_CLASS_MUSIC_ALBUM);
+            } else if (string_ok(art))
+                artObjectID = art.toInt();
+        }
+        if (hasArt)
+            return;
+        if (artObjectID == INVALID_OBJECT_ID && isAlbum && hasTrackArt(refObj))
+            artObjectID = refObj->getID();
+        if (artObjectID == INVALID_OBJECT_ID)
+            return;
+
+        Ref<IntArray> containerIDs(new IntArray());
+        containerIDs->append(obj->getParentID());
+        _setContainerArt(containerIDs, artObjectID, false, artObjectID != refObj->getID());
+        return;
+    }
+
+    if (obj->getClass() != UPNP_DEFAULT_CLASS_IMAGE_ITEM)
+        return;
+    bool folderArtTitle = isFolderArtTitle(obj->getTitle());
+    String trackArtBase = getTrackArtBase(obj->getTitle());
+    if (!folderArtTitle && !string_ok(trackArtBase))
+        return;
 
-    //log_debug("findFolderImage %d, %s\n", id, q->c_str());
+    // the directory itself and all virtual containers that already hold
+    // references to items of the directory
+    flushInsertBuffer();
+    Ref<IntArray> containerIDs(new IntArray());
+    containerIDs->append(obj->getParentID());
+
+    Ref<StringBuffer> q(new StringBuffer());
+    *q << "SELECT DISTINCT " << TQD('v', "parent_id")
+       << " FROM " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('v')
+       << " JOIN " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('r')
+       << " ON " << TQD('r', "id") << '=' << TQD('v', "ref_id")
+       << " WHERE " << TQD('r', "parent_id") << '=' << obj->getParentID();
     Ref<SQLResult> res = select(q);
     if (res == nullptr)
         throw _Exception(_("db error"));
     Ref<SQLRow> row;
-    if ((row = res->nextRow()) != nullptr) // we only care about the first result
+    while ((row = res->nextRow()) != nullptr)
+        containerIDs->append(row->col(0).toInt());
+
+    // any image may be named after a track
+    if (string_ok(trackArtBase))
+        _setTrackArt(containerIDs, trackArtBase, obj->getID());
+
+    if (!folderArtTitle)
+        return;
+
+    log_debug("%s becomes the art of container %d\n", obj->getTitle().c_str(), obj->getParentID());
+
+    // folder images take precedence over art embedded in tracks
+    _setContainerArt(containerIDs, obj->getID(), true, true);
+}
+
+void SQLStorage::_setTrackArt(Ref<IntArray> containerIDs, String trackArtBase, int artObjectID)
+{
+    string base(trackArtBase.c_str());
     {
-        log_debug("findFolderImage result: %s\n", row->col(0).c_str());
-        return row->col(0);
+        AutoLock lock(folderArtMutex);
+        for (int i = 0; i < containerIDs->size(); i++)
+            trackArt[make_pair(containerIDs->get(i), base)] = artObjectID;
     }
-    return nullptr;
+
+    // track fragments depend on their parent container
+    Ref<DidlFragmentStore> fragments = DidlFragmentStore::getInstance();
+    for (int i = 0; i < containerIDs->size(); i++)
+        fragments->invalidate(containerIDs->get(i));
+}
+
+void SQLStorage::upgradeAlbumArt()
+{
+    // the upgrade SQL only knows folder images, albums without one fall
+    // back to the first of their tracks with embedded art like on import
+    Ref<StringBuffer> q(new StringBuffer());
+    *q << "SELECT " << TQD('v', "parent_id") << ',' << TQD('v', "ref_id")
+       << " FROM " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('c')
+       << " JOIN " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('v')
+       << " ON " << TQD('v', "parent_id") << '=' << TQD('c', "id")
+       << " WHERE " << TQD('c', "upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_MUSIC_ALBUM))
+       << " AND " << TQD('c', "art_object_id") << " IS NULL"
+       << " AND " << TQD('v', "ref_id") << " IS NOT NULL"
+       << " ORDER BY " << TQD('v', "parent_id") << ',' << TQD('v', "id");
+    Ref<SQLResult> res = select(q);
+    if (res == nullptr)
+        throw _Exception(_("db error"));
+    vector<pair<int, int>> refs;
+    Ref<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr)
+        refs.emplace_back(row->col(0).toInt(), row->col(1).toInt());
+
+    log_info("Looking up embedded album art of upgraded albums...\n");
+    int albumID = INVALID_OBJECT_ID;
+    int count = 0;
+    for (auto& ref : refs) {
+        if (ref.first == albumID)
+            continue;
+        Ref<CdsObject> obj;
+        try {
+            obj = loadObject(ref.second);
+        } catch (const ObjectNotFoundException& e) {
+            continue;
+        }
+        if (!hasTrackArt(obj))
+            continue;
+        Ref<IntArray> containerIDs(new IntArray());
+        containerIDs->append(ref.first);
+        _setContainerArt(containerIDs, obj->getID(), false, false);
+        albumID = ref.first;
+        count++;
+    }
+    log_info("%d albums use embedded track art\n", count);
+}
+
+void SQLStorage::_setContainerArt(Ref<IntArray> containerIDs, int artObjectID, bool replace, bool isImage)
+{
+    flushInsertBuffer();
+    Ref<StringBuffer> q(new StringBuffer());
+    *q << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+       << " SET " << TQ("art_object_id") << '=' << artObjectID
+       << " WHERE " << TQ("id") << " IN (" << containerIDs->toCSV() << ')';
+    if (!replace)
+        *q << " AND " << TQ("art_object_id") << " IS NULL";
+    exec(q);
+
+    if (cacheOn()) {
+        AutoLock lock(cache->getMutex());
+        for (int i = 0; i < containerIDs->size(); i++) {
+            Ref<CacheObject> cObj = cache->getObject(containerIDs->get(i));
+            if (cObj == nullptr || !cObj->knowsObject())
+                continue;
+            Ref<CdsObject> obj = cObj->getObject();
+            if (!IS_CDS_CONTAINER(obj->getObjectType()))
+                continue;
+            Ref<CdsContainer> cont = RefCast(obj, CdsContainer);
+            if (replace || cont->getArtObjectID() == INVALID_OBJECT_ID)
+                cont->setArtObjectID(artObjectID);
+        }
+    }
+
+    if (isImage) {
+        AutoLock lock(folderArtMutex);
+        for (int i = 0; i < containerIDs->size(); i++) {
+            if (replace)
+                folderArt[containerIDs->get(i)] = artObjectID;
+            else
+                folderArt.emplace(containerIDs->get(i), artObjectID);
+        }
+    }
+
+    Ref<DidlFragmentStore> fragments = DidlFragmentStore::getInstance();
+    for (int i = 0; i < containerIDs->size(); i++)
+        fragments->invalidate(containerIDs->get(i));
 }
 
 /*
@@ -1421,6 +1869,28 @@ void SQLStorage::_removeObjects(Ref<StringBuffer> objectIDs, int offset)
         }
     }
 
+    // containers lose their art if the image goes away
+    q->clear();
+    *q << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("art_object_id") << " IN (";
+    q->concat(objectIDs, offset);
+    *q << ')';
+    res = select(q);
+    if (res == nullptr)
+        throw _Exception(_("db error"));
+    Ref<IntArray> lostArt(new IntArray());
+    Ref<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr)
+        lostArt->append(row->col(0).toInt());
+
+    q->clear();
+    *q << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+       << " SET " << TQ("art_object_id") << "=" SQL_NULL
+       << " WHERE " << TQ("art_object_id") << " IN (";
+    q->concat(objectIDs, offset);
+    *q << ')';
+    exec(q);
+
     q->clear();
     *q << "DELETE FROM " << TQ(CDS_ACTIVE_ITEM_TABLE)
        << " WHERE " << TQ("id") << " IN (";
@@ -1434,6 +1904,113 @@ void SQLStorage::_removeObjects(Ref<StringBuffer> objectIDs, int offset)
     q->concat(objectIDs, offset);
     *q << ')';
     exec(q);
+
+    unordered_set<int> removed;
+    Ref<Array<StringBase>> ids = split_string(objectIDs->toString(offset), ',');
+    for (int i = 0; i < ids->size(); i++)
+        removed.insert(String(ids->get(i)).toInt());
+
+    // the containers that lost their art above
+    vector<int> artless;
+    {
+        AutoLock lock(folderArtMutex);
+        for (auto it = folderArt.begin(); it != folderArt.end();) {
+            if (removed.find(it->first) != removed.end())
+                it = folderArt.erase(it);
+            else if (removed.find(it->second) != removed.end()) {
+                artless.push_back(it->first);
+                it = folderArt.erase(it);
+            } else
+                ++it;
+        }
+        for (auto it = trackArt.begin(); it != trackArt.end();) {
+            if (removed.find(it->first.first) != removed.end())
+                it = trackArt.erase(it);
+            else if (removed.find(it->second) != removed.end()) {
+                artless.push_back(it->first.first);
+                it = trackArt.erase(it);
+            } else
+                ++it;
+        }
+    }
+
+    forgetUpdateIDs(removed);
+
+    Ref<DidlFragmentStore> fragments = DidlFragmentStore::getInstance();
+    for (int id : removed)
+        fragments->invalidate(id);
+    for (int id : artless)
+        fragments->invalidate(id);
+
+    _restoreContainerArt(lostArt, removed);
+}
+
+void SQLStorage::_restoreContainerArt(Ref<IntArray> lostArt, const unordered_set<int>& removed)
+{
+    Ref<IntArray> containerIDs(new IntArray());
+    for (int i = 0; i < lostArt->size(); i++) {
+        if (removed.find(lostArt->get(i)) == removed.end())
+            containerIDs->append(lostArt->get(i));
+    }
+    if (containerIDs->size() == 0)
+        return;
+
+    // the art column is NULL by now, the cached containers follow
+    if (cacheOn()) {
+        AutoLock lock(cache->getMutex());
+        for (int i = 0; i < containerIDs->size(); i++) {
+            Ref<CacheObject> cObj = cache->getObject(containerIDs->get(i));
+            if (cObj == nullptr || !cObj->knowsObject())
+                continue;
+            Ref<CdsObject> obj = cObj->getObject();
+            if (IS_CDS_CONTAINER(obj->getObjectType()))
+                RefCast(obj, CdsContainer)->setArtObjectID(INVALID_OBJECT_ID);
+        }
+    }
+
+    Ref<DidlFragmentStore> fragments = DidlFragmentStore::getInstance();
+    for (int i = 0; i < containerIDs->size(); i++)
+        fragments->invalidate(containerIDs->get(i));
+
+    // directories fall back to another folder image next to the removed
+    // one, which also restores the virtual containers referring to them
+    Ref<StringBuffer> q(new StringBuffer());
+    *q << "SELECT " << TQ("id") << ',' << TQ("parent_id") << ',' << TQ("dc_title")
+       << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("parent_id") << " IN (" << containerIDs->toCSV() << ')'
+       << " AND " << TQ("upnp_class") << '=' << quote(_(UPNP_DEFAULT_CLASS_IMAGE_ITEM));
+    Ref<SQLResult> res = select(q);
+    if (res == nullptr)
+        throw _Exception(_("db error"));
+    unordered_set<int> restored;
+    vector<int> images;
+    Ref<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        if (isFolderArtTitle(row->col(2)) && restored.insert(row->col(1).toInt()).second)
+            images.push_back(row->col(0).toInt());
+    }
+    for (int id : images)
+        _updateContainerArt(loadObject(id));
+
+    // virtual containers take the art of the items they still refer to,
+    // each reference is skipped once the container has art again
+    q->clear();
+    *q << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("parent_id") << " IN (" << containerIDs->toCSV() << ')'
+       << " AND " << TQ("ref_id") << " IS NOT NULL";
+    res = select(q);
+    if (res == nullptr)
+        throw _Exception(_("db error"));
+    vector<int> refs;
+    while ((row = res->nextRow()) != nullptr)
+        refs.push_back(row->col(0).toInt());
+    for (int id : refs) {
+        try {
+            _updateContainerArt(loadObject(id));
+        } catch (const ObjectNotFoundException& e) {
+            // the referenced item is removed in another chunk
+        }
+    }
 }
 
 Ref<Storage::ChangedContainers> SQLStorage::removeObject(int objectID, bool all)
@@ -2245,6 +2822,7 @@ void SQLStorage::addObjectToCache(Ref<CdsObject> object, bool dontLock)
 void SQLStorage::addToInsertBuffer(Ref<StringBuffer> query)
 {
     assert(doInsertBuffering());
+    detachReads();
 
     AutoLock lock(mutex);
     _addToInsertBuffer(query);
@@ -2288,4 +2866,6 @@ void SQLStorage::clearFlagInDB(int flag)
         << TQ("flags")
         << "&" << flag;
     exec(qb);
+
+    DidlFragmentStore::getInstance()->clear();
 }
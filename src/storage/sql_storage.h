@@ -37,7 +37,12 @@
 #include "dictionary.h"
 #include "storage.h"
 #include "storage_cache.h"
+#include "single_flight.h"
+#include "timer.h"
 
+#include <map>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <mutex>
 
@@ -92,7 +97,7 @@ public:
     zmm::Ref<SQLResult> select(zmm::Ref<zmm::StringBuffer> buf)
         { return select(buf->c_str(), buf->length()); }
     int exec(zmm::Ref<zmm::StringBuffer> buf, bool getLastInsertId = false)
-        { return exec(buf->c_str(), buf->length(), getLastInsertId); }
+        { detachReads(); return exec(buf->c_str(), buf->length(), getLastInsertId); }
     
     virtual void addObject(zmm::Ref<CdsObject> object, int *changedContainer) override;
     virtual void updateObject(zmm::Ref<CdsObject> object, int *changedContainer) override;
@@ -110,10 +115,13 @@ public:
     virtual zmm::Ref<CdsObject> loadObjectByServiceID(zmm::String serviceID) override;
     virtual zmm::Ref<zmm::IntArray> getServiceObjectIDs(char servicePrefix) override;
 
-    virtual zmm::String findFolderImage(int id, zmm::String trackArtBase) override;
+    virtual int getFolderArt(int containerID) override;
+    virtual int getTrackArt(int containerID, zmm::String trackArtBase) override;
     
     /* accounting methods */
     virtual int getTotalFiles() override;
+    virtual void getQueryStats(long* loadQueries, long* loadCoalesced,
+        long* browseQueries, long* browseCoalesced) override;
     
     virtual zmm::Ref<zmm::Array<CdsObject> > browse(zmm::Ref<BrowseParam> param) override;
     virtual zmm::Ref<zmm::Array<zmm::StringBase> > getMimeTypes() override;
@@ -203,8 +211,54 @@ private:
     };
     zmm::Ref<zmm::Array<AddUpdateTable> > _addUpdateObject(zmm::Ref<CdsObject> obj, bool isUpdate, int *changedContainer);
     
+    /* helpers for the container art association */
+    void _updateContainerArt(zmm::Ref<CdsObject> obj);
+    void _setContainerArt(zmm::Ref<zmm::IntArray> containerIDs, int artObjectID, bool replace, bool isImage);
+    void _setTrackArt(zmm::Ref<zmm::IntArray> containerIDs, zmm::String trackArtBase, int artObjectID);
+    void loadFolderArt();
+    void loadTrackArt();
+    void upgradeAlbumArt();
+
+    /// \brief container ID -> image, the art_object_id of all containers
+    /// whose art is an image
+    std::unordered_map<int, int> folderArt;
+    /// \brief (container ID, lowercase image name without extension) ->
+    /// image, for the directory of the image and the virtual containers
+    /// that refer to items of that directory
+    std::map<std::pair<int, std::string>, int> trackArt;
+    std::mutex folderArtMutex;
+    
+    /* container update IDs, kept in memory and written behind */
+    class UpdateIDWriter : public Timer::Subscriber {
+    public:
+        explicit UpdateIDWriter(SQLStorage* storage)
+            : storage(storage)
+        {
+        }
+        virtual void timerNotify(zmm::Ref<Timer::Parameter> parameter) override { storage->flushUpdateIDs(); }
+
+    private:
+        SQLStorage* storage;
+    };
+    void loadUpdateIDs();
+    void seedUpdateID(int id);
+    void flushUpdateIDs();
+    void forgetUpdateIDs(const std::unordered_set<int>& ids);
+
+    /// \brief container ID -> update ID, authoritative over the
+    /// update_id column, which lags behind until the next flush
+    std::unordered_map<int, int> updateIDs;
+    /// \brief containers whose update ID has not been written yet
+    std::unordered_set<int> dirtyUpdateIDs;
+    std::mutex updateIDMutex;
+    /// \brief keeps flushes in order, so an older value never
+    /// overwrites a newer one
+    std::mutex updateIDFlushMutex;
+    UpdateIDWriter updateIDWriter;
+
     /* helper for removeObject(s) */
     void _removeObjects(zmm::Ref<zmm::StringBuffer> objectIDs, int offset);
+    void _restoreContainerArt(zmm::Ref<zmm::IntArray> lostArt, const std::unordered_set<int>& removed);
     zmm::Ref<ChangedContainersStr> _recursiveRemove(zmm::Ref<zmm::StringBuffer> items, zmm::Ref<zmm::StringBuffer> containers, bool all);
     
     virtual zmm::Ref<ChangedContainers> _purgeEmptyContainers(zmm::Ref<ChangedContainersStr> changedContainersStr);
@@ -232,6 +286,23 @@ private:
     zmm::String fsRootName;
     
     int lastID;
+
+    /* concurrent identical reads share one query */
+    struct BrowseRows {
+        zmm::Ref<zmm::Array<CdsObject> > objects;
+        int totalMatches = 0;
+    };
+    SingleFlight<int, zmm::Ref<CdsObject> > loadFlight;
+    SingleFlight<std::string, BrowseRows> browseFlight;
+    zmm::Ref<CdsObject> _loadObject(int objectID);
+    zmm::Ref<zmm::Array<CdsObject> > _browse(zmm::Ref<BrowseParam> param);
+    /// \brief called on every write, so that no caller gets the result
+    /// of a read that started before its own write
+    void detachReads()
+    {
+        loadFlight.detach();
+        browseFlight.detach();
+    }
     
     int getNextID();
     void loadLastID();
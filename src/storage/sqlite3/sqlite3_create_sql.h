@@ -33,63 +33,64 @@
 
 #ifndef __SQLITE3_CREATE_SQL_H__
 #define __SQLITE3_CREATE_SQL_H__
-#define SL3_CREATE_SQL_INFLATED_SIZE 2933
-#define SL3_CREATE_SQL_DEFLATED_SIZE 760
+#define SL3_CREATE_SQL_INFLATED_SIZE 3065
+#define SL3_CREATE_SQL_DEFLATED_SIZE 775
 
 /* begin binary data: */
-const unsigned char sqlite3_create_sql[] = /* 760 */
+const unsigned char sqlite3_create_sql[] = /* 775 */
 {0x78,0x9C,0xB5,0x56,0x5B,0x6F,0xDA,0x30,0x14,0x7E,0xE7,0x57,0x58,0x79,0x09
-,0x95,0xD8,0x04,0xDD,0x2A,0x6D,0xEA,0x53,0x1A,0xDC,0x2A,0x1A,0x4D,0xBA,0x10
-,0xA6,0xED,0xC9,0x32,0x89,0x01,0xAF,0xB9,0xC9,0x71,0xA2,0xF2,0xEF,0x67,0x27
-,0x90,0x0B,0xB9,0x90,0x4D,0x9D,0x84,0x10,0x9C,0xF3,0x9D,0x8B,0xCF,0xF9,0x7C
-,0x8E,0x1F,0xE0,0x93,0x61,0x02,0xC7,0xD6,0xCC,0xB5,0xA6,0x3B,0x86,0x65,0xDE
-,0x4F,0x74,0x1B,0x6A,0x0E,0x04,0x8E,0xF6,0xB0,0x82,0x40,0x09,0x38,0x72,0xBD
-,0x04,0x45,0xDB,0xDF,0xC4,0xE5,0x0A,0x98,0x4E,0x00,0x50,0xA8,0xA7,0x00,0x1A
-,0x72,0xB2,0x27,0x0C,0xC4,0x8C,0x06,0x98,0x1D,0xC1,0x2B,0x39,0xCE,0xA4,0x8E
-,0x91,0x1D,0xAA,0xEB,0x3D,0xB2,0xC3,0xA9,0xCF,0x81,0xB9,0x59,0xAD,0x72,0x40
-,0x8C,0x19,0x09,0x79,0x03,0x63,0x5A,0x4E,0xAE,0x2F,0xC1,0xEA,0x5C,0xCD,0xB1
-,0x45,0x54,0xC4,0x8F,0x31,0x51,0x00,0xA7,0xE1,0x51,0x58,0x80,0x34,0x4C,0xE8
-,0x3E,0x24,0x5E,0x69,0x96,0x43,0xD3,0x38,0x8C,0x91,0xEB,0xE3,0x24,0x51,0x40
-,0x86,0x99,0x7B,0xC0,0x6C,0xFA,0x65,0x7E,0xD3,0x8E,0xEF,0xB9,0x88,0x53,0xEE
-,0x93,0x0A,0x76,0x7B,0x77,0xD7,0x81,0xF3,0x23,0x17,0x73,0x1A,0x85,0x22,0x30
-,0x79,0xE3,0xFD,0x7A,0x74,0xC0,0xC9,0xA1,0x3A,0x4B,0x99,0x5D,0xCB,0x20,0x20
-,0x1C,0x7B,0x98,0xE3,0x3E,0x87,0x38,0x7D,0x1B,0x52,0x33,0x92,0x44,0x29,0x73
-,0x49,0xD2,0x07,0x48,0x63,0x61,0x4E,0xC6,0x15,0x36,0xA0,0x01,0x39,0x95,0xF5
-,0x5C,0x85,0xCF,0x5D,0xC5,0xDA,0xF9,0x78,0x9F,0x74,0x1C,0xAE,0xED,0x78,0x51
-,0x38,0xE6,0x0C,0xBB,0xAF,0x28,0x4C,0x83,0x2D,0x61,0x03,0x24,0x48,0x08,0xCB
-,0xA8,0x5B,0x24,0x3B,0xD8,0x06,0xDD,0x32,0xD7,0x82,0x9D,0x86,0xE9,0x00,0xA5
-,0xE2,0x21,0xA2,0xDB,0xDD,0x2B,0x5A,0x28,0xE0,0xD1,0xB2,0xA1,0xF1,0x64,0x82
-,0x6F,0xF0,0x17,0x98,0x9E,0xB9,0x77,0x03,0x6C,0xF8,0x08,0x6D,0x68,0xEA,0x70
-,0x5D,0xB7,0x12,0xEC,0x55,0x72,0xB5,0x65,0x82,0x25,0x5C,0x41,0x41,0x72,0x5D
-,0x5B,0xEB,0xDA,0x12,0x4A,0xC9,0xE6,0x65,0xA9,0x55,0x92,0x6B,0xB1,0x6F,0x2F
-,0x63,0x57,0xB4,0x7E,0x8F,0xF0,0x93,0x9B,0xFB,0x89,0x61,0xAE,0xA1,0xED,0x00
-,0x11,0xDE,0x6A,0x5D,0xC3,0x1F,0xDA,0x6A,0x03,0xD7,0xD3,0x0F,0x8B,0x59,0x51
-,0x29,0x20,0x7F,0xCD,0xCF,0x7F,0xC6,0x7C,0x97,0xE0,0xAF,0x75,0xF9,0xB8,0xB0
-,0xF3,0x7A,0x54,0xF1,0x51,0x0B,0xFD,0x47,0x37,0x0A,0x39,0xA6,0x21,0x61,0xAA
-,0x90,0xD9,0x51,0xC4,0xD5,0xFF,0x99,0xC5,0xA2,0xE6,0xA4,0x2F,0x89,0x17,0x1D
-,0x2C,0x29,0x13,0xE2,0x88,0x1D,0xFF,0x3D,0x99,0xCE,0x89,0x88,0x5D,0x4E,0x33
-,0xC1,0x60,0x4E,0x82,0x11,0x63,0x51,0xA2,0xE5,0x2C,0x69,0x90,0xBD,0x31,0xC0
-,0x12,0x2E,0x6E,0xEF,0x00,0xA0,0xCE,0xC6,0x76,0x0A,0x3D,0x37,0xA2,0x45,0xC7
-,0xCB,0x71,0xFE,0x57,0x8C,0x6C,0xD5,0x41,0x9E,0x96,0x85,0xD8,0x47,0x09,0xE1
-,0x62,0x3C,0xEF,0x4F,0x85,0x10,0x87,0x6E,0xCE,0x95,0x5A,0x35,0x9A,0x87,0xCE
-,0xB0,0x9F,0xF6,0x1D,0xBA,0xEB,0x0E,0xB4,0x03,0x9E,0xC8,0xA0,0x7A,0x5B,0x94
-,0x11,0x96,0x88,0x22,0xCB,0xBE,0x7F,0x52,0xBB,0xD2,0xC5,0x29,0x8F,0x12,0x17
-,0x87,0x23,0xFA,0x25,0x0A,0x34,0xBC,0xC6,0xA4,0x1F,0xE4,0x93,0x8C,0xF8,0x55
-,0xFA,0x8B,0xF9,0x65,0x4F,0x25,0x28,0x88,0x3C,0x32,0x80,0x11,0xEC,0x4C,0x45
-,0xDE,0xD9,0xD5,0x0D,0x77,0xA0,0x9E,0x47,0xC2,0x6B,0xA8,0xBC,0x42,0xA2,0xAC
-,0x63,0x36,0x92,0xD8,0x96,0x5C,0xA6,0x47,0x77,0x94,0x78,0x63,0x0C,0x62,0x59
-,0xE1,0x84,0x8B,0x41,0x37,0x90,0x46,0x6B,0xD9,0x5C,0xDB,0xA4,0x31,0xE6,0x07
-,0x51,0xEC,0xDE,0xC5,0xC6,0xA3,0xD4,0x3D,0xC8,0x04,0x47,0x84,0x2C,0xD6,0xD0
-,0xC5,0x5D,0x39,0xF7,0x3D,0xEF,0x68,0xF3,0x82,0x9C,0xFA,0xFC,0xFE,0x97,0xC4
-,0x30,0x97,0xF0,0x27,0x68,0x78,0x42,0xC5,0x7E,0x92,0x66,0x0D,0xF9,0xB4,0x90
-,0x0F,0xDB,0x96,0xFB,0xA5,0x6D,0x5E,0xAA,0x66,0xB5,0xF7,0xD2,0xEC,0xFC,0xCE
-,0xE9,0x70,0x5B,0x83,0xB5,0xBD,0xD5,0x94,0x1D,0xA6,0xE5,0xAB,0xA7,0x08,0xDA
-,0x36,0x6F,0x3C,0x8B,0x66,0x65,0x6A,0x1D,0xAE,0xEA,0x4F,0x85,0xB6,0x9F,0xBA
-,0xB6,0xC3,0xF8,0x72,0x10,0x20,0x39,0x5A,0x0A,0x27,0x97,0xAA,0xA9,0x50,0x55
-,0x1E,0x36,0xA6,0xF1,0x7D,0x53,0x73,0x54,0x72,0xA3,0x60,0xC2,0xC9,0xC7,0x59
-,0x3A,0x2D,0xA4,0xC3,0xAD,0xA9,0x1E,0x33,0xED,0x63,0x54,0x3A,0xE9,0xC3,0x7A
-,0x7E,0x36,0x9C,0xFB,0xC9,0x1F,0x6D,0x27,0x91,0x85};
-/* end binary data. size = 760 bytes */
+,0x95,0xD8,0x04,0x55,0x2B,0x6D,0xEA,0x53,0x0A,0x6E,0x15,0x8D,0x86,0x2E,0x84
+,0x69,0x7B,0xB2,0x4C,0x62,0xC0,0x6B,0x6E,0xB2,0x1D,0x54,0xFE,0xFD,0xEC,0x04
+,0x72,0xC1,0x21,0x64,0x5A,0x27,0x21,0x04,0xE7,0xF2,0x9D,0xE3,0xE3,0xEF,0x9C
+,0xE3,0x47,0xF8,0x6C,0x3B,0xC0,0x73,0x2D,0x67,0x69,0x4D,0x3D,0x7B,0xE1,0x3C
+,0x0C,0xA6,0x2E,0xB4,0x3C,0x08,0x3C,0xEB,0x71,0x0E,0x81,0x11,0x09,0xE4,0x07
+,0x1C,0x25,0xEB,0xDF,0xC4,0x17,0x06,0x18,0x0E,0x00,0x30,0x68,0x60,0x00,0x1A
+,0x0B,0xB2,0x25,0x0C,0xA4,0x8C,0x46,0x98,0x1D,0xC0,0x1B,0x39,0x8C,0x94,0x8E
+,0x91,0x0D,0xAA,0xEB,0x03,0xB2,0xC1,0x59,0x28,0x80,0xB3,0x9A,0xCF,0x73,0x83
+,0x14,0x33,0x12,0x8B,0x86,0x8D,0xB3,0xF0,0x72,0x7D,0x69,0x6C,0x8E,0xCD,0xDC
+,0xB6,0x88,0x8A,0xC4,0x21,0x25,0x06,0x10,0x34,0x3E,0x48,0x0F,0x90,0xC5,0x9C
+,0x6E,0x63,0x12,0x94,0x6E,0xB9,0x69,0x96,0xC6,0x29,0xF2,0x43,0xCC,0xB9,0x01
+,0xF6,0x98,0xF9,0x3B,0xCC,0x86,0x5F,0xC6,0x37,0x7A,0xFC,0xC0,0x47,0x82,0x8A
+,0x90,0x54,0x66,0xB7,0xF7,0xF7,0x2D,0x76,0x61,0xE2,0x63,0x41,0x93,0x58,0x06
+,0x26,0xEF,0xE2,0xB2,0x1E,0xED,0x30,0xDF,0x55,0x67,0x29,0xB3,0xD3,0x1C,0x22
+,0x22,0x70,0x80,0x05,0xBE,0x04,0x88,0xB3,0xF7,0x2E,0x35,0x23,0x3C,0xC9,0x98
+,0x4F,0xF8,0x25,0x83,0x2C,0x95,0xEE,0xA4,0x5F,0x61,0x23,0x1A,0x91,0x63,0x59
+,0x4F,0x55,0xB8,0x6B,0x2B,0xD6,0x26,0xC4,0x5B,0xDE,0x72,0x38,0x1D,0x78,0x52
+,0x00,0x0B,0x86,0xFD,0x37,0x14,0x67,0xD1,0x9A,0xB0,0x0E,0x12,0x70,0xC2,0xF6
+,0xD4,0x2F,0x92,0xED,0xBE,0x06,0xCC,0xC4,0x91,0x7C,0x9D,0xB4,0x9A,0x2E,0x9C
+,0xA5,0x64,0xB1,0xED,0x78,0xC0,0xA8,0xF8,0x8A,0xE8,0x7A,0xF3,0x86,0x26,0x06
+,0x78,0x5A,0xB8,0xD0,0x7E,0x76,0xC0,0x37,0xF8,0x0B,0x0C,0x4F,0x1C,0xBD,0x01
+,0x2E,0x7C,0x82,0x2E,0x74,0xA6,0x70,0x59,0xF7,0x92,0x2C,0x37,0x72,0xF5,0xC2
+,0x01,0x33,0x38,0x87,0xB2,0x19,0xA6,0xD6,0x72,0x6A,0xCD,0xA0,0x92,0xAC,0x5E
+,0x67,0x56,0x25,0xB9,0x16,0xFB,0xF6,0x3C,0x76,0x45,0xFF,0x8F,0x08,0x3F,0xB8
+,0x79,0x18,0xD8,0xCE,0x12,0xBA,0x1E,0x90,0xE1,0x17,0x5A,0xBB,0xFE,0xB0,0xE6
+,0x2B,0xB8,0x1C,0x7E,0x9A,0x8C,0x8A,0x4A,0x01,0xF5,0x6B,0x7C,0xFA,0xD3,0xE7
+,0xBB,0x34,0xFE,0xAA,0x6B,0xFB,0x05,0x1F,0xD7,0x63,0xCB,0x8F,0x59,0xE8,0x3F
+,0xFB,0x49,0x2C,0x30,0x8D,0x09,0x33,0xA5,0xCC,0x4D,0x12,0x61,0xFE,0xFF,0x5C
+,0x26,0x35,0xA8,0x4B,0xA9,0xBC,0x4E,0xC1,0x8C,0x32,0x29,0x4E,0xD8,0xE1,0x5F
+,0x53,0x6A,0x9D,0xA5,0xD8,0x17,0x74,0x2F,0xB9,0x2F,0x48,0xD4,0x63,0xA0,0x2A
+,0x6B,0x35,0x85,0x1A,0x6D,0xD2,0x18,0x7D,0x5C,0xC8,0xBE,0xEF,0x30,0xA8,0xF3
+,0x53,0x4F,0xE1,0x42,0x8F,0x68,0x04,0x3D,0x5F,0x04,0x7F,0xC5,0x51,0xAD,0x0E
+,0xEA,0xB4,0x2C,0xC6,0x21,0xE2,0x44,0xC8,0xC1,0xBE,0x3D,0x16,0x42,0x1E,0xBA
+,0x39,0x91,0x6A,0xD5,0x68,0x1E,0x7A,0x8F,0xC3,0xEC,0xD2,0xA1,0xDB,0xBA,0x42
+,0x0F,0x78,0xA4,0x84,0x19,0xAC,0xD1,0x9E,0x30,0x2E,0x8B,0xAC,0x6E,0xFF,0xCE
+,0x6C,0x4B,0x17,0x67,0x22,0xE1,0x3E,0x8E,0x7B,0xDC,0x97,0x2C,0x50,0xF7,0x02
+,0x54,0x38,0x28,0x24,0x7B,0x12,0x56,0xE9,0x4F,0xC6,0xE7,0x77,0xAA,0x8C,0xA2
+,0x24,0x20,0x1D,0x36,0x92,0xA3,0x99,0xCC,0x7B,0x7F,0x75,0x37,0xEE,0x68,0x10
+,0x90,0xF8,0x9A,0x55,0x5E,0x21,0x59,0xD6,0x3E,0xBB,0x4C,0xEE,0x59,0xA1,0xD2
+,0xA3,0x1B,0x4A,0x82,0x3E,0x0E,0xA9,0xAA,0x30,0x17,0x72,0xF4,0x75,0xA4,0xA1
+,0xAD,0xA9,0x6B,0x3B,0x38,0xC5,0x62,0x27,0x8B,0x7D,0x71,0x25,0x8A,0x24,0xF3
+,0x77,0x2A,0xC1,0x1E,0x21,0x8B,0x05,0x76,0xD6,0x2B,0xA7,0x7B,0xCF,0x6F,0xB4
+,0xD9,0x20,0xC7,0x7B,0xFE,0xF8,0x26,0xB1,0x9D,0x19,0xFC,0x09,0x1A,0x48,0xA8
+,0xD8,0x58,0xCA,0xAD,0x21,0x1F,0x16,0xF2,0x6E,0xDF,0x72,0xE3,0xE8,0xEE,0xA5
+,0x6A,0x54,0x7B,0x69,0x8D,0x4E,0x2F,0xA4,0x16,0xD8,0x9A,0x99,0x8E,0x56,0x53
+,0xB6,0xB8,0x96,0xEF,0xA5,0x22,0xA8,0xEE,0xDE,0x78,0x50,0x8D,0xCA,0xD4,0x5A
+,0xA0,0xEA,0x8F,0x0C,0x1D,0xA7,0xAE,0x6D,0x71,0x3E,0x1F,0x04,0x48,0x8D,0x96
+,0x02,0xE4,0x5C,0x35,0x94,0xAA,0x0A,0x61,0xE5,0xD8,0xDF,0x57,0x35,0xA0,0x92
+,0x1B,0x05,0x13,0x8E,0x18,0x27,0xE9,0xB0,0x90,0x76,0x5F,0x4D,0xF5,0x0C,0xD2
+,0x8F,0x51,0xE9,0xBA,0x31,0x1A,0x0F,0x24,0x1D,0xA6,0xA1,0x56,0x48,0x8B,0x97
+,0x17,0xDB,0x7B,0x18,0xFC,0x01,0x7D,0xEF,0xBD,0xFC};
+/* end binary data. size = 775 bytes */
 
 #endif // __SQLITE3_CREATE_SQL_H__
 
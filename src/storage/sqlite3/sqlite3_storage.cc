@@ -54,6 +54,14 @@
 #define SQLITE3_UPDATE_2_3_2 "CREATE INDEX mt_cds_object_service_id ON mt_cds_object(service_id)"
 #define SQLITE3_UPDATE_2_3_3 "UPDATE \"mt_internal_setting\" SET \"value\"='3' WHERE \"key\"='db_version' AND \"value\"='2'"
 
+// updates 3->4
+#define SQLITE3_UPDATE_3_4_1 "ALTER TABLE \"mt_cds_object\" ADD \"art_object_id\" integer default NULL"
+#define SQLITE3_UPDATE_3_4_2 "CREATE INDEX mt_cds_object_art_object_id ON mt_cds_object(art_object_id)"
+#define SQLITE3_UPDATE_3_4_3 "UPDATE \"mt_cds_object\" SET \"art_object_id\"=(SELECT \"i\".\"id\" FROM \"mt_cds_object\" \"i\" WHERE \"i\".\"parent_id\"=\"mt_cds_object\".\"id\" AND \"i\".\"upnp_class\"='object.item.imageItem' AND (\"i\".\"dc_title\" LIKE 'cover.jp%' OR \"i\".\"dc_title\" LIKE 'albumart%.jp%' OR \"i\".\"dc_title\" LIKE 'album.jp%' OR \"i\".\"dc_title\" LIKE 'front.jp%' OR \"i\".\"dc_title\" LIKE 'folder.jp%') LIMIT 1) WHERE \"object_type\"=1"
+#define SQLITE3_UPDATE_3_4_4 "UPDATE \"mt_cds_object\" SET \"art_object_id\"=(SELECT \"f\".\"art_object_id\" FROM \"mt_cds_object\" \"v\" JOIN \"mt_cds_object\" \"r\" ON \"r\".\"id\"=\"v\".\"ref_id\" JOIN \"mt_cds_object\" \"f\" ON \"f\".\"id\"=\"r\".\"parent_id\" WHERE \"v\".\"parent_id\"=\"mt_cds_object\".\"id\" AND \"f\".\"art_object_id\" IS NOT NULL LIMIT 1) WHERE \"object_type\"=1 AND \"art_object_id\" IS NULL"
+#define SQLITE3_UPDATE_3_4_5 "INSERT INTO \"mt_internal_setting\" VALUES('album_art_upgrade', 'pending')"
+#define SQLITE3_UPDATE_3_4_6 "UPDATE \"mt_internal_setting\" SET \"value\"='4' WHERE \"key\"='db_version' AND \"value\"='3'"
+
 #define SL3_INITITAL_QUEUE_SIZE 20
 
 using namespace zmm;
@@ -185,9 +193,21 @@ void Sqlite3Storage::init()
         dbVersion = _("3");
     }
 
+    if (dbVersion == "3") {
+        log_info("Doing an automatic database upgrade from database version 3 to version 4...\n");
+        _exec(SQLITE3_UPDATE_3_4_1);
+        _exec(SQLITE3_UPDATE_3_4_2);
+        _exec(SQLITE3_UPDATE_3_4_3);
+        _exec(SQLITE3_UPDATE_3_4_4);
+        _exec(SQLITE3_UPDATE_3_4_5);
+        _exec(SQLITE3_UPDATE_3_4_6);
+        log_info("database upgrade successful.\n");
+        dbVersion = _("4");
+    }
+
     /* --- --- ---*/
 
-    if (!string_ok(dbVersion) || dbVersion != "3")
+    if (!string_ok(dbVersion) || dbVersion != "4")
         throw _Exception(_("The database seems to be from a newer version!"));
 
     // add timer for backups
@@ -0,0 +1,336 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    thumbnail_service.cc - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file thumbnail_service.cc
+
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+
+#include "thumbnail_service.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include "config_manager.h"
+#include "metadata/ffmpeg_handler.h"
+
+/// \brief progress is logged every that many finished jobs
+#define THUMBNAIL_PROGRESS_INTERVAL 100
+/// \brief milliseconds between checks whether a worker child exited
+#define THUMBNAIL_POLL_INTERVAL 50
+
+#ifndef THUMBNAILER_BINARY
+#define THUMBNAILER_BINARY "gerbera-thumbnailer"
+#endif
+
+extern char** environ;
+
+using namespace zmm;
+using namespace std;
+
+ThumbnailService::ThumbnailService()
+    : Singleton<ThumbnailService>()
+    , workerCount(0)
+    , workerTimeout(0)
+    , shutdownFlag(false)
+    , backlog(0)
+    , running(0)
+    , generated(0)
+    , skipped(0)
+    , failed(0)
+    , batchQueued(0)
+    , batchDone(0)
+{
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    // the workers can only hand their results over through the cache
+    if (cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED)
+        && cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED)) {
+        workerCount = cfg->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_WORKERS);
+        workerTimeout = cfg->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_WORKER_TIMEOUT);
+    }
+    if (workerCount <= 0)
+        return;
+
+    thumbnailer = find_helper(_(THUMBNAILER_BINARY), _("gerbera-thumbnailer"));
+    if (!string_ok(thumbnailer)) {
+        log_warning("%s not found, thumbnails are generated on request\n", THUMBNAILER_BINARY);
+        workerCount = 0;
+        return;
+    }
+    thumbSize = String::from(cfg->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THUMBSIZE));
+    seekPercentage = String::from(cfg->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_SEEK_PERCENTAGE));
+    imageQuality = String::from(cfg->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_IMAGE_QUALITY));
+    filmstrip = cfg->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_FILMSTRIP_OVERLAY) ? _("1") : _("0");
+}
+
+void ThumbnailService::init()
+{
+    for (int i = 0; i < workerCount; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, ThumbnailService::staticThreadProc, this) != 0) {
+            log_error("Could not start thumbnail worker: %s\n", strerror(errno));
+            break;
+        }
+        workers.push_back(thread);
+    }
+    workerCount = workers.size();
+    if (workerCount > 0)
+        log_debug("Started %d thumbnail workers\n", workerCount);
+}
+
+void ThumbnailService::shutdown()
+{
+    unique_lock<mutex_type> lock(mutex);
+    shutdownFlag = true;
+    cond.notify_all();
+    doneCond.notify_all();
+    lock.unlock();
+
+    for (auto& thread : workers)
+        pthread_join(thread, nullptr);
+    workers.clear();
+}
+
+void ThumbnailService::enqueue(String location, bool urgent)
+{
+    if (!isEnabled() || !string_ok(location))
+        return;
+
+    AutoLock lock(mutex);
+    if (shutdownFlag)
+        return;
+
+    string key(location.c_str());
+    if (hasFailed(key))
+        return;
+    if (pending.find(key) != pending.end()) {
+        if (urgent) {
+            // move a queued job to the front, running jobs are not found
+            auto it = find(queue.begin(), queue.end(), key);
+            if (it != queue.end() && it != queue.begin()) {
+                queue.erase(it);
+                queue.push_front(key);
+            }
+        }
+        return;
+    }
+
+    pending.insert(key);
+    if (urgent)
+        queue.push_front(key);
+    else
+        queue.push_back(key);
+    backlog = queue.size();
+    batchQueued++;
+    cond.notify_one();
+}
+
+bool ThumbnailService::waitFor(String location)
+{
+    enqueue(location, true);
+
+    string key(location.c_str());
+    unique_lock<mutex_type> lock(mutex);
+    if (hasFailed(key))
+        return false;
+    // the request holds a server thread, it gives up after one worker
+    // timeout even if the job is still queued behind running jobs
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(workerTimeout);
+    while (pending.find(key) != pending.end()) {
+        if (shutdownFlag || doneCond.wait_until(lock, deadline) == cv_status::timeout)
+            return false;
+    }
+    return true;
+}
+
+void* ThumbnailService::staticThreadProc(void* arg)
+{
+    auto* inst = static_cast<ThumbnailService*>(arg);
+    inst->threadProc();
+    pthread_exit(nullptr);
+    return nullptr;
+}
+
+void ThumbnailService::threadProc()
+{
+    unique_lock<mutex_type> lock(mutex);
+    while (!shutdownFlag) {
+        if (queue.empty()) {
+            cond.wait(lock);
+            continue;
+        }
+
+        string key = queue.front();
+        queue.pop_front();
+        backlog = queue.size();
+        running++;
+        lock.unlock();
+
+        String location(key.c_str());
+        bool ok = true;
+        if (isFresh(location))
+            skipped++;
+        else if (runWorker(location))
+            generated++;
+        else if (!shutdownFlag) {
+            failed++;
+            ok = false;
+        }
+
+        // broken files are not retried until they change
+        struct stat statbuf;
+        time_t mtime = (stat(location.c_str(), &statbuf) == 0) ? statbuf.st_mtime : 0;
+
+        lock.lock();
+        if (ok)
+            failures.erase(key);
+        else
+            failures[key] = mtime;
+        running--;
+        pending.erase(key);
+        doneCond.notify_all();
+
+        batchDone++;
+        if (queue.empty() && running == 0) {
+            if (batchDone > 1)
+                log_info("Thumbnail queue done: %ld generated, %ld up to date, %ld failed\n",
+                    (long)generated, (long)skipped, (long)failed);
+            batchQueued = 0;
+            batchDone = 0;
+        } else if (batchDone % THUMBNAIL_PROGRESS_INTERVAL == 0) {
+            log_info("Thumbnails: %ld of %ld done, %ld queued\n",
+                batchDone, batchQueued, (long)backlog);
+        }
+    }
+}
+
+bool ThumbnailService::hasFailed(const string& key)
+{
+    auto it = failures.find(key);
+    if (it == failures.end())
+        return false;
+    struct stat statbuf;
+    if (stat(key.c_str(), &statbuf) == 0 && statbuf.st_mtime == it->second)
+        return true;
+    failures.erase(it);
+    return false;
+}
+
+bool ThumbnailService::isFresh(String location)
+{
+    struct stat source;
+    struct stat thumb;
+    if (stat(location.c_str(), &source) != 0)
+        return false;
+    String path = FfmpegHandler::getThumbnailCachePath(location, false);
+    if (stat(path.c_str(), &thumb) != 0)
+        return false;
+    return thumb.st_mtime >= source.st_mtime;
+}
+
+bool ThumbnailService::runWorker(String location)
+{
+    log_debug("Generating thumbnail for file: %s\n", location.c_str());
+
+    String path = FfmpegHandler::getThumbnailCachePath(location, true);
+    if (!string_ok(path))
+        return false;
+    // readers must never see a partially written thumbnail
+    String part = path + ".part";
+
+    const char* argv[] = {
+        thumbnailer.c_str(), location.c_str(), part.c_str(),
+        thumbSize.c_str(), seekPercentage.c_str(), imageQuality.c_str(),
+        filmstrip.c_str(), nullptr
+    };
+
+    // the server threads block their signals, the helper gets an empty mask
+    posix_spawnattr_t attr;
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    pid_t pid;
+    int err = posix_spawn(&pid, thumbnailer.c_str(), nullptr, &attr,
+        const_cast<char* const*>(argv), environ);
+    posix_spawnattr_destroy(&attr);
+    if (err != 0) {
+        log_error("Could not start %s: %s\n", thumbnailer.c_str(), strerror(err));
+        return false;
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(workerTimeout);
+    int status = 0;
+    while (true) {
+        pid_t ret = waitpid(pid, &status, WNOHANG);
+        if (ret == pid)
+            break;
+        if (ret < 0 && errno != EINTR) {
+            log_error("Lost thumbnail worker %d: %s\n", pid, strerror(errno));
+            return false;
+        }
+        if (shutdownFlag || chrono::steady_clock::now() > deadline) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            unlink(part.c_str());
+            if (!shutdownFlag)
+                log_warning("Thumbnail generation for %s took longer than %d seconds, aborted\n",
+                    location.c_str(), workerTimeout);
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(THUMBNAIL_POLL_INTERVAL));
+    }
+
+    if (WIFSIGNALED(status)) {
+        log_warning("Thumbnail worker for %s died with signal %d\n",
+            location.c_str(), WTERMSIG(status));
+        unlink(part.c_str());
+        return false;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        log_debug("Could not generate thumbnail for %s\n", location.c_str());
+        unlink(part.c_str());
+        return false;
+    }
+    if (rename(part.c_str(), path.c_str()) != 0) {
+        log_error("Could not store thumbnail %s: %s\n", path.c_str(), strerror(errno));
+        unlink(part.c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif // HAVE_FFMPEG && HAVE_FFMPEGTHUMBNAILER
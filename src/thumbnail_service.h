@@ -0,0 +1,137 @@
+/*MT*
+
+    MediaTomb - http://www.mediatomb.cc/
+
+    thumbnail_service.h - this file is part of MediaTomb.
+
+    Copyright (C) 2005 Gena Batyan <bgeradz@mediatomb.cc>,
+                       Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>
+
+    Copyright (C) 2006-2010 Gena Batyan <bgeradz@mediatomb.cc>,
+                            Sergey 'Jin' Bostandzhyan <jin@mediatomb.cc>,
+                            Leonhard Wimmer <leo@mediatomb.cc>
+
+    MediaTomb is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    MediaTomb is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    version 2 along with MediaTomb; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    $Id$
+*/
+/// \file thumbnail_service.h
+/// \brief Definition of the ThumbnailService class.
+
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+
+#ifndef __THUMBNAIL_SERVICE_H__
+#define __THUMBNAIL_SERVICE_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common.h"
+#include "singleton.h"
+
+/// \brief Generates video thumbnails into the thumbnail cache in the
+/// background.
+///
+/// Imported and rescanned videos are queued, a pool of worker threads
+/// takes them off the queue and starts the gerbera-thumbnailer helper
+/// for each. The helpers do not share the thumbnailer state, so they can
+/// run in parallel, and a file that hangs or crashes the thumbnailer
+/// only takes down its helper. Serving a thumbnail reads the cache and
+/// waits at most one worker timeout for its job to finish.
+class ThumbnailService : public Singleton<ThumbnailService>
+{
+public:
+    ThumbnailService();
+    virtual void init() override;
+    virtual void shutdown() override;
+    zmm::String getName() override { return _("Thumbnail Service"); }
+
+    /// \brief true if thumbnails are generated by the workers, false if
+    /// they are still generated inside the request
+    inline bool isEnabled() { return workerCount > 0; }
+
+    /// \brief Queues generation of the thumbnail of a video file.
+    /// \param location path of the video file
+    /// \param urgent put the job in front of the queue
+    void enqueue(zmm::String location, bool urgent = false);
+
+    /// \brief Waits until the job of the file is finished, the job is
+    /// queued in front if it is not pending yet.
+    /// \return false if the job did not finish within the worker timeout,
+    /// or right away if it already failed for the current file
+    bool waitFor(zmm::String location);
+
+    inline long getBacklog() { return backlog; }
+    inline long getRunning() { return running; }
+    inline long getGenerated() { return generated; }
+    inline long getSkipped() { return skipped; }
+    inline long getFailed() { return failed; }
+
+protected:
+    int workerCount;
+    int workerTimeout;
+
+    /// \brief path of the helper and its thumbnail arguments
+    zmm::String thumbnailer;
+    zmm::String thumbSize;
+    zmm::String seekPercentage;
+    zmm::String imageQuality;
+    zmm::String filmstrip;
+
+    std::vector<pthread_t> workers;
+    std::condition_variable cond;
+    std::condition_variable doneCond;
+    std::atomic<bool> shutdownFlag;
+
+    /// \brief queued locations, in order
+    std::deque<std::string> queue;
+    /// \brief queued and running locations
+    std::unordered_set<std::string> pending;
+    /// \brief locations whose thumbnail could not be generated, with the
+    /// modification time of the file at that point
+    std::unordered_map<std::string, time_t> failures;
+
+    std::atomic<long> backlog;
+    std::atomic<long> running;
+    std::atomic<long> generated;
+    std::atomic<long> skipped;
+    std::atomic<long> failed;
+    /// \brief jobs queued and finished since the queue was last empty
+    long batchQueued;
+    long batchDone;
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+
+    /// \brief true if the cached thumbnail is newer than the video file
+    bool isFresh(zmm::String location);
+
+    /// \brief true if the job failed before and the file did not change
+    /// since, called with the mutex held
+    bool hasFailed(const std::string& key);
+
+    /// \brief Runs the thumbnailer helper and moves its result into the
+    /// cache.
+    bool runWorker(zmm::String location);
+};
+
+#endif // __THUMBNAIL_SERVICE_H__
+
+#endif // HAVE_FFMPEG && HAVE_FFMPEGTHUMBNAILER
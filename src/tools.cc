@@ -158,6 +158,74 @@ String trim_string(String str)
     return str.substring(start, end - start);
 }
 
+static int mkdir_x(const char* path)
+{
+    int ret = mkdir(path, 0777);
+
+    if (ret == 0) {
+        // Make sure we are +x in case of restrictive umask that strips +x.
+        struct stat st;
+        if (stat(path, &st)) {
+            log_warning("could not stat(%s): %s\n", path, strerror(errno));
+            return -1;
+        }
+        mode_t xbits = S_IXUSR | S_IXGRP | S_IXOTH;
+        if (!(st.st_mode & xbits)) {
+            if (chmod(path, st.st_mode | xbits)) {
+                log_warning("could not chmod(%s, +x): %s\n", path, strerror(errno));
+                return -1;
+            }
+        }
+    }
+
+    return ret;
+}
+
+bool make_parent_dirs(String path)
+{
+    char* path_temp = strdup(path.c_str());
+    char* last_slash = strrchr(path_temp, '/');
+    char* slash = last_slash;
+    bool ret = false;
+
+    if (!last_slash) {
+        free(path_temp);
+        return ret;
+    }
+
+    // Assume most dirs exist, so scan backwards first.
+    // Avoid stat/access checks due to TOCTOU races.
+    errno = 0;
+    for (slash = last_slash; slash > path_temp; --slash) {
+        if (*slash != '/')
+            continue;
+        *slash = '\0';
+        if (mkdir_x(path_temp) == 0) {
+            // Now we can forward scan.
+            while (slash < last_slash) {
+                *slash = DIR_SEPARATOR;
+                if (mkdir_x(path_temp) < 0)
+                    // Allow EEXIST in case of someone else doing `mkdir`.
+                    if (errno != EEXIST)
+                        goto done;
+                slash += strlen(slash);
+            }
+            if (slash == last_slash)
+                ret = true;
+            break;
+        } else if (errno == EEXIST) {
+            ret = true;
+            break;
+        } else if (errno != ENOENT) {
+            break;
+        }
+    }
+
+done:
+    free(path_temp);
+    return ret;
+}
+
 bool check_path(String path, bool needDir)
 {
     int ret = 0;
@@ -202,6 +270,17 @@ time_t check_path_ex(String path, bool needDir, bool existenceUnneeded,
     return statbuf.st_mtime;
 }
 
+int stat_dir_entry(DIR *dir, struct dirent *dent, struct stat *statbuf)
+{
+    if (dent->d_type == DT_DIR)
+    {
+        memset(statbuf, 0, sizeof(struct stat));
+        statbuf->st_mode = S_IFDIR;
+        return 0;
+    }
+    return fstatat(dirfd(dir), dent->d_name, statbuf, 0);
+}
+
 bool is_executable(String path, int *err)
 {
     int ret = access(path.c_str(), R_OK | X_OK);
@@ -253,6 +332,23 @@ String find_in_path(String exec)
     return nullptr;
 }
 
+String find_helper(String installed, String name)
+{
+    if (is_executable(installed))
+        return installed;
+
+    char self[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len > 0) {
+        self[len] = '\0';
+        String exe = self;
+        String path = exe.substring(0, exe.rindex('/') + 1) + name;
+        if (is_executable(path))
+            return path;
+    }
+    return nullptr;
+}
+
 bool string_ok(String str)
 {
     if ((str == nullptr) || (str == ""))
@@ -1343,49 +1439,14 @@ String tempName(String leadPath, char *tmpl)
     return nullptr;
 }
 
-bool isTheora(String ogg_filename)
+bool isTheora(const char* header, size_t length)
 {
-    FILE *f;
-    char buffer[7];
-    f = fopen(ogg_filename.c_str(), "rb");
-
-    if (!f)
-    {
-        throw _Exception(_("Error opening ") + ogg_filename + _(" : ") + 
-                    mt_strerror(errno));
-    }
-    
-    if (fread(buffer, 1, 4, f) != 4)
-    {
-        fclose(f);
-        throw _Exception(_("Error reading ") + ogg_filename);
-    }
-
-    if (memcmp(buffer, "OggS", 4) != 0)
-    {
-        fclose(f);
+    if (length < 4 || memcmp(header, "OggS", 4) != 0)
         return false;
-    }
-
-    if (fseek(f, 28, SEEK_SET) != 0)
-    {
-        fclose(f);
-        throw _Exception(_("Incomplete file ") + ogg_filename);
-    }
-
-    if (fread(buffer, 1, 7, f) != 7)
-    {
-        fclose(f);
-        throw _Exception(_("Error reading ") + ogg_filename);
-    }
 
-    if (memcmp(buffer, "\x80theora", 7) != 0)
-    {
-        fclose(f);
+    if (length < 35 || memcmp(header + 28, "\x80theora", 7) != 0)
         return false;
-    }
 
-    fclose(f);
     return true;
 }
 
@@ -1470,48 +1531,19 @@ String getDLNAtransferHeader(String mimeType, String header)
 #endif
 
 #ifndef HAVE_FFMPEG
-String getAVIFourCC(zmm::String avi_filename)
+String getAVIFourCC(const char* header, size_t length)
 {
 #define FCC_OFFSET  0xbc
-    char *buffer;
-    FILE *f = fopen(avi_filename.c_str(), "rb");
-    if (!f)
-        throw _Exception(_("could not open file ") + avi_filename + " : " +
-                          mt_strerror(errno));
-
-    buffer = (char *)MALLOC(FCC_OFFSET+6);
-    if (buffer == nullptr)
-    {
-        fclose(f);
-        throw _Exception(_("Out of memory when allocating buffer for file ") +
-                          avi_filename);
-    }
-
-    size_t rb = fread(buffer, 1, FCC_OFFSET+4, f);
-    fclose(f);
-    if (rb != FCC_OFFSET+4)
-    {
-        free(buffer);
-        throw _Exception(_("could not read header of ") + avi_filename +  
-                          " : " + mt_strerror(errno));
-    }
-
-    buffer[FCC_OFFSET+5] = '\0';
+    if (length < FCC_OFFSET + 4)
+        return nullptr;
 
-    if (strncmp(buffer, "RIFF", 4) != 0)
-    {
-        free(buffer);
+    if (strncmp(header, "RIFF", 4) != 0)
         return nullptr;
-    }
 
-    if (strncmp(buffer+8, "AVI ", 4) != 0)
-    {
-        free(buffer);
+    if (strncmp(header + 8, "AVI ", 4) != 0)
         return nullptr;
-    }
 
-    String fourcc = String(buffer+FCC_OFFSET, 4);
-    free(buffer);
+    String fourcc = String(header + FCC_OFFSET, 4);
 
     if (string_ok(fourcc))
         return fourcc;
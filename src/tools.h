@@ -35,6 +35,8 @@
 #include <unordered_set>
 
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 #include "common.h"
 #include "rexp.h"
@@ -72,6 +74,11 @@ zmm::String trim_string(zmm::String str);
 /// \return false path of file not found 
 bool check_path(zmm::String path, bool needDir = false);
 
+/// \brief Creates the missing parent directories of a file.
+/// \param path the file, the last path component is not created
+/// \return true if the parent directory exists afterwards
+bool make_parent_dirs(zmm::String path);
+
 /// \brief Checks existance of the specified file or path.
 /// \param path file or directory to be checked.
 /// \param needDir true when checked item has to be a directory.
@@ -86,6 +93,18 @@ bool check_path(zmm::String path, bool needDir = false);
 /// needed, also the filesize.
 time_t check_path_ex(zmm::String path, bool needDir = false, bool existenceUnneeded = false, off_t *filesize = NULL);
 
+/// \brief Stats a directory entry relative to the directory stream.
+/// \param dir directory stream the entry was read from
+/// \param dent entry returned by readdir
+/// \param statbuf receives the result, follows symlinks like stat()
+/// \return 0 on success, -1 with errno set otherwise
+///
+/// Entries that d_type reports as directories are not stat'ed at all, only
+/// st_mode is filled in. Everything else, including DT_UNKNOWN which some
+/// filesystems always report, gets a single fstatat() on the directory
+/// descriptor instead of a stat() on the full path.
+int stat_dir_entry(DIR *dir, struct dirent *dent, struct stat *statbuf);
+
 /// \brief Checks if the given binary is executable by our process
 /// \param path absolute path of the binary
 /// \param err if not NULL err will contain the errno result of the check
@@ -98,6 +117,13 @@ bool is_executable(zmm::String path, int *err = NULL);
 /// \return aboslute path to the given executable or nullptr of it was not found
 zmm::String find_in_path(zmm::String exec);
 
+/// \brief Finds a helper program of the server, the installed one or the
+/// one next to the running server when it is started from the build tree.
+/// \param installed absolute path the helper is installed to
+/// \param name file name of the helper
+/// \return path of the helper or nullptr if it was not found
+zmm::String find_helper(zmm::String installed, zmm::String name);
+
 /// \brief Checks if the string contains any data.
 /// \param str String to be checked.
 /// \return true if ok
@@ -316,7 +342,9 @@ zmm::Ref<zmm::Array<zmm::StringBase> > parseCommandLine(zmm::String line,
 zmm::String tempName(zmm::String leadPath, char *tmpl);
 
 /// \brief Determines if the particular ogg file contains a video (theora)
-bool isTheora(zmm::String ogg_filename);
+/// \param header first bytes of the file
+/// \param length number of bytes in header
+bool isTheora(const char* header, size_t length);
 
 /// \brief Gets an absolute filename as a parameter and returns the last parent
 ///
@@ -336,7 +364,9 @@ zmm::String getDLNAtransferHeader(zmm::String mimeType, zmm::String header);
 ///
 /// This code is based on offsets, so we will use it only if ffmpeg is not
 /// available.
-zmm::String getAVIFourCC(zmm::String avi_filename);
+/// \param header first bytes of the file
+/// \param length number of bytes in header
+zmm::String getAVIFourCC(const char* header, size_t length);
 #endif
 
 #ifdef TOMBDEBUG
@@ -31,6 +31,8 @@
 
 #include "update_manager.h"
 
+#include "browse_cache.h"
+#include "config_manager.h"
 #include "server.h"
 #include "upnp_cds.h"
 #include "storage.h"
@@ -41,7 +43,6 @@
 #include <chrono>
 
 /* following constants in milliseconds */
-#define SPEC_INTERVAL 2000
 #define MIN_SLEEP 1
 
 #define MAX_OBJECT_IDS 1000
@@ -54,12 +55,22 @@ using namespace std;
 UpdateManager::UpdateManager() : Singleton<UpdateManager>(),
     objectIDHash(make_shared<unordered_set<int>>()),
     shutdownFlag(false), flushPolicy(FLUSH_SPEC),
-    lastContainerChanged(INVALID_OBJECT_ID)
+    lastContainerChanged(INVALID_OBJECT_ID),
+    minInterval(0), maxInterval(0), interval(0), compactThreshold(0),
+    pendingCompact(false)
 {
 }
 
 void UpdateManager::init()
 {
+    Ref<ConfigManager> cfg = ConfigManager::getInstance();
+    minInterval = cfg->getIntOption(CFG_SERVER_EVENTING_MIN_INTERVAL);
+    maxInterval = cfg->getIntOption(CFG_SERVER_EVENTING_MAX_INTERVAL);
+    if (maxInterval < minInterval)
+        maxInterval = minInterval;
+    interval = minInterval;
+    compactThreshold = cfg->getIntOption(CFG_SERVER_EVENTING_COMPACT_THRESHOLD);
+
     /*
     pthread_attr_t attr;
     pthread_attr_init(&attr);
@@ -96,6 +107,9 @@ void UpdateManager::containersChanged(Ref<IntArray> objectIDs, int flushPolicy)
 {
     if (objectIDs == nullptr)
         return;
+    Ref<BrowseCache> browseCache = BrowseCache::getInstance();
+    for (int i = 0; i < objectIDs->size(); i++)
+        browseCache->invalidate(objectIDs->get(i));
     unique_lock<mutex_type> lock(mutex);
     // signalling thread if it could have been idle, because 
     // there were no unprocessed updates
@@ -142,6 +156,9 @@ void UpdateManager::containerChanged(int objectID, int flushPolicy)
 {
     if (objectID == INVALID_OBJECT_ID)
         return;
+    // before the lastContainerChanged shortcut, every change has to
+    // reach the cache
+    BrowseCache::getInstance()->invalidate(objectID);
     AutoLock lock(mutex);
     if (objectID != lastContainerChanged || flushPolicy > this->flushPolicy)
     {
@@ -188,87 +205,140 @@ void UpdateManager::threadProc()
     //cond.notify_one();
     while (! shutdownFlag)
     {
-        if (haveUpdates())
+        bool eventPending = pendingCompact || (! pendingEvent.empty());
+        if (! haveUpdates() && ! eventPending)
         {
-            long sleepMillis = 0;
-            struct timespec now;
-            getTimespecNow(&now);
-            long timeDiff = getDeltaMillis(&lastUpdate, &now);
-            switch (flushPolicy)
-            {
-                case FLUSH_SPEC:
-                    sleepMillis = SPEC_INTERVAL - timeDiff;
-                    break;
-                case FLUSH_ASAP:
-                    sleepMillis = 0;
-                    break;
-            }
-            bool sendUpdates = true;
-            if (sleepMillis >= MIN_SLEEP && objectIDHash->size() < MAX_OBJECT_IDS)
+            //nothing to do
+            cond.wait(lock);
+            continue;
+        }
+
+        long sleepMillis = 0;
+        struct timespec now;
+        getTimespecNow(&now);
+        long timeDiff = getDeltaMillis(&lastUpdate, &now);
+        switch (flushPolicy)
+        {
+            case FLUSH_SPEC:
+                sleepMillis = interval - timeDiff;
+                break;
+            case FLUSH_ASAP:
+                sleepMillis = 0;
+                break;
+        }
+
+        if (sleepMillis >= MIN_SLEEP)
+        {
+            // the event has to wait, but the hash is kept small
+            if (objectIDHash->size() >= MAX_OBJECT_IDS)
             {
-                struct timespec timeout;
-                getTimespecAfterMillis(sleepMillis, &timeout, &now);
-                log_debug("threadProc: sleeping for %ld millis\n", sleepMillis);
-                
-                cv_status ret = cond.wait_for(lock, chrono::milliseconds(sleepMillis));
-                
-                if (! shutdownFlag)
-                {
-                    if (ret == cv_status::timeout)
-                        sendUpdates = false;
-                }
-                else
-                    sendUpdates = false;
+                flushUpdateIDs(lock);
+                continue;
             }
-            
-            if (sendUpdates)
-            {
-                log_debug("sending updates...\n");
-                lastContainerChanged = INVALID_OBJECT_ID;
-                flushPolicy = FLUSH_SPEC;
-                String updateString;
+            log_debug("threadProc: sleeping for %ld millis\n", sleepMillis);
+            cond.wait_for(lock, chrono::milliseconds(sleepMillis));
+            continue;
+        }
 
-                try
-                {
-                    updateString = Storage::getInstance()->incrementUpdateIDs(objectIDHash);
-                    objectIDHash->clear(); // hash_data_array will be invalid after clear()
-                }
-                catch (const Exception & e)
-                {
-                    e.printStackTrace();
-                    log_error("Fatal error when sending updates: %s\n", e.getMessage().c_str());
-                    log_error("Forcing MediaTomb shutdown.\n");
-                    kill(0, SIGINT);
-                }
-                lock.unlock(); // we don't need to hold the lock during the sending of the updates
-                if (string_ok(updateString))
-                {
-                    try
-                    {
-                    Server::getInstance()->send_subscription_update(updateString);
-                    log_debug("updates sent.\n");
-                    getTimespecNow(&lastUpdate);
-                    }
-                    catch (const Exception & e)
-                    {
-                        log_error("Fatal error when sending updates: %s\n", e.getMessage().c_str());
-                        log_error("Forcing MediaTomb shutdown.\n");
-                        kill(0, SIGINT);
-                    }
-                }
-                else
-                {
-                    log_debug("NOT sending updates (string empty or invalid).\n");
-                }
-                lock.lock();
-            }
+        log_debug("sending updates...\n");
+        lastContainerChanged = INVALID_OBJECT_ID;
+        flushPolicy = FLUSH_SPEC;
+        flushUpdateIDs(lock);
+
+        // back off while changes keep coming, return to the minimum once
+        // they calm down
+        if (timeDiff < 2 * interval)
+            interval = min(interval * 2, maxInterval);
+        else
+            interval = minInterval;
+
+        sendEvent(lock);
+        getTimespecNow(&lastUpdate);
+    }
+}
+
+void UpdateManager::flushUpdateIDs(unique_lock<mutex_type>& lock)
+{
+    if (! haveUpdates())
+        return;
+
+    String updateString;
+    try
+    {
+        updateString = Storage::getInstance()->incrementUpdateIDs(objectIDHash);
+        objectIDHash->clear(); // hash_data_array will be invalid after clear()
+    }
+    catch (const Exception & e)
+    {
+        e.printStackTrace();
+        log_error("Fatal error when sending updates: %s\n", e.getMessage().c_str());
+        log_error("Forcing MediaTomb shutdown.\n");
+        kill(0, SIGINT);
+        return;
+    }
+
+    if (pendingCompact || ! string_ok(updateString))
+        return;
+
+    // "id,update_id,id,update_id,..."; a container changing again before
+    // the event is sent is announced once, with its latest update ID
+    Ref<Array<StringBase> > parts = split_string(updateString, ',');
+    for (int i = 0; i + 1 < parts->size(); i += 2)
+        pendingEvent[String(parts->get(i)).toInt()] = String(parts->get(i + 1)).toInt();
+
+    if (compactThreshold > 0 && (int)pendingEvent.size() > compactThreshold)
+    {
+        log_debug("%d containers changed, sending a compact update\n", (int)pendingEvent.size());
+        pendingEvent.clear();
+        pendingCompact = true;
+    }
+}
+
+void UpdateManager::sendEvent(unique_lock<mutex_type>& lock)
+{
+    bool compact = pendingCompact;
+    Ref<StringBuffer> buf(new StringBuffer());
+    for (const auto& pending : pendingEvent)
+    {
+        if (buf->length() > 0)
+            *buf << ',';
+        *buf << pending.first << ',' << pending.second;
+    }
+    pendingEvent.clear();
+    pendingCompact = false;
+
+    lock.unlock(); // we don't need to hold the lock during the sending of the updates
+    try
+    {
+        String updateString;
+        if (compact)
+        {
+            // too many to list, the root changing tells the clients that
+            // everything may have changed
+            auto root = make_shared<unordered_set<int>>();
+            root->insert(CDS_ID_ROOT);
+            updateString = Storage::getInstance()->incrementUpdateIDs(root);
         }
         else
+            updateString = buf->toString();
+
+        if (string_ok(updateString))
         {
-            //nothing to do
-            cond.wait(lock);
+            Server::getInstance()->send_subscription_update(updateString);
+            log_debug("updates sent.\n");
         }
+        else
+        {
+            log_debug("NOT sending updates (string empty or invalid).\n");
+        }
+    }
+    catch (const Exception & e)
+    {
+        log_error("Fatal error when sending updates: %s\n", e.getMessage().c_str());
+        log_error("Forcing MediaTomb shutdown.\n");
+        kill(0, SIGINT);
     }
+    lock.lock();
 }
 
 void *UpdateManager::staticThreadProc(void *arg)
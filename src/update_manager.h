@@ -32,6 +32,7 @@
 #ifndef __UPDATE_MANAGER_H__
 #define __UPDATE_MANAGER_H__
 
+#include <map>
 #include <memory>
 #include <unordered_set>
 #include <condition_variable>
@@ -65,8 +66,23 @@ protected:
 
     int lastContainerChanged;
 
+    /// \brief moderation of the ContainerUpdateIDs event, in milliseconds
+    long minInterval;
+    long maxInterval;
+    /// \brief current interval, grows while changes keep coming
+    long interval;
+    /// \brief more containers than this are announced as a change of the
+    /// root container only
+    int compactThreshold;
+
+    /// \brief container ID -> update ID, incremented but not yet evented
+    std::map<int, int> pendingEvent;
+    bool pendingCompact;
+
     static void *staticThreadProc(void *arg);
     void threadProc();
+    void flushUpdateIDs(std::unique_lock<mutex_type>& lock);
+    void sendEvent(std::unique_lock<mutex_type>& lock);
 
     inline bool haveUpdates() { return (objectIDHash->size() > 0); }
 };
@@ -30,7 +30,10 @@
 /// \file upnp_cds.cc
 
 #include "upnp_cds.h"
+#include "browse_cache.h"
+#include "browse_prefetcher.h"
 #include "config_manager.h"
+#include "didl_fragment_store.h"
 #include "server.h"
 #include "storage.h"
 
@@ -85,38 +88,92 @@ void ContentDirectoryService::upnp_action_Browse(Ref<ActionRequest> request)
     if (ConfigManager::getInstance()->getBoolOption(CFG_SERVER_HIDE_PC_DIRECTORY))
         flag |= BROWSE_HIDE_FS_ROOT;
 
+    int startingIndex = StartingIndex.toInt();
+    int requestedCount = RequestedCount.toInt();
+
+    // renderers re-browse the same menus constantly, reuse what is
+    // still valid for the current update IDs
+    Ref<BrowseCache> cache = BrowseCache::getInstance();
+    int updateID = IS_CDS_CONTAINER(parent->getObjectType()) ? RefCast(parent, CdsContainer)->getUpdateID() : 0;
+    int currentSystemUpdateID = systemUpdateID;
+    unsigned long generation = 0;
+    std::shared_ptr<const BrowseResult> result = cache->get(objectID, flag,
+        startingIndex, requestedCount, updateID, currentSystemUpdateID, &generation);
+    if (result == nullptr) {
+        result = renderBrowse(objectID, flag, startingIndex, requestedCount);
+        cache->put(objectID, flag, startingIndex, requestedCount,
+            updateID, currentSystemUpdateID, generation, parent->getParentID(), result);
+    }
+
+    Ref<Element> response;
+    response = UpnpXML_CreateResponse(request->getActionName(), _(DESC_CDS_SERVICE_TYPE));
+
+    response->appendTextChild(_("Result"), String(result->didl.data(), result->didl.size()));
+    response->appendTextChild(_("NumberReturned"), String::from(result->numberReturned));
+    response->appendTextChild(_("TotalMatches"), String::from(result->totalMatches));
+    response->appendTextChild(_("UpdateID"), String::from(systemUpdateID));
+
+    request->setResponse(response);
+
+    // renderers page through containers, have the next page ready
+    Ref<BrowsePrefetcher> prefetcher = BrowsePrefetcher::getInstance();
+    if (prefetcher->isEnabled() && (flag & BROWSE_DIRECT_CHILDREN) && (requestedCount > 0)
+        && (startingIndex + requestedCount < result->totalMatches)) {
+        int nextIndex = startingIndex + requestedCount;
+        prefetcher->schedule(request->getClientAddress(), objectID, flag,
+            nextIndex, requestedCount, updateID, currentSystemUpdateID, parent->getParentID(),
+            [this, objectID, flag, nextIndex, requestedCount]() {
+                return renderBrowse(objectID, flag, nextIndex, requestedCount);
+            });
+    }
+    log_debug("end\n");
+}
+
+std::shared_ptr<const BrowseResult> ContentDirectoryService::renderBrowse(int objectID,
+    unsigned int flag, int startingIndex, int requestedCount)
+{
+    Ref<Storage> storage = Storage::getInstance();
     Ref<BrowseParam> param(new BrowseParam(objectID, flag));
 
-    param->setStartingIndex(StartingIndex.toInt());
-    param->setRequestedCount(RequestedCount.toInt());
+    param->setStartingIndex(startingIndex);
+    param->setRequestedCount(requestedCount);
 
     Ref<Array<CdsObject>> arr;
 
+    // objects changing after this point do not get their fragment stored
+    Ref<DidlFragmentStore> fragments = DidlFragmentStore::getInstance();
+    unsigned long generation = fragments->getGeneration();
+
     try {
         arr = storage->browse(param);
     } catch (const Exception& e) {
         throw UpnpException(UPNP_E_NO_SUCH_ID, _("no such object"));
     }
 
-    Ref<Element> didl_lite(new Element(_("DIDL-Lite")));
-    didl_lite->setAttribute(_(XML_NAMESPACE_ATTR),
+    // serialized directly, without building an element tree per object
+    DidlWriter& didl_lite = DidlWriter::getThreadWriter();
+    didl_lite.startElement(_("DIDL-Lite"));
+    didl_lite.attribute(_(XML_NAMESPACE_ATTR),
         _(XML_DIDL_LITE_NAMESPACE));
-    didl_lite->setAttribute(_(XML_DC_NAMESPACE_ATTR),
+    didl_lite.attribute(_(XML_DC_NAMESPACE_ATTR),
         _(XML_DC_NAMESPACE));
-    didl_lite->setAttribute(_(XML_UPNP_NAMESPACE_ATTR),
+    didl_lite.attribute(_(XML_UPNP_NAMESPACE_ATTR),
         _(XML_UPNP_NAMESPACE));
 
     Ref<ConfigManager> cfg = ConfigManager::getInstance();
 
 #ifdef EXTEND_PROTOCOLINFO
     if (cfg->getBoolOption(CFG_SERVER_EXTEND_PROTOCOLINFO_SM_HACK)) {
-        didl_lite->setAttribute(_(XML_SEC_NAMESPACE_ATTR),
+        didl_lite.attribute(_(XML_SEC_NAMESPACE_ATTR),
             _(XML_SEC_NAMESPACE));
     }
 #endif
 
     for (int i = 0; i < arr->size(); i++) {
         Ref<CdsObject> obj = arr->get(i);
+        if (fragments->append(obj, stringLimit, didl_lite))
+            continue;
+
         if (cfg->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED) && obj->getFlag(OBJECT_FLAG_PLAYED)) {
             String title = obj->getTitle();
             if (cfg->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING_MODE_PREPEND))
@@ -127,21 +184,18 @@ void ContentDirectoryService::upnp_action_Browse(Ref<ActionRequest> request)
             obj->setTitle(title);
         }
 
-        Ref<Element> didl_object = UpnpXML_DIDLRenderObject(obj, false, stringLimit);
-
-        didl_lite->appendElementChild(didl_object);
+        size_t start = didl_lite.mark();
+        UpnpXML_DIDLRenderObject(obj, didl_lite, false, stringLimit);
+        if (fragments->isEnabled())
+            fragments->put(obj, stringLimit, generation, didl_lite.str().substr(start));
     }
+    didl_lite.endElement();
 
-    Ref<Element> response;
-    response = UpnpXML_CreateResponse(request->getActionName(), _(DESC_CDS_SERVICE_TYPE));
-
-    response->appendTextChild(_("Result"), didl_lite->print());
-    response->appendTextChild(_("NumberReturned"), String::from(arr->size()));
-    response->appendTextChild(_("TotalMatches"), String::from(param->getTotalMatches()));
-    response->appendTextChild(_("UpdateID"), String::from(systemUpdateID));
-
-    request->setResponse(response);
-    log_debug("end\n");
+    auto result = std::make_shared<BrowseResult>();
+    result->didl = didl_lite.str();
+    result->numberReturned = arr->size();
+    result->totalMatches = param->getTotalMatches();
+    return result;
 }
 
 void ContentDirectoryService::upnp_action_GetSearchCapabilities(Ref<ActionRequest> request)
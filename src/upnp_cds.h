@@ -32,11 +32,15 @@
 #ifndef __UPNP_CDS_H__
 #define __UPNP_CDS_H__
 
+#include <memory>
+
 #include "action_request.h"
 #include "common.h"
 #include "singleton.h"
 #include "subscription_request.h"
 
+struct BrowseResult;
+
 /// \brief This class is responsible for the UPnP Content Directory Service operations.
 ///
 /// Handles subscription and action invocation requests for the CDS.
@@ -62,6 +66,11 @@ protected:
     /// ui4 TotalMatches, ui4 UpdateID)
     void upnp_action_Browse(zmm::Ref<ActionRequest> request);
 
+    /// \brief Queries the storage and renders the DIDL-Lite for a Browse
+    /// that missed the BrowseCache.
+    std::shared_ptr<const BrowseResult> renderBrowse(int objectID,
+        unsigned int flag, int startingIndex, int requestedCount);
+
     /// \brief UPnP standard defined action: GetSearchCapabilities()
     /// \param request Incoming ActionRequest.
     ///
@@ -50,11 +50,31 @@ Ref<Element> UpnpXML_CreateResponse(String actionName, String serviceType)
 
 Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, int stringLimit)
 {
-    Ref<Element> result(new Element(_("")));
-    
-    result->setAttribute(_("id"), String::from(obj->getID()));
-    result->setAttribute(_("parentID"), String::from(obj->getParentID()));
-    result->setAttribute(_("restricted"), obj->isRestricted() ? _("1") : _("0"));
+    DidlElementBuilder builder;
+    UpnpXML_DIDLRenderObject(obj, builder, renderActions, stringLimit);
+    return builder.getRoot();
+}
+
+void UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, DidlSink& result, bool renderActions, int stringLimit)
+{
+    int objectType = obj->getObjectType();
+    if (IS_CDS_ITEM(objectType))
+        result.startElement(_("item"));
+    else if (IS_CDS_CONTAINER(objectType))
+        result.startElement(_("container"));
+    else
+        result.startElement(_(""));
+
+    result.attribute(_("id"), String::from(obj->getID()));
+    result.attribute(_("parentID"), String::from(obj->getParentID()));
+    result.attribute(_("restricted"), obj->isRestricted() ? _("1") : _("0"));
+
+    if (IS_CDS_CONTAINER(objectType))
+    {
+        int childCount = RefCast(obj, CdsContainer)->getChildCount();
+        if (childCount >= 0)
+            result.attribute(_("childCount"), String::from(childCount));
+    }
    
     String tmp = obj->getTitle();
 
@@ -64,11 +84,10 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
         tmp = tmp + _("...");
     }
    
-    result->appendTextChild(_("dc:title"), tmp);
+    result.textElement(_("dc:title"), tmp);
     
-    result->appendTextChild(_("upnp:class"), obj->getClass());
+    result.textElement(_("upnp:class"), obj->getClass());
     
-    int objectType = obj->getObjectType();
     if (IS_CDS_ITEM(objectType))
     {
         Ref<CdsItem> item = RefCast(obj, CdsItem);
@@ -93,17 +112,17 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
                             getValidUTF8CutPosition(tmp, stringLimit-3));
                     tmp = tmp + _("...");
                 }
-                result->appendTextChild(key, tmp);
+                result.textElement(key, tmp);
             }
             else if (key == MetadataHandler::getMetaFieldName(M_TRACKNUMBER))
             {
                 if (upnp_class == UPNP_DEFAULT_CLASS_MUSIC_TRACK)
-                    result->appendTextChild(key, el->getValue());
+                    result.textElement(key, el->getValue());
             }
             else if ((key != MetadataHandler::getMetaFieldName(M_TITLE)) || 
                     ((key == MetadataHandler::getMetaFieldName(M_TRACKNUMBER)) && 
                      (upnp_class == UPNP_DEFAULT_CLASS_MUSIC_TRACK)))
-                result->appendTextChild(key, el->getValue());
+                result.textElement(key, el->getValue());
         }
 
         CdsResourceManager::addResources(item, result);
@@ -117,12 +136,15 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
             int doti = dctl.rindex('.');
             if (doti>=0) {
                 trackArtBase = dctl.substring(0, doti);
-            } 
-            String aa_id = storage->findFolderImage(item->getParentID(), trackArtBase);
-            if (aa_id != nullptr) {
+            }
+            // resolved by the storage when the image or the track was added
+            int aa_id = storage->getTrackArt(item->getParentID(), trackArtBase);
+            if (aa_id == INVALID_OBJECT_ID)
+                aa_id = storage->getFolderArt(item->getParentID());
+            if (aa_id != INVALID_OBJECT_ID) {
                 String url;
                 Ref<Dictionary> dict(new Dictionary());
-                dict->put(_(URL_OBJECT_ID), aa_id);
+                dict->put(_(URL_OBJECT_ID), String::from(aa_id));
 
                 url = Server::getInstance()->getVirtualURL() +
                         _(_URL_PARAM_SEPARATOR) +
@@ -130,21 +152,13 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
                         dict->encodeSimple() + _(_URL_PARAM_SEPARATOR) +
                         _(URL_RESOURCE_ID) + _(_URL_PARAM_SEPARATOR) + "0";
                 log_debug("UpnpXML_DIDLRenderObject: url: %s\n", url.c_str());
-                Ref<Element> aa(new Element(MetadataHandler::getMetaFieldName(M_ALBUMARTURI)));
-                aa->setText(url);
-                result->appendElementChild(aa);
+                result.textElement(MetadataHandler::getMetaFieldName(M_ALBUMARTURI), url);
             }
         }
-        result->setName(_("item"));
     }
     else if (IS_CDS_CONTAINER(objectType))
     {
         Ref<CdsContainer> cont = RefCast(obj, CdsContainer);
-        
-        result->setName(_("container"));
-        int childCount = cont->getChildCount();
-        if (childCount >= 0)
-            result->setAttribute(_("childCount"), String::from(childCount));
 
         String upnp_class = obj->getClass();
         log_debug("container is class: %s\n", upnp_class.c_str());
@@ -157,19 +171,27 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
             }
 
             if (string_ok(creator)) {
-                result->appendElementChild(UpnpXML_DIDLRenderCreator(creator));
+                UpnpXML_DIDLRenderCreator(result, creator);
             }
         }
         if (upnp_class == UPNP_DEFAULT_CLASS_MUSIC_ALBUM || upnp_class == UPNP_DEFAULT_CLASS_CONTAINER) {
             Ref<Storage> storage = Storage::getInstance();
-            String aa_id = storage->findFolderImage(cont->getID(), String());
-
-            if (aa_id != nullptr) {
+            // resolved by the storage when the image or the album tracks
+            // were added, the storage also knows which art is an image
+            int aa_id = storage->getFolderArt(cont->getID());
+            int track_id = cont->getArtObjectID();
+
+            if (aa_id == INVALID_OBJECT_ID && track_id != INVALID_OBJECT_ID
+                && upnp_class == UPNP_DEFAULT_CLASS_MUSIC_ALBUM) {
+                // albums may point to a track with embedded art instead of an image
+                String url = CdsResourceManager::getArtworkUrl(track_id);
+                UpnpXML_DIDLRenderAlbumArtURI(result, url);
+            } else if (aa_id != INVALID_OBJECT_ID) {
                 log_debug("Using folder image as artwork for container\n");
 
                 String url;
                 Ref<Dictionary> dict(new Dictionary());
-                dict->put(_(URL_OBJECT_ID), aa_id);
+                dict->put(_(URL_OBJECT_ID), String::from(aa_id));
 
                 url = Server::getInstance()->getVirtualURL() +
                     _(_URL_PARAM_SEPARATOR) +
@@ -177,7 +199,7 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
                     dict->encodeSimple() + _(_URL_PARAM_SEPARATOR) +
                     _(URL_RESOURCE_ID) + _(_URL_PARAM_SEPARATOR) + "0";
 
-                result->appendElementChild(UpnpXML_DIDLRenderAlbumArtURI(url));
+                UpnpXML_DIDLRenderAlbumArtURI(result, url);
 
             } else if (upnp_class == UPNP_DEFAULT_CLASS_MUSIC_ALBUM) {
                 // try to find the first track and use its artwork
@@ -207,7 +229,7 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
                                 (res->getHandlerType() == CH_EXTURL)) {
 
                                 String url = CdsResourceManager::getArtworkUrl(item);
-                                result->appendElementChild(UpnpXML_DIDLRenderAlbumArtURI(url));
+                                UpnpXML_DIDLRenderAlbumArtURI(result, url);
 
                                 artAdded = true;
                                 break;
@@ -224,15 +246,13 @@ Ref<Element> UpnpXML_DIDLRenderObject(Ref<CdsObject> obj, bool renderActions, in
     if (renderActions && IS_CDS_ACTIVE_ITEM(objectType))
     {
         Ref<CdsActiveItem> aitem = RefCast(obj, CdsActiveItem);
-        result->appendTextChild(_("action"), aitem->getAction());
-        result->appendTextChild(_("state"), aitem->getState());
-        result->appendTextChild(_("location"), aitem->getLocation());
-        result->appendTextChild(_("mime-type"), aitem->getMimeType());
+        result.textElement(_("action"), aitem->getAction());
+        result.textElement(_("state"), aitem->getState());
+        result.textElement(_("location"), aitem->getLocation());
+        result.textElement(_("mime-type"), aitem->getMimeType());
     }
    
-    // log_debug("Rendered DIDL: \n%s\n", result->print().c_str());
-
-    return result;
+    result.endElement();
 }
 
 void UpnpXML_DIDLUpdateObject(Ref<CdsObject> obj, String text)
@@ -452,11 +472,9 @@ Ref<Element> UpnpXML_RenderDeviceDescription(String presentationURL)
     return root;
 }
 
-Ref<Element> UpnpXML_DIDLRenderResource(String URL, Ref<Dictionary> attributes)
+void UpnpXML_DIDLRenderResource(DidlSink& sink, String URL, Ref<Dictionary> attributes)
 {
-    Ref<Element> res(new Element(_("res")));
-
-    res->setText(URL);
+    sink.startElement(_("res"));
 
     Ref<Array<DictionaryElement> > elements = attributes->getElements();
     int len = elements->size();
@@ -467,14 +485,16 @@ Ref<Element> UpnpXML_DIDLRenderResource(String URL, Ref<Dictionary> attributes)
     {
         Ref<DictionaryElement> el = elements->get(i);
         attribute = el->getKey();
-        res->setAttribute(attribute, el->getValue());
+        sink.attribute(attribute, el->getValue());
     }
 
-    return res;
+    sink.text(URL);
+    sink.endElement();
 }
 
-Ref<Element> UpnpXML_DIDLRenderCaptionInfo(String URL) {
-    Ref<Element> cap(new Element(_("sec:CaptionInfoEx")));
+void UpnpXML_DIDLRenderCaptionInfo(DidlSink& sink, String URL) {
+    sink.startElement(_("sec:CaptionInfoEx"));
+    sink.attribute(_("sec:type"), _("srt"));
 
     // Samsung DLNA clients don't follow this URL and
     // obtain subtitle location from video HTTP headers.
@@ -484,22 +504,18 @@ Ref<Element> UpnpXML_DIDLRenderCaptionInfo(String URL) {
     // though it's necessary.
 
     int endp = URL.rindex('.');
-    cap->setText(URL.substring(0, endp) + ".srt");
-    cap->setAttribute(_("sec:type"), _("srt"));
-
-    return cap;
+    sink.text(URL.substring(0, endp) + ".srt");
+    sink.endElement();
 }
 
-Ref<Element> UpnpXML_DIDLRenderCreator(String creator) {
-    Ref<Element> out(new Element(_("dc:creator")));
-
-    out->setText(creator);
-
-    return out;
+void UpnpXML_DIDLRenderCreator(DidlSink& sink, String creator) {
+    sink.startElement(_("dc:creator"));
+    sink.text(creator);
+    sink.endElement();
 }
 
-Ref<Element> UpnpXML_DIDLRenderAlbumArtURI(String uri) {
-    Ref<Element> out(new Element(_("upnp:albumArtURI")));
-    out->setText(uri);
-    return out;
+void UpnpXML_DIDLRenderAlbumArtURI(DidlSink& sink, String uri) {
+    sink.startElement(_("upnp:albumArtURI"));
+    sink.text(uri);
+    sink.endElement();
 }
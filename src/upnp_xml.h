@@ -35,6 +35,7 @@
 #include "common.h"
 #include "mxml/mxml.h"
 #include "cds_objects.h"
+#include "didl_writer.h"
 
 /// \brief Renders XML for the action response header.
 /// \param actionName Name of the action.
@@ -58,6 +59,14 @@ zmm::Ref<mxml::Element> UpnpXML_CreateResponse(zmm::String actionName, zmm::Stri
 /// providing the XML representation of an active item to a trigger/toggle script.
 zmm::Ref<mxml::Element> UpnpXML_DIDLRenderObject(zmm::Ref<CdsObject> obj, bool renderActions = false, int stringLimit = -1);
 
+/// \brief Renders the DIDL-Lite representation of an object into a sink.
+/// \param obj Object to be rendered.
+/// \param sink Receives the item or container element.
+/// \param renderActions If true, also render special elements of an active item.
+///
+/// Browse passes a DidlWriter and so skips building the element tree.
+void UpnpXML_DIDLRenderObject(zmm::Ref<CdsObject> obj, DidlSink& sink, bool renderActions = false, int stringLimit = -1);
+
 /// \todo change the text string to element, parsing should be done outside
 void UpnpXML_DIDLUpdateObject(zmm::Ref<CdsObject> obj, zmm::String text);
 
@@ -73,15 +82,17 @@ zmm::Ref<mxml::Element> UpnpXML_CreateEventPropertySet();
 zmm::Ref<mxml::Element> UpnpXML_RenderDeviceDescription(zmm::String presentationUTL = nullptr);
 
 /// \brief Renders a resource tag (part of DIDL-Lite XML)
+/// \param sink receives the <res> tag
 /// \param URL download location of the item (will be child element of the <res> tag)
 /// \param attributes Dictionary containing the <res> tag attributes (like resolution, etc.)
-zmm::Ref<mxml::Element> UpnpXML_DIDLRenderResource(zmm::String URL, zmm::Ref<Dictionary> attributes);
+void UpnpXML_DIDLRenderResource(DidlSink& sink, zmm::String URL, zmm::Ref<Dictionary> attributes);
 
 /// \brief Renders a subtitle resource tag (Samsung proprietary extension)
+/// \param sink receives the tag
 /// \param URL download location of the video item
-zmm::Ref<mxml::Element> UpnpXML_DIDLRenderCaptionInfo(zmm::String URL);
+void UpnpXML_DIDLRenderCaptionInfo(DidlSink& sink, zmm::String URL);
 
-zmm::Ref<mxml::Element> UpnpXML_DIDLRenderCreator(zmm::String creator);
+void UpnpXML_DIDLRenderCreator(DidlSink& sink, zmm::String creator);
 
-zmm::Ref<mxml::Element> UpnpXML_DIDLRenderAlbumArtURI(zmm::String uri);
+void UpnpXML_DIDLRenderAlbumArtURI(DidlSink& sink, zmm::String uri);
 #endif // __UPNP_XML_H__
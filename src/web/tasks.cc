@@ -32,6 +32,11 @@
 #include "pages.h"
 #include "common.h"
 #include "content_manager.h"
+#include "browse_cache.h"
+#include "storage.h"
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+#include "thumbnail_service.h"
+#endif
 
 using namespace zmm;
 using namespace mxml;
@@ -58,6 +63,41 @@ void web::tasks::process()
             appendTask(tasksEl, taskList->get(i));
         }
     }
+    else if (action == "stats")
+    {
+        Ref<Element> statsEl (new Element(_("stats")));
+        root->appendElementChild(statsEl);
+
+        Ref<BrowseCache> browseCache = BrowseCache::getInstance();
+        long hits = browseCache->getHits();
+        long misses = browseCache->getMisses();
+        Ref<Element> cacheEl (new Element(_("browse-cache")));
+        cacheEl->setAttribute(_("enabled"), browseCache->isEnabled() ? _("1") : _("0"), mxml_bool_type);
+        cacheEl->setAttribute(_("hits"), String::from(hits), mxml_int_type);
+        cacheEl->setAttribute(_("misses"), String::from(misses), mxml_int_type);
+        cacheEl->setAttribute(_("hit-rate"), String::from((hits + misses) > 0 ? (hits * 100) / (hits + misses) : 0), mxml_int_type);
+        statsEl->appendElementChild(cacheEl);
+
+        long loadQueries, loadCoalesced, browseQueries, browseCoalesced;
+        Storage::getInstance()->getQueryStats(&loadQueries, &loadCoalesced,
+            &browseQueries, &browseCoalesced);
+        Ref<Element> queriesEl (new Element(_("queries")));
+        queriesEl->setAttribute(_("load"), String::from(loadQueries), mxml_int_type);
+        queriesEl->setAttribute(_("load-coalesced"), String::from(loadCoalesced), mxml_int_type);
+        queriesEl->setAttribute(_("browse"), String::from(browseQueries), mxml_int_type);
+        queriesEl->setAttribute(_("browse-coalesced"), String::from(browseCoalesced), mxml_int_type);
+        statsEl->appendElementChild(queriesEl);
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+        Ref<ThumbnailService> thumbs = ThumbnailService::getInstance();
+        Ref<Element> thumbsEl (new Element(_("thumbnails")));
+        thumbsEl->setAttribute(_("backlog"), String::from(thumbs->getBacklog()), mxml_int_type);
+        thumbsEl->setAttribute(_("running"), String::from(thumbs->getRunning()), mxml_int_type);
+        thumbsEl->setAttribute(_("generated"), String::from(thumbs->getGenerated()), mxml_int_type);
+        thumbsEl->setAttribute(_("up-to-date"), String::from(thumbs->getSkipped()), mxml_int_type);
+        thumbsEl->setAttribute(_("failed"), String::from(thumbs->getFailed()), mxml_int_type);
+        statsEl->appendElementChild(thumbsEl);
+#endif
+    }
     else if (action == "cancel")
     {
         int taskID = intParam(_("task_id"));